@@ -0,0 +1,152 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "DeviceConfig.h"
+#include "constants.h"
+
+namespace
+{
+    // How key mapping used to work: a map of per-port key vectors, with
+    // std::out_of_range thrown for ports the device doesn't have.
+    class MapBasedKeyMapping
+    {
+    public:
+        explicit MapBasedKeyMapping(const Cedrus::DeviceConfig & config)
+        {
+            for (unsigned int i = 0; i < config.GetNumberOfPorts(); ++i)
+            {
+                const Cedrus::DevicePort * port = config.GetPortPtrByIndex(i);
+                m_keyMaps.emplace(port->portNumber,
+                    std::vector<int>(port->keyMap, port->keyMap + port->keyMapSize));
+            }
+        }
+
+        int GetMappedKey(int port, int key) const
+        {
+            try
+            {
+                const std::vector<int> & key_map = m_keyMaps.at(port);
+                if (key < static_cast<int>(key_map.size()))
+                    return key_map.at(key);
+            }
+            catch (std::out_of_range &)
+            {
+            }
+
+            return key;
+        }
+
+    private:
+        std::map<int, std::vector<int> > m_keyMaps;
+    };
+
+    enum { NUM_SAMPLE_BYTES = 4096 };
+    enum { NUM_PASSES = 200 };
+
+    // The second byte of an XID packet: port in the low nibble, key in the top 3 bits.
+    std::vector<unsigned char> SamplePortAndKeyBytes()
+    {
+        std::vector<unsigned char> bytes;
+        unsigned int state = 12345;
+
+        for (int i = 0; i < NUM_SAMPLE_BYTES; ++i)
+        {
+            state = state * 1103515245 + 12345;
+            const unsigned int port = (state >> 16) % 3;
+            const unsigned int key = (state >> 20) & 0x07;
+            bytes.push_back(static_cast<unsigned char>((key << 5) | port));
+        }
+
+        return bytes;
+    }
+
+    template <class Mapping>
+    double NanosecondsPerLookup(const Mapping & mapping, const std::vector<unsigned char> & bytes, long long & checksum)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int pass = 0; pass < NUM_PASSES; ++pass)
+        {
+            for (unsigned char port_and_key : bytes)
+                checksum += mapping.GetMappedKey(port_and_key & 0x0F, port_and_key >> 5);
+        }
+
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / (static_cast<double>(NUM_PASSES) * bytes.size());
+    }
+}
+
+// Every built-in config must map every port and key exactly as the old code did.
+TEST( BenchmarkKeyMapping, LookupTableMatchesMapBasedMapping )
+{
+    for (unsigned int i = 0; i < Cedrus::DeviceConfig::BuiltInConfigCount(); ++i)
+    {
+        const Cedrus::DeviceConfig & config = Cedrus::DeviceConfig::BuiltInConfigAtIndex(i);
+        const MapBasedKeyMapping old_mapping(config);
+
+        for (int port = -1; port <= 20; ++port)
+        {
+            for (int key = -1; key <= 20; ++key)
+            {
+                EXPECT_EQ( old_mapping.GetMappedKey(port, key), config.GetMappedKey(port, key) )
+                    << config.GetDeviceName() << " port " << port << " key " << key;
+            }
+        }
+    }
+}
+
+// RB-840 traffic on ports 0-2. Port 1 doesn't exist on an RB, which is
+// what used to send the old lookup down its exception path.
+TEST( BenchmarkKeyMapping, LookupTableVersusMapBasedMapping )
+{
+    const Cedrus::DeviceConfig & rb840 = Cedrus::DeviceConfig::FindBuiltInConfig(Cedrus::RB, Cedrus::RB_840, 2);
+    ASSERT_TRUE( rb840.DoesConfigMatchDevice(Cedrus::RB, Cedrus::RB_840, 2) );
+
+    const MapBasedKeyMapping old_mapping(rb840);
+    const std::vector<unsigned char> bytes = SamplePortAndKeyBytes();
+
+    long long old_checksum = 0;
+    long long new_checksum = 0;
+    const double old_ns = NanosecondsPerLookup(old_mapping, bytes, old_checksum);
+    const double new_ns = NanosecondsPerLookup(rb840, bytes, new_checksum);
+
+    EXPECT_EQ( old_checksum, new_checksum );
+
+    std::printf("key mapping: map + exceptions %.2f ns/lookup, lookup table %.2f ns/lookup\n", old_ns, new_ns);
+}
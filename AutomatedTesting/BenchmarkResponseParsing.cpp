@@ -0,0 +1,329 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+using namespace ResponseTestHelpers;
+
+namespace
+{
+    enum { NUM_LINES = 16 };
+    enum { POLL_INTERVAL_US = 1000 };
+
+    // ST2 packets straight out of a flat buffer, picked either through a
+    // std::function as ResponseManager used to, or by a direct call the
+    // compiler can inline, as its decoder policies are now. Only the
+    // dispatch differs between the two.
+    class FlatST2Parser
+    {
+    public:
+        explicit FlatST2Parser(const std::vector<unsigned char> & bytes)
+            : m_begin(bytes.data()),
+              m_next(bytes.data()),
+              m_end(bytes.data() + bytes.size()),
+              m_function(std::bind(&FlatST2Parser::Decode, this, std::placeholders::_1))
+        {
+        }
+
+        bool Decode(Cedrus::Response & res)
+        {
+            if (m_end - m_next < ST2_PACKET_SIZE)
+                return false;
+
+            res.port = m_next[1];
+            res.key = m_next[2];
+            res.wasPressed = m_next[3] == '1';
+            res.extendedReactionTime = m_next[4] | (m_next[5] << 8) | (m_next[6] << 16);
+            m_next += ST2_PACKET_SIZE;
+
+            return true;
+        }
+
+        long long SumThroughFunction()
+        {
+            m_next = m_begin;
+
+            long long sum = 0;
+            Cedrus::Response res;
+            while (m_function(res))
+                sum += res.key + res.extendedReactionTime;
+
+            return sum;
+        }
+
+        long long SumThroughDirectCall()
+        {
+            m_next = m_begin;
+
+            long long sum = 0;
+            Cedrus::Response res;
+            while (Decode(res))
+                sum += res.key + res.extendedReactionTime;
+
+            return sum;
+        }
+
+    private:
+        const unsigned char * m_begin;
+        const unsigned char * m_next;
+        const unsigned char * m_end;
+        std::function<bool (Cedrus::Response &)> m_function;
+    };
+
+    // Every line of an ST2 going on and then off, all arriving before the
+    // next poll.
+    std::vector<unsigned char> BurstOfPresses()
+    {
+        std::vector<unsigned char> bytes;
+
+        for (int pressed = 1; pressed >= 0; --pressed)
+        {
+            for (int line = 0; line < NUM_LINES; ++line)
+                AppendST2Packet(bytes, 0, line, pressed != 0, line);
+        }
+
+        return bytes;
+    }
+
+    struct BurstLatency
+    {
+        unsigned int polls;
+        double meanAddedUs;
+        double maxAddedUs;
+    };
+
+    // Polls at 1 kHz until the burst is drained, reading at most
+    // bytesPerPoll each time. Added latency is how many polls after the
+    // first one a response had to wait.
+    BurstLatency DrainBurst(const std::vector<unsigned char> & burst, unsigned int bytesPerPoll)
+    {
+        Cedrus::ResponseManager manager(StimTrackerQuad());
+
+        BurstLatency latency = { 0, 0.0, 0.0 };
+        unsigned int responses = 0;
+        double total_added_us = 0;
+
+        for (size_t offset = 0; offset < burst.size(); offset += bytesPerPoll)
+        {
+            const unsigned int count = static_cast<unsigned int>(std::min<size_t>(bytesPerPoll, burst.size() - offset));
+            manager.FeedInput(&burst[offset], count);
+
+            while (manager.HasQueuedResponses())
+            {
+                manager.GetNextResponse();
+                total_added_us += latency.polls * POLL_INTERVAL_US;
+                latency.maxAddedUs = latency.polls * POLL_INTERVAL_US;
+                ++responses;
+            }
+
+            ++latency.polls;
+        }
+
+        latency.meanAddedUs = responses > 0 ? total_added_us / responses : 0;
+
+        return latency;
+    }
+}
+
+// The old CheckForKeypress read at most one packet per poll.
+TEST( BenchmarkResponseParsing, BurstLatencyOnePacketPerPollVersusStreaming )
+{
+    const std::vector<unsigned char> burst = BurstOfPresses();
+
+    const BurstLatency one_packet = DrainBurst(burst, ST2_PACKET_SIZE);
+    const BurstLatency streaming = DrainBurst(burst, static_cast<unsigned int>(burst.size()));
+
+    EXPECT_EQ( 2u * NUM_LINES, one_packet.polls );
+    EXPECT_EQ( 1u, streaming.polls );
+    EXPECT_EQ( 0.0, streaming.maxAddedUs );
+
+    std::printf("%d-packet burst at 1 kHz: one packet per poll takes %u polls (mean +%.0f us, max +%.0f us), streaming takes %u (max +%.0f us)\n",
+        2 * NUM_LINES, one_packet.polls, one_packet.meanAddedUs, one_packet.maxAddedUs, streaming.polls, streaming.maxAddedUs);
+}
+
+TEST( BenchmarkResponseParsing, StreamingThroughput )
+{
+    enum { NUM_PASSES = 2000 };
+
+    const std::vector<unsigned char> burst = BurstOfPresses();
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    unsigned int responses = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        manager.FeedInput(burst.data(), static_cast<unsigned int>(burst.size()));
+
+        while (manager.HasQueuedResponses())
+        {
+            manager.GetNextResponse();
+            ++responses;
+        }
+    }
+
+    const double elapsed_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+    EXPECT_EQ( 2u * NUM_LINES * NUM_PASSES, responses );
+
+    std::printf("streaming parser: %.1f ns/packet, %.1f MB/s\n",
+        elapsed_ns / responses, (responses * ST2_PACKET_SIZE) / (elapsed_ns / 1e9) / 1e6);
+}
+
+// Draining only: a full queue taken one at a time versus in batches.
+TEST( BenchmarkResponseParsing, DrainOneAtATimeVersusBatched )
+{
+    enum { NUM_PASSES = 500 };
+    enum { BATCH_SIZE = 256 };
+
+    std::vector<unsigned char> bytes;
+    for (int i = 0; i < 16; ++i)
+    {
+        const std::vector<unsigned char> burst = BurstOfPresses();
+        bytes.insert(bytes.end(), burst.begin(), burst.end());
+    }
+    const unsigned int per_pass = 16 * 2 * NUM_LINES;
+
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+    std::chrono::nanoseconds single_elapsed(0);
+    std::chrono::nanoseconds batch_elapsed(0);
+    unsigned long long single_sum = 0;
+    unsigned long long batch_sum = 0;
+
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (manager.HasQueuedResponses())
+            single_sum += manager.GetNextResponse().key;
+        single_elapsed += std::chrono::steady_clock::now() - start;
+
+        manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+        Cedrus::Response batch[BATCH_SIZE];
+        size_t count;
+        start = std::chrono::steady_clock::now();
+        while ((count = manager.GetResponses(batch, BATCH_SIZE)) > 0)
+        {
+            for (size_t i = 0; i < count; ++i)
+                batch_sum += batch[i].key;
+        }
+        batch_elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    EXPECT_EQ( single_sum, batch_sum );
+
+    const double responses = static_cast<double>(per_pass) * NUM_PASSES;
+    std::printf("draining %u-response queues: one at a time %.1f M responses/s, batched %.1f M responses/s (%u-byte Response)\n",
+        per_pass, responses / single_elapsed.count() * 1e3, responses / batch_elapsed.count() * 1e3,
+        static_cast<unsigned int>(sizeof(Cedrus::Response)));
+}
+
+TEST( BenchmarkResponseParsing, FunctionDispatchVersusInlinedDecoder )
+{
+    enum { NUM_PASSES = 2000 };
+
+    std::vector<unsigned char> bytes;
+    for (int i = 0; i < 16; ++i)
+    {
+        const std::vector<unsigned char> burst = BurstOfPresses();
+        bytes.insert(bytes.end(), burst.begin(), burst.end());
+    }
+    const double packets = static_cast<double>(bytes.size() / ST2_PACKET_SIZE) * NUM_PASSES;
+
+    FlatST2Parser parser(bytes);
+    long long function_sum = 0;
+    long long direct_sum = 0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+        function_sum += parser.SumThroughFunction();
+    const std::chrono::duration<double> function_elapsed = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+        direct_sum += parser.SumThroughDirectCall();
+    const std::chrono::duration<double> direct_elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ( function_sum, direct_sum );
+
+    std::printf("ST2 decode: std::function dispatch %.1f M packets/s, inlined decoder %.1f M packets/s\n",
+        packets / function_elapsed.count() / 1e6, packets / direct_elapsed.count() / 1e6);
+}
+
+TEST( BenchmarkResponseParsing, LatencyTrackingOverhead )
+{
+    enum { NUM_PASSES = 2000 };
+    enum { BATCH_SIZE = 64 };
+
+    const std::vector<unsigned char> burst = BurstOfPresses();
+    double ns_per_packet[2];
+
+    for (int tracking = 0; tracking < 2; ++tracking)
+    {
+        Cedrus::ResponseManager manager(StimTrackerQuad());
+        manager.EnableLatencyTracking(tracking != 0);
+
+        unsigned int responses = 0;
+        Cedrus::Response batch[BATCH_SIZE];
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for (int pass = 0; pass < NUM_PASSES; ++pass)
+        {
+            manager.FeedInput(burst.data(), static_cast<unsigned int>(burst.size()));
+
+            size_t count;
+            while ((count = manager.GetResponses(batch, BATCH_SIZE)) > 0)
+                responses += static_cast<unsigned int>(count);
+        }
+
+        ns_per_packet[tracking] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / responses;
+
+        EXPECT_EQ( 2u * NUM_LINES * NUM_PASSES, responses );
+        EXPECT_EQ( tracking ? responses : 0u, manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_DEQUEUED).GetCount() );
+    }
+
+    std::printf("parse and drain: %.1f ns/packet untracked, %.1f ns/packet with latency tracking\n",
+        ns_per_packet[0], ns_per_packet[1]);
+}
@@ -0,0 +1,82 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// libFuzzer target for the response parser. It isn't part of TestXidLib;
+// build it with clang, e.g. through cmake -DXID_BUILD_FUZZERS=ON, and run
+//
+//     fuzz_response_parser -max_len=1024 corpus/
+//
+// AddressSanitizer catches anything reaching outside the input ring, and a
+// real packet lost to more than the allowed garbage aborts. The worst resync
+// seen so far is printed each time it gets worse.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "CedrusAssert.h"
+#include "ResponseParserFuzzing.h"
+
+namespace
+{
+    unsigned int s_worstBytesToResync = 0;
+    unsigned int s_worstPollsToResync = 0;
+}
+
+extern "C" int LLVMFuzzerInitialize(int *, char ***)
+{
+    // Garbage is the point here.
+    Cedrus::Suppress_All_Assertions();
+
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t * data, size_t size)
+{
+    const ResponseParserFuzzing::Outcome outcome = ResponseParserFuzzing::Run(data, size);
+
+    if (!outcome.intact)
+    {
+        std::fprintf(stderr, "%u of %d real packets lost after the garbage\n",
+            outcome.realPacketsLost, ResponseParserFuzzing::NUM_REAL_PACKETS);
+        std::abort();
+    }
+
+    if (outcome.bytesToResync > s_worstBytesToResync || outcome.pollsToResync > s_worstPollsToResync)
+    {
+        s_worstBytesToResync = std::max(s_worstBytesToResync, outcome.bytesToResync);
+        s_worstPollsToResync = std::max(s_worstPollsToResync, outcome.pollsToResync);
+        std::fprintf(stderr, "worst resync so far: %u bytes, %u polls\n", s_worstBytesToResync, s_worstPollsToResync);
+    }
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RESPONSE_PARSER_FUZZING_H
+#define RESPONSE_PARSER_FUZZING_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+// Shared by the libFuzzer target and the test that replays seeded garbage.
+// The first input byte picks the packet format, the second how many bytes
+// each poll reads, and the rest is garbage. Real packets are appended after
+// the garbage; a packet the parser latches on to at the end of the garbage
+// may run into the first of them, but every one after that must come out.
+namespace ResponseParserFuzzing
+{
+    enum { NUM_REAL_PACKETS = 8 };
+    enum { MAX_REAL_PACKETS_LOST = 1 };
+    enum { MAX_BYTES_PER_POLL = 64 };
+    using ResponseTestHelpers::XID_PACKET_SIZE;
+    using ResponseTestHelpers::ST2_PACKET_SIZE;
+
+    // Low time bytes of 0x00 to 0x07 and 0x0C, none of them a sync byte.
+    enum { REAL_TIME_BASE = 0x0C00 };
+
+    struct Outcome
+    {
+        bool intact;
+        unsigned int realPacketsLost;
+        unsigned int bytesToResync;  // read after the garbage until a real packet came out
+        unsigned int pollsToResync;  // that read any of those bytes
+    };
+
+    inline std::shared_ptr<const Cedrus::DeviceConfig> BuiltInConfig(bool st2)
+    {
+        return st2 ? ResponseTestHelpers::StimTrackerQuad() : ResponseTestHelpers::RB840();
+    }
+
+    inline void AppendRealPacket(std::vector<unsigned char> & bytes, bool st2, int index)
+    {
+        const unsigned int rt = REAL_TIME_BASE + index;
+        const bool pressed = (index % 2) == 0;
+
+        if (st2)
+            ResponseTestHelpers::AppendST2Packet(bytes, 0, index, pressed, rt);
+        else
+            ResponseTestHelpers::AppendXidPacket(bytes, 0, index % 8, pressed, rt);
+    }
+
+    inline bool IsRealPacket(const Cedrus::Response & res, int index)
+    {
+        return res.GetReactionTime() == REAL_TIME_BASE + index && res.wasPressed == ((index % 2) == 0);
+    }
+
+    inline Outcome Run(const unsigned char * data, size_t size)
+    {
+        Outcome outcome = { true, 0, 0, 0 };
+        if (size < 2)
+            return outcome;
+
+        const bool st2 = (data[0] & 1) != 0;
+        const size_t bytes_per_poll = 1 + data[1] % MAX_BYTES_PER_POLL;
+
+        std::vector<unsigned char> stream(data + 2, data + size);
+        const size_t garbage_size = stream.size();
+        for (int i = 0; i < NUM_REAL_PACKETS; ++i)
+            AppendRealPacket(stream, st2, i);
+
+        Cedrus::ResponseManager manager(BuiltInConfig(st2));
+
+        // Each response with the offset of the last byte its poll read.
+        std::vector<Cedrus::Response> responses;
+        std::vector<size_t> read_through;
+        Cedrus::Response batch[MAX_BYTES_PER_POLL];
+
+        std::chrono::steady_clock::time_point read_time;
+        for (size_t offset = 0; offset < stream.size(); offset += bytes_per_poll)
+        {
+            const size_t count = std::min(bytes_per_poll, stream.size() - offset);
+            read_time += std::chrono::milliseconds(1);
+            manager.FeedInput(&stream[offset], static_cast<unsigned int>(count), read_time);
+
+            size_t taken;
+            while ((taken = manager.GetResponses(batch, MAX_BYTES_PER_POLL)) > 0)
+            {
+                responses.insert(responses.end(), batch, batch + taken);
+                read_through.insert(read_through.end(), taken, offset + count);
+            }
+        }
+
+        // Nothing follows the real packets, so whatever made it through is
+        // at the very end, in order.
+        unsigned int recovered = 0;
+        while (recovered < NUM_REAL_PACKETS && recovered < responses.size() &&
+            IsRealPacket(responses[responses.size() - 1 - recovered], NUM_REAL_PACKETS - 1 - recovered))
+        {
+            ++recovered;
+        }
+
+        outcome.realPacketsLost = NUM_REAL_PACKETS - recovered;
+        outcome.intact = outcome.realPacketsLost <= MAX_REAL_PACKETS_LOST;
+        if (recovered == 0)
+            return outcome;
+
+        const size_t first_out = responses.size() - recovered;
+        outcome.bytesToResync = static_cast<unsigned int>(read_through[first_out] - garbage_size);
+        outcome.pollsToResync = static_cast<unsigned int>(
+            (read_through[first_out] - 1) / bytes_per_poll - garbage_size / bytes_per_poll + 1);
+
+        return outcome;
+    }
+}
+
+#endif // RESPONSE_PARSER_FUZZING_H
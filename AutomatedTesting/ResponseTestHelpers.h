@@ -0,0 +1,109 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "DeviceConfig.h"
+#include "ResponseManager.h"
+#include "constants.h"
+
+// Device configs and hand-built response packets for the tests that feed a
+// ResponseManager directly.
+namespace ResponseTestHelpers
+{
+    enum { XID_PACKET_SIZE = 6, ST2_PACKET_SIZE = 9 };
+
+    // The built-in configs live forever, so these don't own anything.
+    inline std::shared_ptr<const Cedrus::DeviceConfig> BuiltInConfig(int productID, int modelID, int majorFirmwareVer)
+    {
+        return std::shared_ptr<const Cedrus::DeviceConfig>(std::shared_ptr<const Cedrus::DeviceConfig>(),
+            &Cedrus::DeviceConfig::FindBuiltInConfig(productID, modelID, majorFirmwareVer));
+    }
+
+    inline std::shared_ptr<const Cedrus::DeviceConfig> RB840()
+    {
+        return BuiltInConfig(Cedrus::RB, Cedrus::RB_840, 2);
+    }
+
+    inline std::shared_ptr<const Cedrus::DeviceConfig> StimTrackerQuad()
+    {
+        return BuiltInConfig(Cedrus::STIMTRACKER, Cedrus::ST_QUAD, 2);
+    }
+
+    // rt is the full 32-bit device time.
+    inline void AppendXidPacket(std::vector<unsigned char> & bytes, int port, int key, bool pressed, unsigned int rt)
+    {
+        const unsigned char packet[XID_PACKET_SIZE] =
+        {
+            'k',
+            static_cast<unsigned char>((key << 5) | (pressed ? 0x10 : 0) | port),
+            static_cast<unsigned char>(rt),
+            static_cast<unsigned char>(rt >> 8),
+            static_cast<unsigned char>(rt >> 16),
+            static_cast<unsigned char>(rt >> 24)
+        };
+
+        bytes.insert(bytes.end(), packet, packet + XID_PACKET_SIZE);
+    }
+
+    inline void AppendST2Packet(std::vector<unsigned char> & bytes, int port, int key, bool pressed, unsigned int rt)
+    {
+        const unsigned char packet[ST2_PACKET_SIZE] =
+        {
+            'o',
+            static_cast<unsigned char>(port),
+            static_cast<unsigned char>(key),
+            static_cast<unsigned char>(pressed ? '1' : '0'),
+            static_cast<unsigned char>(rt),
+            static_cast<unsigned char>(rt >> 8),
+            static_cast<unsigned char>(rt >> 16),
+            static_cast<unsigned char>(rt >> 24),
+            0
+        };
+
+        bytes.insert(bytes.end(), packet, packet + ST2_PACKET_SIZE);
+    }
+
+    // A press of key on port 0 of a StimTracker 2, for tests that just need
+    // a response to come out.
+    inline void FeedST2Press(Cedrus::ResponseManager & manager, int key, unsigned int rt = 1,
+        std::chrono::steady_clock::time_point readTime = std::chrono::steady_clock::now())
+    {
+        std::vector<unsigned char> bytes;
+        AppendST2Packet(bytes, 0, key, true, rt);
+
+        manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()), readTime);
+    }
+} // namespace ResponseTestHelpers
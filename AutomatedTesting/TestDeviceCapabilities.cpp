@@ -0,0 +1,135 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include "DeviceCapabilities.h"
+#include "DeviceConfig.h"
+#include "constants.h"
+
+TEST( TestDeviceCapabilities, DefaultSupportsNothing )
+{
+    Cedrus::DeviceCapabilities capabilities;
+
+    for (int command = 0; command < Cedrus::XID_COMMAND_COUNT; ++command)
+        EXPECT_FALSE( capabilities.Supports( static_cast<Cedrus::XidCommand>(command) ) );
+
+    EXPECT_FALSE( capabilities.Supports( Cedrus::XID_COMMAND_COUNT ) );
+}
+
+TEST( TestDeviceCapabilities, RB840 )
+{
+    const Cedrus::DeviceConfig & rb840 = Cedrus::DeviceConfig::FindBuiltInConfig( Cedrus::RB, Cedrus::RB_840, 2 );
+    ASSERT_TRUE( rb840.DoesConfigMatchDevice( Cedrus::RB, Cedrus::RB_840, 2 ) );
+
+    const Cedrus::DeviceCapabilities old_firmware( rb840, Cedrus::RB_840, 20 );
+    const Cedrus::DeviceCapabilities new_firmware( rb840, Cedrus::RB_840, 21 );
+
+    EXPECT_TRUE( new_firmware.Supports( Cedrus::CMD_BUTTON_DEBOUNCE_TIME ) );
+    EXPECT_TRUE( new_firmware.Supports( Cedrus::CMD_KB_MODE_PROTOCOL ) );
+    EXPECT_TRUE( new_firmware.Supports( Cedrus::CMD_RT_TIMER ) );
+    EXPECT_FALSE( new_firmware.Supports( Cedrus::CMD_OUTPUT_LOGIC ) );
+    EXPECT_FALSE( new_firmware.Supports( Cedrus::CMD_LOCKING_LEVEL ) );
+    EXPECT_FALSE( new_firmware.Supports( Cedrus::CMD_TRANSLATION_TABLE ) );
+    EXPECT_FALSE( new_firmware.Supports( Cedrus::CMD_VOLTAGE_RANGE ) );
+
+    EXPECT_FALSE( old_firmware.Supports( Cedrus::CMD_KB_AUTOREPEAT ) );
+    EXPECT_TRUE( new_firmware.Supports( Cedrus::CMD_KB_AUTOREPEAT ) );
+    EXPECT_FALSE( old_firmware.Supports( Cedrus::CMD_OUTPUT_PAUSE ) );
+    EXPECT_TRUE( new_firmware.Supports( Cedrus::CMD_OUTPUT_PAUSE ) );
+}
+
+TEST( TestDeviceCapabilities, OnlyPodsDependOnFirmwareForFlashCommands )
+{
+    for (unsigned int i = 0; i < Cedrus::DeviceConfig::BuiltInConfigCount(); ++i)
+    {
+        const Cedrus::DeviceConfig & config = Cedrus::DeviceConfig::BuiltInConfigAtIndex( i );
+        const bool is_pod = config.IsMPod() || config.IsCPod();
+
+        const Cedrus::DeviceCapabilities old_firmware( config, config.GetModelID(), 21 );
+        const Cedrus::DeviceCapabilities new_firmware( config, config.GetModelID(), 22 );
+
+        EXPECT_FALSE( old_firmware.Supports( Cedrus::CMD_POD_LOCK ) ) << config.GetDeviceName();
+        EXPECT_EQ( is_pod, new_firmware.Supports( Cedrus::CMD_POD_LOCK ) ) << config.GetDeviceName();
+        EXPECT_EQ( is_pod, new_firmware.Supports( Cedrus::CMD_FLASH_BACKUP ) ) << config.GetDeviceName();
+
+        if (is_pod)
+        {
+            EXPECT_TRUE( Cedrus::DeviceCapabilities::DependsOnFirmwareVersion( config ) ) << config.GetDeviceName();
+        }
+    }
+}
+
+// XIDDevice only asks for the firmware version for commands that say they
+// need it, and only on devices whose config says so.
+TEST( TestDeviceCapabilities, FirmwareDependenceIsDeclared )
+{
+    for (unsigned int i = 0; i < Cedrus::DeviceConfig::BuiltInConfigCount(); ++i)
+    {
+        const Cedrus::DeviceConfig & config = Cedrus::DeviceConfig::BuiltInConfigAtIndex( i );
+
+        const Cedrus::DeviceCapabilities no_firmware( config, config.GetModelID(), 0 );
+        const Cedrus::DeviceCapabilities new_firmware( config, config.GetModelID(), 99 );
+
+        for (int c = 0; c < Cedrus::XID_COMMAND_COUNT; ++c)
+        {
+            const Cedrus::XidCommand command = static_cast<Cedrus::XidCommand>(c);
+
+            if (!Cedrus::DeviceCapabilities::DependsOnFirmwareVersion( command ))
+            {
+                EXPECT_EQ( no_firmware.Supports( command ), new_firmware.Supports( command ) ) << config.GetDeviceName() << " " << c;
+            }
+            else if (!Cedrus::DeviceCapabilities::DependsOnFirmwareVersion( config ))
+            {
+                EXPECT_FALSE( new_firmware.Supports( command ) ) << config.GetDeviceName() << " " << c;
+            }
+        }
+    }
+}
+
+TEST( TestDeviceCapabilities, AnalogCommandsNeedAnAnalogModel )
+{
+    const Cedrus::DeviceConfig & mpod = Cedrus::DeviceConfig::FindBuiltInConfig( Cedrus::MPOD, 'V', 2 );
+
+    EXPECT_TRUE( Cedrus::DeviceCapabilities( mpod, 'V', 22 ).Supports( Cedrus::CMD_VOLTAGE_RANGE ) );
+    EXPECT_FALSE( Cedrus::DeviceCapabilities( mpod, '0', 22 ).Supports( Cedrus::CMD_VOLTAGE_RANGE ) );
+}
+
+TEST( TestDeviceCapabilities, EveryDeviceButStimTracker1CanResetTheRtTimer )
+{
+    for (unsigned int i = 0; i < Cedrus::DeviceConfig::BuiltInConfigCount(); ++i)
+    {
+        const Cedrus::DeviceConfig & config = Cedrus::DeviceConfig::BuiltInConfigAtIndex( i );
+        const Cedrus::DeviceCapabilities capabilities( config, config.GetModelID(), 22 );
+
+        EXPECT_EQ( !config.IsStimTracker1(), capabilities.Supports( Cedrus::CMD_RESET_RT_TIMER ) ) << config.GetDeviceName();
+    }
+}
@@ -0,0 +1,122 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+
+#include "DeviceClockModel.h"
+
+namespace
+{
+    const std::chrono::steady_clock::time_point HOST_EPOCH = std::chrono::steady_clock::now();
+
+    // A device clock running 40 ppm fast that was reset 3.5 s after HOST_EPOCH.
+    std::chrono::steady_clock::time_point TrueHostTime(long long deviceTimeMs)
+    {
+        return HOST_EPOCH + std::chrono::microseconds(3500000 + static_cast<long long>(deviceTimeMs * 1000.0 / 1.00004));
+    }
+
+    long long MicrosecondsApart(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b)
+    {
+        return std::llabs(std::chrono::duration_cast<std::chrono::microseconds>(a - b).count());
+    }
+}
+
+TEST( TestDeviceClockModel, NeedsTwoSamples )
+{
+    Cedrus::DeviceClockModel model;
+    std::chrono::steady_clock::time_point host_time;
+    std::chrono::microseconds error_bound;
+
+    EXPECT_FALSE( model.DeviceToHost(0, host_time, error_bound) );
+
+    model.AddSample(1000, TrueHostTime(1000), std::chrono::microseconds(200));
+    EXPECT_FALSE( model.DeviceToHost(1000, host_time, error_bound) );
+
+    model.AddSample(2000, TrueHostTime(2000), std::chrono::microseconds(200));
+    EXPECT_TRUE( model.DeviceToHost(1000, host_time, error_bound) );
+
+    model.Reset();
+    EXPECT_EQ( 0u, model.GetSampleCount() );
+    EXPECT_FALSE( model.DeviceToHost(1000, host_time, error_bound) );
+}
+
+// Samples carry up to +/-400 us of jitter, as a USB round trip would.
+TEST( TestDeviceClockModel, RecoversOffsetAndDriftWithinTheBound )
+{
+    Cedrus::DeviceClockModel model;
+
+    std::srand(7);
+    for (long long device_ms = 0; device_ms <= 600000; device_ms += 10000)
+    {
+        const long long jitter_us = std::rand() % 801 - 400;
+        model.AddSample(device_ms, TrueHostTime(device_ms) + std::chrono::microseconds(jitter_us), std::chrono::microseconds(400));
+    }
+
+    EXPECT_NEAR( 1.0 / 1.00004, model.GetDriftRatio(), 5e-6 );
+
+    std::chrono::steady_clock::time_point host_time;
+    std::chrono::microseconds error_bound;
+    for (long long device_ms = 5000; device_ms < 600000; device_ms += 50000)
+    {
+        ASSERT_TRUE( model.DeviceToHost(device_ms, host_time, error_bound) );
+        EXPECT_LE( MicrosecondsApart(TrueHostTime(device_ms), host_time), error_bound.count() );
+        EXPECT_LE( error_bound.count(), 1000 );
+    }
+}
+
+// One sample with a huge round trip shouldn't drag the fit along with it.
+TEST( TestDeviceClockModel, UncertainSamplesCountForLess )
+{
+    Cedrus::DeviceClockModel model;
+
+    for (long long device_ms = 0; device_ms <= 100000; device_ms += 10000)
+        model.AddSample(device_ms, TrueHostTime(device_ms), std::chrono::microseconds(100));
+
+    model.AddSample(105000, TrueHostTime(105000) + std::chrono::milliseconds(20), std::chrono::milliseconds(20));
+
+    std::chrono::steady_clock::time_point host_time;
+    std::chrono::microseconds error_bound;
+    ASSERT_TRUE( model.DeviceToHost(50000, host_time, error_bound) );
+    EXPECT_LE( MicrosecondsApart(TrueHostTime(50000), host_time), 100 );
+}
+
+TEST( TestDeviceClockModel, ForgetsTheOldestSamples )
+{
+    Cedrus::DeviceClockModel model;
+
+    for (int i = 0; i < Cedrus::DeviceClockModel::MAX_SAMPLES + 10; ++i)
+        model.AddSample(i * 1000, TrueHostTime(i * 1000), std::chrono::microseconds(100));
+
+    EXPECT_EQ( static_cast<unsigned int>(Cedrus::DeviceClockModel::MAX_SAMPLES), model.GetSampleCount() );
+}
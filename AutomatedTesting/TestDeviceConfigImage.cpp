@@ -0,0 +1,335 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "DeviceConfigImage.h"
+#include "constants.h"
+
+class TestDeviceConfigImage : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        m_descriptionPath = "TestDeviceConfigImage.devconfig";
+        m_imagePath = "TestDeviceConfigImage.bin";
+    }
+
+    virtual void TearDown()
+    {
+        m_image.Unload();
+        std::remove(m_descriptionPath.c_str());
+        std::remove(m_imagePath.c_str());
+    }
+
+    void WriteDescription(const std::string & text)
+    {
+        std::ofstream file(m_descriptionPath.c_str());
+        file << text;
+    }
+
+    bool CompileDescription()
+    {
+        return Cedrus::DeviceConfigImage::Compile(
+            std::vector<std::string>(1, m_descriptionPath),
+            m_imagePath,
+            [this](std::string message) { m_reports.push_back(message); });
+    }
+
+    std::string m_descriptionPath;
+    std::string m_imagePath;
+    std::vector<std::string> m_reports;
+    Cedrus::DeviceConfigImage m_image;
+};
+
+TEST_F( TestDeviceConfigImage, CompiledConfigsMatchTheirDescription )
+{
+    WriteDescription(
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = RB-Test\n"
+        "XidProductID = 50\n"
+        "XidModelID = 57\n"
+        "\n"
+        "[Port0]\n"
+        "PortName = Key\n"
+        "NumberOfLines = 8\n"
+        "UseableAsResponse = Yes\n"
+        "XidDeviceKeyMap0 = 7\n"
+        "XidDeviceKeyMap1 = 6\n"
+        "XidDeviceKeyMap3 = -1\n"
+        "\n"
+        "[Port1]\n"
+        "PortName = Accessory Connector\n"
+        "NumberOfLines = 6\n"
+        "UseableAsResponse = No\n"
+        "\n"
+        "[Port2]\n"
+        "PortName = Light Sensor\n"
+        "NumberOfLines = 1\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = c-pod for Testing\n"
+        "XidProductID = 52\n"
+        "XidModelID = 119\n"
+        "OutputLines = 16\n");
+
+    ASSERT_TRUE( CompileDescription() );
+    EXPECT_TRUE( m_reports.empty() );
+    ASSERT_TRUE( m_image.Load(m_imagePath) );
+    ASSERT_EQ( 2u, m_image.ConfigCount() );
+
+    const Cedrus::DeviceConfig * rb = m_image.FindConfig(Cedrus::RB, 57, 2);
+    ASSERT_TRUE( rb != nullptr );
+    EXPECT_EQ( "RB-Test", rb->GetDeviceName() );
+    EXPECT_EQ( 6u, rb->GetNumberOfOutputLines() );
+    EXPECT_EQ( 2u, rb->GetNumberOfPorts() );
+    EXPECT_EQ( 7, rb->GetMappedKey(0, 0) );
+    EXPECT_EQ( 6, rb->GetMappedKey(0, 1) );
+    EXPECT_EQ( 2, rb->GetMappedKey(0, 2) );
+    EXPECT_EQ( -1, rb->GetMappedKey(0, 3) );
+    EXPECT_EQ( 4, rb->GetMappedKey(0, 4) );
+    ASSERT_TRUE( rb->GetPortPtrByNumber(2) != nullptr );
+    EXPECT_EQ( std::string("Light Sensor"), rb->GetPortPtrByNumber(2)->portName );
+    EXPECT_TRUE( rb->GetPortPtrByNumber(1) == nullptr );
+
+    const Cedrus::DeviceConfig * cpod = m_image.FindConfig(Cedrus::CPOD, 119, 2);
+    ASSERT_TRUE( cpod != nullptr );
+    EXPECT_EQ( "c-pod for Testing", cpod->GetDeviceName() );
+    EXPECT_EQ( 16u, cpod->GetNumberOfOutputLines() );
+
+    EXPECT_TRUE( m_image.FindConfig(Cedrus::RB, 57, 1) == nullptr );
+    EXPECT_TRUE( m_image.FindConfig(Cedrus::CPOD, 120, 2) == nullptr );
+}
+
+TEST_F( TestDeviceConfigImage, BadDevicesAreReportedAndLeftOut )
+{
+    WriteDescription(
+        "[DeviceInfo]\n"
+        "DeviceName = No Product\n"
+        "XidModelID = 49\n"
+        "MajorFirmwareVersion = 2\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = Bad Key Map\n"
+        "XidProductID = 50\n"
+        "XidModelID = 56\n"
+        "[Port0]\n"
+        "XidDeviceKeyMap9 = 1\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = Port Out Of Lookup Range\n"
+        "XidProductID = 50\n"
+        "XidModelID = 54\n"
+        "[Port20]\n"
+        "XidDeviceKeyMap0 = 1\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = Unknown Product\n"
+        "XidProductID = 90\n"
+        "XidModelID = 49\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 3\n"
+        "DeviceName = Future Firmware\n"
+        "XidProductID = 50\n"
+        "XidModelID = 53\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = Model Out Of Range\n"
+        "XidProductID = 50\n"
+        "XidModelID = 200\n"
+        "\n"
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = Good\n"
+        "XidProductID = 50\n"
+        "XidModelID = 55\n");
+
+    ASSERT_TRUE( CompileDescription() );
+
+    unsigned int left_out = 0;
+    for (const std::string & report : m_reports)
+    {
+        if (report.find("device left out") != std::string::npos)
+            ++left_out;
+    }
+    EXPECT_EQ( 6u, left_out );
+
+    ASSERT_TRUE( m_image.Load(m_imagePath) );
+    ASSERT_EQ( 1u, m_image.ConfigCount() );
+    EXPECT_EQ( "Good", m_image.ConfigAtIndex(0)->GetDeviceName() );
+}
+
+TEST_F( TestDeviceConfigImage, NothingUsableWritesNoImage )
+{
+    WriteDescription("[DeviceInfo]\nDeviceName = Incomplete\n");
+
+    EXPECT_FALSE( CompileDescription() );
+    EXPECT_FALSE( m_image.Load(m_imagePath) );
+}
+
+TEST_F( TestDeviceConfigImage, RejectsFilesThatAreNotImages )
+{
+    WriteDescription("[DeviceInfo]\nThis is not an image, but it is long enough to have a header.\n");
+
+    EXPECT_FALSE( m_image.Load(m_descriptionPath) );
+    EXPECT_FALSE( m_image.IsLoaded() );
+    EXPECT_TRUE( m_image.FindConfig(Cedrus::RB, 49, 1) == nullptr );
+}
+
+TEST_F( TestDeviceConfigImage, RejectsTruncatedImages )
+{
+    WriteDescription(
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = Truncated\n"
+        "XidProductID = 50\n"
+        "XidModelID = 55\n");
+
+    ASSERT_TRUE( CompileDescription() );
+
+    std::ifstream image(m_imagePath.c_str(), std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(image)), std::istreambuf_iterator<char>());
+    image.close();
+
+    std::ofstream truncated(m_imagePath.c_str(), std::ios::binary | std::ios::trunc);
+    truncated.write(bytes.data(), bytes.size() - 1);
+    truncated.close();
+
+    EXPECT_FALSE( m_image.Load(m_imagePath) );
+}
+
+TEST_F( TestDeviceConfigImage, RejectsDamagedImages )
+{
+    // Names that fill their fields, so that damaging the last byte leaves
+    // them unterminated.
+    const std::string device_name(Cedrus::DeviceConfig::MAX_NAME_LENGTH - 1, 'D');
+    const std::string port_name(Cedrus::DevicePort::MAX_NAME_LENGTH - 1, 'P');
+
+    WriteDescription(
+        "[DeviceInfo]\n"
+        "MajorFirmwareVersion = 2\n"
+        "DeviceName = " + device_name + "\n"
+        "XidProductID = 50\n"
+        "XidModelID = 55\n"
+        "[Port0]\n"
+        "PortName = " + port_name + "\n"
+        "NumberOfLines = 8\n"
+        "XidDeviceKeyMap0 = 7\n"
+        "XidDeviceKeyMap1 = -1\n"
+        "[Port2]\n"
+        "NumberOfLines = 1\n");
+
+    ASSERT_TRUE( CompileDescription() );
+
+    std::ifstream image(m_imagePath.c_str(), std::ios::binary);
+    const std::string bytes((std::istreambuf_iterator<char>(image)), std::istreambuf_iterator<char>());
+    image.close();
+
+    const size_t index_start = bytes.size() - sizeof(Cedrus::DeviceConfigIndex);
+    const size_t device_name_end = bytes.find(device_name) + device_name.size();
+    const size_t port_name_end = bytes.find(port_name) + port_name.size();
+    unsigned int rejected = 0;
+
+    for (size_t offset = 0; offset < bytes.size(); ++offset)
+    {
+        std::string damaged = bytes;
+        damaged[offset] = static_cast<char>(damaged[offset] ^ 0xFF);
+
+        std::ofstream damaged_image(m_imagePath.c_str(), std::ios::binary | std::ios::trunc);
+        damaged_image.write(damaged.data(), damaged.size());
+        damaged_image.close();
+
+        if (!m_image.Load(m_imagePath))
+        {
+            ++rejected;
+            continue;
+        }
+
+        // Every index entry is either empty or names the one config.
+        ASSERT_LT( offset, index_start ) << "damaged index accepted";
+        ASSERT_NE( device_name_end, offset ) << "unterminated device name accepted";
+        ASSERT_NE( port_name_end, offset ) << "unterminated port name accepted";
+
+        // Whatever got through must be safe to use.
+        const Cedrus::DeviceConfig * config = m_image.ConfigAtIndex(0);
+        ASSERT_LE( config->GetNumberOfPorts(), (unsigned int)Cedrus::DeviceConfig::MAX_DEVICE_PORTS ) << offset;
+        EXPECT_LT( config->GetDeviceName().size(), (size_t)Cedrus::DeviceConfig::MAX_NAME_LENGTH ) << offset;
+
+        for (int port_number = 0; port_number < Cedrus::DeviceConfig::LOOKUP_RANGE; ++port_number)
+        {
+            const Cedrus::DevicePort * port = config->GetPortPtrByNumber(port_number);
+
+            if (port != nullptr)
+            {
+                ASSERT_EQ( port_number, port->portNumber ) << offset;
+                ASSERT_LE( port->keyMapSize, (int)Cedrus::DevicePort::MAX_KEYS ) << offset;
+            }
+
+            for (int key = 0; key < Cedrus::DeviceConfig::LOOKUP_RANGE; ++key)
+            {
+                const int expected = (port != nullptr && key < port->keyMapSize) ? static_cast<signed char>(port->keyMap[key]) : key;
+                ASSERT_EQ( expected, config->GetMappedKey(port_number, key) ) << offset;
+            }
+        }
+
+        m_image.Unload();
+    }
+
+    EXPECT_GE( rejected, bytes.size() - index_start );
+
+    // And the undamaged image still loads.
+    std::ofstream intact(m_imagePath.c_str(), std::ios::binary | std::ios::trunc);
+    intact.write(bytes.data(), bytes.size());
+    intact.close();
+
+    EXPECT_TRUE( m_image.Load(m_imagePath) );
+}
+
+TEST( TestDeviceConfigWellFormed, BuiltInConfigsPass )
+{
+    for (unsigned int i = 0; i < Cedrus::DeviceConfig::BuiltInConfigCount(); ++i)
+        EXPECT_TRUE( Cedrus::DeviceConfig::BuiltInConfigAtIndex(i).IsWellFormed() ) << i;
+
+    EXPECT_TRUE( Cedrus::DeviceConfig::InvalidConfig().IsWellFormed() );
+}
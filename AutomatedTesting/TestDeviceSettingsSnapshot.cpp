@@ -0,0 +1,124 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "DeviceSettingsSnapshot.h"
+
+TEST( TestDeviceSettingsSnapshot, NewSnapshotHasNothingApplicable )
+{
+    Cedrus::DeviceSettingsSnapshot snapshot;
+
+    EXPECT_EQ( Cedrus::DeviceSettingsSnapshot::NOT_APPLICABLE, snapshot.pulseDuration );
+    EXPECT_EQ( Cedrus::DeviceSettingsSnapshot::NOT_APPLICABLE, snapshot.signalFilterHoldOff[3] );
+    EXPECT_TRUE( snapshot.inputSelectors.empty() );
+}
+
+TEST( TestDeviceSettingsSnapshot, IdenticalSnapshotsHaveNoDifferences )
+{
+    Cedrus::DeviceSettingsSnapshot snapshot;
+    snapshot.pulseDuration = 10;
+    snapshot.inputSelectors = "A";
+    snapshot.analogInputThreshold[0] = 50;
+
+    EXPECT_TRUE( Cedrus::DiffSettingsSnapshots( snapshot, snapshot ).empty() );
+}
+
+TEST( TestDeviceSettingsSnapshot, DiffListsChangedSettings )
+{
+    Cedrus::DeviceSettingsSnapshot before;
+    before.pulseDuration = 10;
+    before.numberOfLines = 16;
+
+    Cedrus::DeviceSettingsSnapshot after = before;
+    after.pulseDuration = 250;
+    after.ledFunction = '1';
+
+    const std::vector<Cedrus::SettingDifference> differences = Cedrus::DiffSettingsSnapshots( before, after );
+
+    ASSERT_EQ( 2u, differences.size() );
+    EXPECT_EQ( "ledFunction", differences[0].setting );
+    EXPECT_EQ( Cedrus::DeviceSettingsSnapshot::NOT_APPLICABLE, differences[0].before );
+    EXPECT_EQ( '1', differences[0].after );
+    EXPECT_EQ( "pulseDuration", differences[1].setting );
+    EXPECT_EQ( 10, differences[1].before );
+    EXPECT_EQ( 250, differences[1].after );
+}
+
+TEST( TestDeviceSettingsSnapshot, DiffMatchesPerInputSettingsBySelector )
+{
+    Cedrus::DeviceSettingsSnapshot before;
+    before.inputSelectors = "AB";
+    before.signalFilterHoldOn[0] = 5;
+    before.signalFilterHoldOn[1] = 7;
+
+    Cedrus::DeviceSettingsSnapshot after;
+    after.inputSelectors = "BC";
+    after.signalFilterHoldOn[0] = 7;
+    after.signalFilterHoldOn[1] = 9;
+
+    const std::vector<Cedrus::SettingDifference> differences = Cedrus::DiffSettingsSnapshots( before, after );
+
+    ASSERT_EQ( 2u, differences.size() );
+    EXPECT_EQ( "signalFilterHoldOn[A]", differences[0].setting );
+    EXPECT_EQ( 5, differences[0].before );
+    EXPECT_EQ( Cedrus::DeviceSettingsSnapshot::NOT_APPLICABLE, differences[0].after );
+    EXPECT_EQ( "signalFilterHoldOn[C]", differences[1].setting );
+    EXPECT_EQ( Cedrus::DeviceSettingsSnapshot::NOT_APPLICABLE, differences[1].before );
+    EXPECT_EQ( 9, differences[1].after );
+}
+
+TEST( TestDeviceSettingsSnapshot, MergeOnlyTakesSettingsThatApplyToBoth )
+{
+    Cedrus::DeviceSettingsSnapshot base;
+    base.inputSelectors = "AB";
+    base.pulseDuration = 10;
+    base.numberOfLines = 16;
+    base.analogInputThreshold[0] = 50;
+    base.analogInputThreshold[1] = 60;
+
+    Cedrus::DeviceSettingsSnapshot overrides;
+    overrides.inputSelectors = "B";
+    overrides.pulseDuration = 250;
+    overrides.ledFunction = '1';
+    overrides.analogInputThreshold[0] = 90;
+
+    const Cedrus::DeviceSettingsSnapshot merged = Cedrus::MergeSettingsSnapshots( base, overrides );
+
+    EXPECT_EQ( "AB", merged.inputSelectors );
+    EXPECT_EQ( 250, merged.pulseDuration );
+    EXPECT_EQ( 16, merged.numberOfLines );
+    EXPECT_EQ( Cedrus::DeviceSettingsSnapshot::NOT_APPLICABLE, merged.ledFunction );
+    EXPECT_EQ( 50, merged.analogInputThreshold[0] );
+    EXPECT_EQ( 90, merged.analogInputThreshold[1] );
+}
@@ -0,0 +1,163 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "DeviceTimeline.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+using namespace ResponseTestHelpers;
+
+namespace
+{
+    const long long MS_PER_DAY = 24LL * 60 * 60 * 1000;
+
+    // A device whose timer was reset at the start of the session, running a
+    // little fast against the host clock, as they do.
+    class SimulatedClock
+    {
+    public:
+        SimulatedClock()
+            : m_sessionStart(std::chrono::steady_clock::now())
+        {
+        }
+
+        std::chrono::steady_clock::time_point HostTime(long long deviceTimeMs) const
+        {
+            return m_sessionStart + std::chrono::microseconds(deviceTimeMs * 1000 - deviceTimeMs / 50);
+        }
+
+        std::chrono::steady_clock::time_point SessionStart() const
+        {
+            return m_sessionStart;
+        }
+
+    private:
+        std::chrono::steady_clock::time_point m_sessionStart;
+    };
+}
+
+class TestDeviceTimeline : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        m_manager.reset(new Cedrus::ResponseManager(RB840()));
+        m_manager->ResetDeviceTimeline(m_clock.SessionStart());
+    }
+
+    // Feeds a press that happened at deviceTimeMs, read 2 ms later.
+    void Press(long long deviceTimeMs)
+    {
+        std::vector<unsigned char> packet;
+        AppendXidPacket(packet, 0, 1, true, static_cast<unsigned int>(deviceTimeMs));
+        m_manager->FeedInput(packet.data(), static_cast<unsigned int>(packet.size()), m_clock.HostTime(deviceTimeMs + 2));
+    }
+
+    SimulatedClock m_clock;
+    std::unique_ptr<Cedrus::ResponseManager> m_manager;
+};
+
+// Sixty days with a press every ten minutes passes both the 4.66 hour
+// high-byte boundary and the 49.7 day rollover.
+TEST_F( TestDeviceTimeline, MultiDaySessionStaysContinuous )
+{
+    for (long long device_ms = 1234; device_ms < 60 * MS_PER_DAY; device_ms += 10 * 60 * 1000)
+    {
+        Press(device_ms);
+
+        ASSERT_TRUE( m_manager->HasQueuedResponses() ) << device_ms;
+        const Cedrus::Response res = m_manager->GetNextResponse();
+        ASSERT_EQ( device_ms, res.extendedReactionTime );
+        ASSERT_EQ( static_cast<int>(static_cast<unsigned int>(device_ms)), res.GetReactionTime() );
+    }
+}
+
+// A quiet spell longer than the rollover period still lands in the right one.
+TEST_F( TestDeviceTimeline, LongSilenceAcrossSeveralRollovers )
+{
+    const long long presses[] = { 5000, 120 * MS_PER_DAY + 17, 121 * MS_PER_DAY };
+
+    for (long long device_ms : presses)
+    {
+        Press(device_ms);
+
+        ASSERT_TRUE( m_manager->HasQueuedResponses() );
+        EXPECT_EQ( device_ms, m_manager->GetNextResponse().extendedReactionTime );
+    }
+}
+
+// Early in a session, a packet whose last byte isn't 0 can't be real.
+TEST_F( TestDeviceTimeline, HighTimeByteRejectedBeforeTheBoundary )
+{
+    std::vector<unsigned char> bytes;
+    AppendXidPacket(bytes, 0, 2, true, Cedrus::DeviceTimeline::HIGH_TIME_BYTE_BOUNDARY_MS + 5);
+    AppendXidPacket(bytes, 0, 3, true, 60000);
+
+    m_manager->FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()), m_clock.HostTime(60002));
+
+    ASSERT_TRUE( m_manager->HasQueuedResponses() );
+    EXPECT_EQ( 60000, m_manager->GetNextResponse().extendedReactionTime );
+    EXPECT_FALSE( m_manager->HasQueuedResponses() );
+}
+
+// With nothing known about the timer, such a packet is taken at face value.
+TEST( TestDeviceTimelineUnknown, HighTimeByteAcceptedWithoutATimeline )
+{
+    Cedrus::ResponseManager manager(RB840());
+
+    const long long device_ms = Cedrus::DeviceTimeline::HIGH_TIME_BYTE_BOUNDARY_MS + 5;
+    std::vector<unsigned char> packet;
+    AppendXidPacket(packet, 0, 2, true, device_ms);
+    manager.FeedInput(packet.data(), static_cast<unsigned int>(packet.size()));
+
+    ASSERT_TRUE( manager.HasQueuedResponses() );
+    EXPECT_EQ( device_ms, manager.GetNextResponse().extendedReactionTime );
+}
+
+TEST( TestDeviceTimelineUnknown, ExtendsAcrossRollover )
+{
+    Cedrus::DeviceTimeline timeline;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    EXPECT_FALSE( timeline.IsKnown() );
+    EXPECT_EQ( 0xFFFFFF00LL, timeline.Extend(0xFFFFFF00u, start) );
+    EXPECT_EQ( 0x100000010LL, timeline.Extend(0x10u, start + std::chrono::milliseconds(0x110)) );
+
+    timeline.Reset(start);
+    EXPECT_EQ( 42, timeline.Extend(42u, start + std::chrono::milliseconds(42)) );
+}
@@ -0,0 +1,157 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+
+#include "DeviceClockModel.h"
+#include "LatencyHistogram.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+using namespace ResponseTestHelpers;
+
+TEST( TestLatencyHistogram, BucketsCoverEveryDurationWithinAnEighth )
+{
+    for (unsigned int bucket = 1; bucket < Cedrus::LatencyHistogram::NUM_BUCKETS; ++bucket)
+    {
+        ASSERT_EQ( Cedrus::LatencyHistogram::BucketHigh(bucket - 1), Cedrus::LatencyHistogram::BucketLow(bucket) ) << bucket;
+
+        const unsigned long long low = Cedrus::LatencyHistogram::BucketLow(bucket);
+        const unsigned long long width = Cedrus::LatencyHistogram::BucketHigh(bucket) - low;
+        EXPECT_LE( width * Cedrus::LatencyHistogram::SUB_BUCKETS, low < 8 ? 8 : low ) << bucket;
+    }
+
+    // About 18 minutes.
+    EXPECT_EQ( 1ull << 40, Cedrus::LatencyHistogram::BucketHigh(Cedrus::LatencyHistogram::NUM_BUCKETS - 1) );
+}
+
+TEST( TestLatencyHistogram, SummaryStatistics )
+{
+    Cedrus::LatencyHistogram histogram;
+    EXPECT_EQ( 0u, histogram.GetCount() );
+    EXPECT_EQ( 0, histogram.GetPercentile(50).count() );
+
+    for (int us = 1; us <= 1000; ++us)
+        histogram.Record(std::chrono::microseconds(us));
+
+    EXPECT_EQ( 1000u, histogram.GetCount() );
+    EXPECT_EQ( 1000, histogram.GetMin().count() );
+    EXPECT_EQ( 1000000, histogram.GetMax().count() );
+    EXPECT_EQ( 500500, histogram.GetMean().count() );
+
+    // Never under the true value, and not more than a bucket over.
+    const long long median = histogram.GetPercentile(50).count();
+    EXPECT_GE( median, 500000 );
+    EXPECT_LE( median, 500000 + 500000 / 8 );
+    EXPECT_EQ( 1000000, histogram.GetPercentile(100).count() );
+
+    // Out of range and negative durations still count.
+    histogram.Record(std::chrono::hours(2));
+    histogram.Record(std::chrono::nanoseconds(-5));
+    EXPECT_EQ( 1002u, histogram.GetCount() );
+    EXPECT_EQ( 0, histogram.GetMin().count() );
+
+    const Cedrus::LatencyHistogram snapshot(histogram);
+    histogram.Reset();
+    EXPECT_EQ( 0u, histogram.GetCount() );
+    EXPECT_EQ( 1002u, snapshot.GetCount() );
+}
+
+TEST( TestLatencyHistogram, CsvHasOneLinePerBucketInUse )
+{
+    Cedrus::LatencyHistogram histogram;
+    histogram.Record(std::chrono::nanoseconds(3));
+    histogram.Record(std::chrono::nanoseconds(3));
+    histogram.Record(std::chrono::nanoseconds(100));
+
+    std::ostringstream csv;
+    histogram.WriteCsv(csv, "x");
+
+    EXPECT_EQ( "x,3,4,2\nx,96,104,1\n", csv.str() );
+}
+
+TEST( TestLatencyHistogram, ManagerTimesEachStageOnlyWhenEnabled )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    const std::chrono::steady_clock::time_point read_time = std::chrono::steady_clock::now() - std::chrono::milliseconds(5);
+    FeedST2Press(manager, 1, 100, read_time);
+    manager.GetNextResponse();
+    EXPECT_EQ( 0u, manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_DEQUEUED).GetCount() );
+
+    manager.EnableLatencyTracking(true);
+    FeedST2Press(manager, 1, 200, read_time);
+    Cedrus::Response batch[4];
+    ASSERT_EQ( 1u, manager.GetResponses(batch, 4) );
+
+    EXPECT_EQ( 1u, manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_PARSED).GetCount() );
+    EXPECT_EQ( 1u, manager.GetLatencyHistogram(Cedrus::LATENCY_PARSED_TO_QUEUED).GetCount() );
+    EXPECT_EQ( 1u, manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_DEQUEUED).GetCount() );
+    EXPECT_GE( manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_PARSED).GetMax(), std::chrono::milliseconds(5) );
+    EXPECT_GE( manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_DEQUEUED).GetMax(),
+        manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_PARSED).GetMax() );
+
+    // No clock model yet.
+    EXPECT_EQ( 0u, manager.GetLatencyHistogram(Cedrus::LATENCY_DEVICE_TO_READ).GetCount() );
+
+    manager.ResetLatencyHistograms();
+    EXPECT_EQ( 0u, manager.GetLatencyHistogram(Cedrus::LATENCY_READ_TO_DEQUEUED).GetCount() );
+}
+
+TEST( TestLatencyHistogram, DeviceToReadUsesTheClockModel )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+    manager.EnableLatencyTracking(true);
+
+    // Device time 0 is at start on the host, and the clocks agree.
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Cedrus::DeviceClockModel model;
+    model.AddSample(0, start, std::chrono::microseconds(0));
+    model.AddSample(1000, start + std::chrono::seconds(1), std::chrono::microseconds(0));
+    manager.SetDeviceClockModel(model);
+
+    // Pressed at 1500 ms, read 7 ms later.
+    FeedST2Press(manager, 1, 1500, start + std::chrono::milliseconds(1507));
+
+    const Cedrus::LatencyHistogram & device_to_read = manager.GetLatencyHistogram(Cedrus::LATENCY_DEVICE_TO_READ);
+    ASSERT_EQ( 1u, device_to_read.GetCount() );
+    EXPECT_NEAR( 7000, std::chrono::duration_cast<std::chrono::microseconds>(device_to_read.GetMax()).count(), 1 );
+
+    std::ostringstream csv;
+    manager.WriteLatencyCsv(csv);
+    EXPECT_EQ( 0u, csv.str().find("stage,low_ns,high_ns,count\n") );
+    EXPECT_NE( std::string::npos, csv.str().find("device_to_read,") );
+}
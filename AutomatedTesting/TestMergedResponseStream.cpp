@@ -0,0 +1,161 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "MergedResponseStream.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+namespace
+{
+    // Responses fed in by hand, read at whatever time the test says.
+    class FakeDevice
+    {
+    public:
+        FakeDevice()
+            : m_manager(std::make_shared<Cedrus::ResponseManager>(ResponseTestHelpers::StimTrackerQuad()))
+        {
+        }
+
+        void Respond(int key, std::chrono::steady_clock::time_point readTime)
+        {
+            ResponseTestHelpers::FeedST2Press(*m_manager, key, key, readTime);
+        }
+
+        int AddTo(Cedrus::MergedResponseStream & stream)
+        {
+            std::shared_ptr<Cedrus::ResponseManager> manager = m_manager;
+            return stream.AddSource(
+                []() {},
+                [manager](Cedrus::Response * out, size_t maxResponses) { return manager->GetResponses(out, maxResponses); });
+        }
+
+    private:
+        std::shared_ptr<Cedrus::ResponseManager> m_manager;
+    };
+}
+
+TEST( TestMergedResponseStream, MergesByHostTimeAndTagsTheSource )
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+
+    FakeDevice rb, lumina, stimtracker;
+    Cedrus::MergedResponseStream stream;
+    EXPECT_EQ( 0, rb.AddTo(stream) );
+    EXPECT_EQ( 1, lumina.AddTo(stream) );
+    EXPECT_EQ( 2, stimtracker.AddTo(stream) );
+
+    // Key numbers are the order they should come out in.
+    lumina.Respond(0, start);
+    rb.Respond(1, start + std::chrono::milliseconds(1));
+    stimtracker.Respond(2, start + std::chrono::milliseconds(2));
+    rb.Respond(3, start + std::chrono::milliseconds(3));
+    lumina.Respond(4, start + std::chrono::milliseconds(4));
+    stimtracker.Respond(5, start + std::chrono::milliseconds(5));
+
+    Cedrus::MergedResponse merged[16];
+    ASSERT_EQ( 6u, stream.Poll(merged, 16) );
+
+    const int sources[] = { 1, 0, 2, 0, 1, 2 };
+    for (int i = 0; i < 6; ++i)
+    {
+        EXPECT_EQ( i, merged[i].response.key );
+        EXPECT_EQ( sources[i], merged[i].source );
+    }
+
+    EXPECT_EQ( 0u, stream.Poll(merged, 16) );
+    EXPECT_EQ( 0u, stream.GetPendingCount() );
+}
+
+TEST( TestMergedResponseStream, ReorderWindowHoldsBackRecentResponses )
+{
+    FakeDevice rb, lumina;
+    Cedrus::MergedResponseStream stream;
+    rb.AddTo(stream);
+    lumina.AddTo(stream);
+    stream.SetReorderWindow(std::chrono::milliseconds(10));
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    rb.Respond(0, now - std::chrono::milliseconds(50));
+    lumina.Respond(1, now);
+
+    Cedrus::MergedResponse merged[4];
+    ASSERT_EQ( 1u, stream.Poll(merged, 4) );
+    EXPECT_EQ( 0, merged[0].response.key );
+    EXPECT_EQ( 1u, stream.GetPendingCount() );
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(15));
+
+    ASSERT_EQ( 1u, stream.Poll(merged, 4) );
+    EXPECT_EQ( 1, merged[0].response.key );
+    EXPECT_EQ( 1, merged[0].source );
+}
+
+// A busy source can't all be staged at once; what's left of it mustn't be
+// overtaken by a quieter one.
+TEST( TestMergedResponseStream, BusySourceIsNotOvertaken )
+{
+    enum { NUM_BUSY = 600 };
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() - std::chrono::seconds(1);
+
+    FakeDevice busy, quiet;
+    Cedrus::MergedResponseStream stream;
+    busy.AddTo(stream);
+    quiet.AddTo(stream);
+
+    for (int i = 0; i < NUM_BUSY; ++i)
+        busy.Respond(i % 100, start + std::chrono::microseconds(i * 10));
+    quiet.Respond(100, start + std::chrono::microseconds(3005));
+
+    std::vector<Cedrus::MergedResponse> all;
+    Cedrus::MergedResponse merged[64];
+    size_t count;
+    for (int polls = 0; polls < 100 && all.size() < NUM_BUSY + 1; ++polls)
+    {
+        while ((count = stream.Poll(merged, 64)) > 0)
+            all.insert(all.end(), merged, merged + count);
+    }
+
+    ASSERT_EQ( NUM_BUSY + 1u, all.size() );
+    for (size_t i = 1; i < all.size(); ++i)
+        EXPECT_FALSE( all[i].response.hostTime < all[i - 1].response.hostTime ) << i;
+
+    EXPECT_EQ( 100, all[301].response.key );
+    EXPECT_EQ( 1, all[301].source );
+}
@@ -0,0 +1,293 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ResponseAcquisition.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+namespace
+{
+    // Stands in for the device: packets handed to Send() come out of the
+    // next poll. Like a Connection, it holds an I/O lock while it feeds them
+    // to the manager.
+    class FakeDevice
+    {
+    public:
+        FakeDevice()
+            : m_pollCount(0)
+        {
+        }
+
+        void Send(int key, bool pressed)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ResponseTestHelpers::AppendXidPacket(m_pending, 0, key, pressed, 1);
+        }
+
+        void Poll(Cedrus::ResponseManager & manager)
+        {
+            std::vector<unsigned char> bytes;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                bytes.swap(m_pending);
+            }
+
+            std::lock_guard<std::mutex> io_lock(m_ioMutex);
+            ++m_pollCount;
+            if (!bytes.empty())
+                manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+        }
+
+        std::atomic<unsigned int> m_pollCount;
+        // Taken by the test to stand for a command sent to the device.
+        std::mutex m_ioMutex;
+
+    private:
+        std::mutex m_mutex;
+        std::vector<unsigned char> m_pending;
+    };
+
+    bool WaitFor(const std::function<bool ()> & condition)
+    {
+        const std::chrono::steady_clock::time_point give_up = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+
+        while (!condition())
+        {
+            if (std::chrono::steady_clock::now() > give_up)
+                return false;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        return true;
+    }
+}
+
+class TestResponseAcquisition : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        m_manager = std::make_shared<Cedrus::ResponseManager>(ResponseTestHelpers::RB840());
+    }
+
+    bool Start(Cedrus::ResponseAcquisition & acquisition)
+    {
+        return acquisition.Start([this]() { m_device.Poll(*m_manager); }, m_manager, std::chrono::milliseconds(2));
+    }
+
+    FakeDevice m_device;
+    std::shared_ptr<Cedrus::ResponseManager> m_manager;
+};
+
+TEST_F( TestResponseAcquisition, DeliversToSubscribers )
+{
+    Cedrus::ResponseAcquisition acquisition;
+
+    std::mutex received_mutex;
+    std::vector<Cedrus::Response> received;
+    acquisition.AddSubscriber([&](const Cedrus::Response & res)
+    {
+        std::lock_guard<std::mutex> lock(received_mutex);
+        received.push_back(res);
+    });
+
+    ASSERT_TRUE( Start(acquisition) );
+    EXPECT_FALSE( Start(acquisition) );
+
+    m_device.Send(2, true);
+    m_device.Send(2, false);
+
+    EXPECT_TRUE( WaitFor([&]() { std::lock_guard<std::mutex> lock(received_mutex); return received.size() == 2; }) );
+    acquisition.Stop();
+
+    ASSERT_EQ( 2u, received.size() );
+    EXPECT_TRUE( received[0].wasPressed );
+    EXPECT_FALSE( received[1].wasPressed );
+    EXPECT_FALSE( m_manager->HasQueuedResponses() );
+}
+
+TEST_F( TestResponseAcquisition, QueuesWithoutSubscribers )
+{
+    Cedrus::ResponseAcquisition acquisition;
+    ASSERT_TRUE( Start(acquisition) );
+
+    m_device.Send(5, true);
+
+    EXPECT_TRUE( WaitFor([&]() { return m_manager->HasQueuedResponses(); }) );
+    acquisition.Stop();
+
+    EXPECT_EQ( 1u, m_manager->GetNumberOfKeysDown() );
+}
+
+TEST_F( TestResponseAcquisition, RemovedSubscriberHearsNothing )
+{
+    Cedrus::ResponseAcquisition acquisition;
+
+    std::atomic<int> kept_count(0);
+    std::atomic<int> removed_count(0);
+    acquisition.AddSubscriber([&](const Cedrus::Response &) { ++kept_count; });
+    const int removed_id = acquisition.AddSubscriber([&](const Cedrus::Response &) { ++removed_count; });
+
+    EXPECT_TRUE( acquisition.RemoveSubscriber(removed_id) );
+    EXPECT_FALSE( acquisition.RemoveSubscriber(removed_id) );
+
+    ASSERT_TRUE( Start(acquisition) );
+    m_device.Send(1, true);
+
+    EXPECT_TRUE( WaitFor([&]() { return kept_count == 1; }) );
+    acquisition.Stop();
+
+    EXPECT_EQ( 0, removed_count );
+}
+
+TEST_F( TestResponseAcquisition, PauseStopsPolling )
+{
+    Cedrus::ResponseAcquisition acquisition;
+    acquisition.Pause(true);
+    ASSERT_TRUE( Start(acquisition) );
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ( 0u, m_device.m_pollCount );
+
+    acquisition.Pause(false);
+    EXPECT_TRUE( WaitFor([&]() { return m_device.m_pollCount > 0; }) );
+
+    acquisition.Stop();
+    EXPECT_FALSE( acquisition.IsRunning() );
+}
+
+namespace
+{
+    // More than the response queue holds.
+    enum { OVERFILL = 2000 };
+
+    size_t DrainAll(Cedrus::ResponseManager & manager)
+    {
+        Cedrus::Response batch[64];
+        size_t total = 0;
+        size_t count;
+
+        while ((count = manager.GetResponses(batch, 64)) > 0)
+            total += count;
+
+        return total;
+    }
+}
+
+TEST_F( TestResponseAcquisition, BlockingOverflowNeedsAnotherThreadToDrain )
+{
+    // Nothing drains the queue while this thread feeds it, so it mustn't wait.
+    m_manager->SetOverflowPolicy(Cedrus::OVERFLOW_BLOCK);
+
+    for (int i = 0; i < OVERFILL; ++i)
+        m_device.Send(1, i % 2 == 0);
+    m_device.Poll(*m_manager);
+
+    EXPECT_EQ( Cedrus::OVERFLOW_BLOCK, m_manager->GetOverflowPolicy() );
+    EXPECT_GT( m_manager->GetDroppedResponseCount(), 0u );
+    EXPECT_EQ( (size_t)OVERFILL, DrainAll(*m_manager) + m_manager->GetDroppedResponseCount() );
+}
+
+TEST_F( TestResponseAcquisition, SubscribersTurnBlockingOverflowOff )
+{
+    m_manager->SetOverflowPolicy(Cedrus::OVERFLOW_BLOCK);
+
+    Cedrus::ResponseAcquisition acquisition;
+    std::atomic<size_t> received(0);
+    acquisition.AddSubscriber([&](const Cedrus::Response &) { ++received; });
+
+    for (int i = 0; i < OVERFILL; ++i)
+        m_device.Send(1, i % 2 == 0);
+
+    // Subscribers are fed on the thread that fills the queue.
+    ASSERT_TRUE( Start(acquisition) );
+    EXPECT_TRUE( WaitFor([&]() { return received + m_manager->GetDroppedResponseCount() == OVERFILL; }) );
+    acquisition.Stop();
+
+    EXPECT_GT( m_manager->GetDroppedResponseCount(), 0u );
+}
+
+TEST_F( TestResponseAcquisition, StopReleasesAPollWaitingOnAFullQueue )
+{
+    m_manager->SetOverflowPolicy(Cedrus::OVERFLOW_BLOCK);
+
+    for (int i = 0; i < OVERFILL; ++i)
+        m_device.Send(1, i % 2 == 0);
+
+    // With no subscribers and nobody draining, the first poll waits for room.
+    Cedrus::ResponseAcquisition acquisition;
+    ASSERT_TRUE( Start(acquisition) );
+    ASSERT_TRUE( WaitFor([&]() { return m_device.m_pollCount > 0; }) );
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ( 1u, m_device.m_pollCount );
+    EXPECT_EQ( 0u, m_manager->GetDroppedResponseCount() );
+
+    acquisition.Stop();
+
+    EXPECT_FALSE( acquisition.IsRunning() );
+    EXPECT_EQ( (size_t)OVERFILL, DrainAll(*m_manager) + m_manager->GetDroppedResponseCount() );
+}
+
+// The thread that ought to drain a full queue may first want to send the
+// device a command, or change the filter. Neither may wait on the poll.
+TEST_F( TestResponseAcquisition, CommandsGetThroughWhileTheQueueIsFull )
+{
+    m_manager->SetOverflowPolicy(Cedrus::OVERFLOW_BLOCK);
+
+    for (int i = 0; i < OVERFILL; ++i)
+        m_device.Send(1, i % 2 == 0);
+
+    Cedrus::ResponseAcquisition acquisition;
+    ASSERT_TRUE( Start(acquisition) );
+    ASSERT_TRUE( WaitFor([&]() { return m_device.m_pollCount > 0; }) );
+
+    {
+        std::unique_lock<std::mutex> io_lock(m_device.m_ioMutex, std::defer_lock);
+        EXPECT_TRUE( WaitFor([&]() { return io_lock.try_lock(); }) );
+    }
+
+    m_manager->SetResponseFilter(m_manager->GetResponseFilter());
+    EXPECT_GT( m_manager->GetDroppedResponseCount(), 0u );
+
+    acquisition.Stop();
+    EXPECT_EQ( (size_t)OVERFILL, DrainAll(*m_manager) + m_manager->GetDroppedResponseCount() );
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ResponseFilter.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+namespace
+{
+    using namespace ResponseTestHelpers;
+
+    std::vector<Cedrus::Response> Drain(Cedrus::ResponseManager & manager)
+    {
+        std::vector<Cedrus::Response> responses;
+        while (manager.HasQueuedResponses())
+            responses.push_back(manager.GetNextResponse());
+
+        return responses;
+    }
+}
+
+TEST( TestResponseFilter, PassesEverythingByDefault )
+{
+    Cedrus::ResponseFilter filter;
+
+    EXPECT_TRUE( filter.PassesEverything() );
+    EXPECT_TRUE( filter.Accept(2, 5, false, 100) );
+    EXPECT_TRUE( filter.Accept(0, 0, true, 100) );
+}
+
+TEST( TestResponseFilter, MasksPortsKeysAndEdges )
+{
+    Cedrus::ResponseFilter filter;
+    filter.SetPortMask(0x1);
+    filter.SetKeyMask(0xF0);
+    filter.SetPressReleaseMask(Cedrus::ResponseFilter::PASS_PRESSES);
+
+    EXPECT_FALSE( filter.PassesEverything() );
+    EXPECT_TRUE( filter.Accept(0, 4, true, 0) );
+    EXPECT_FALSE( filter.Accept(0, 4, false, 0) );
+    EXPECT_FALSE( filter.Accept(2, 4, true, 0) );
+    EXPECT_FALSE( filter.Accept(0, 3, true, 0) );
+
+    // Beyond what the masks cover.
+    EXPECT_TRUE( filter.Accept(0, 100, true, 0) );
+    EXPECT_TRUE( filter.Accept(0, -1, true, 0) );
+}
+
+TEST( TestResponseFilter, DebounceDropsChatterPerKey )
+{
+    Cedrus::ResponseFilter filter;
+    filter.SetDebounceInterval(std::chrono::milliseconds(10));
+
+    EXPECT_TRUE( filter.Accept(0, 1, true, 1000) );
+    EXPECT_FALSE( filter.Accept(0, 1, false, 1002) );
+    EXPECT_FALSE( filter.Accept(0, 1, true, 1004) );
+    // Another key isn't held up.
+    EXPECT_TRUE( filter.Accept(0, 2, true, 1005) );
+    EXPECT_TRUE( filter.Accept(0, 1, false, 1010) );
+
+    // A reset timer starts over.
+    EXPECT_TRUE( filter.Accept(0, 1, true, 3) );
+}
+
+TEST( TestResponseFilter, FilteredResponsesAreCountedNotQueued )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    Cedrus::ResponseFilter filter;
+    filter.SetPortMask(0x1);
+    filter.SetPressReleaseMask(Cedrus::ResponseFilter::PASS_PRESSES);
+    manager.SetResponseFilter(filter);
+
+    std::vector<unsigned char> bytes;
+    AppendST2Packet(bytes, 0, 1, true, 100);
+    AppendST2Packet(bytes, 2, 0, true, 110);   // light sensor
+    AppendST2Packet(bytes, 0, 1, false, 150);
+    AppendST2Packet(bytes, 0, 3, true, 200);
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    const std::vector<Cedrus::Response> responses = Drain(manager);
+    ASSERT_EQ( 2u, responses.size() );
+    EXPECT_EQ( 100, responses[0].GetReactionTime() );
+    EXPECT_EQ( 200, responses[1].GetReactionTime() );
+
+    EXPECT_EQ( 2u, manager.GetFilteredResponseCount() );
+    EXPECT_EQ( 0u, manager.GetDroppedResponseCount() );
+    // The keys are down all the same.
+    EXPECT_EQ( 2u, manager.GetNumberOfKeysDown() );
+}
+
+TEST( TestResponseFilter, ManagerDebouncesInDeviceTime )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    Cedrus::ResponseFilter filter;
+    filter.SetDebounceInterval(std::chrono::milliseconds(20));
+    manager.SetResponseFilter(filter);
+    EXPECT_EQ( 20, manager.GetResponseFilter().GetDebounceInterval().count() );
+
+    std::vector<unsigned char> bytes;
+    for (int i = 0; i < 6; ++i)
+        AppendST2Packet(bytes, 0, 2, (i % 2) == 0, 1000 + i * 3);
+    AppendST2Packet(bytes, 0, 2, false, 1100);
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    const std::vector<Cedrus::Response> responses = Drain(manager);
+    ASSERT_EQ( 2u, responses.size() );
+    EXPECT_TRUE( responses[0].wasPressed );
+    EXPECT_EQ( 1000, responses[0].GetReactionTime() );
+    EXPECT_FALSE( responses[1].wasPressed );
+    EXPECT_EQ( 1100, responses[1].GetReactionTime() );
+    EXPECT_EQ( 5u, manager.GetFilteredResponseCount() );
+}
@@ -0,0 +1,146 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "CedrusAssert.h"
+#include "ResponseParserFuzzing.h"
+
+namespace
+{
+    // Mostly bytes that look like part of a packet, so the parser latches on
+    // to plenty of false starts.
+    std::vector<unsigned char> FuzzInput(std::mt19937 & rng, bool st2, size_t garbageSize)
+    {
+        static const unsigned char likely[] = { 'k', 'o', 0, 0, 0, 0x10, 0x30, '1', '0' };
+
+        std::vector<unsigned char> input;
+        input.push_back(st2 ? 1 : 0);
+        input.push_back(static_cast<unsigned char>(rng()));
+
+        for (size_t i = 0; i < garbageSize; ++i)
+        {
+            const unsigned int pick = rng();
+            input.push_back((pick & 1) ? likely[(pick >> 1) % sizeof(likely)] : static_cast<unsigned char>(pick >> 8));
+        }
+
+        return input;
+    }
+
+    ResponseParserFuzzing::Outcome RunWithGarbage(bool st2, const std::vector<unsigned char> & garbage, unsigned char bytesPerPoll)
+    {
+        std::vector<unsigned char> input;
+        input.push_back(st2 ? 1 : 0);
+        input.push_back(bytesPerPoll - 1);
+        input.insert(input.end(), garbage.begin(), garbage.end());
+
+        return ResponseParserFuzzing::Run(input.data(), input.size());
+    }
+}
+
+TEST( TestResponseParserFuzzing, CleanStreamLosesNothing )
+{
+    for (int st2 = 0; st2 < 2; ++st2)
+    {
+        const ResponseParserFuzzing::Outcome outcome = RunWithGarbage(st2 != 0, std::vector<unsigned char>(), 64);
+
+        EXPECT_TRUE( outcome.intact );
+        EXPECT_EQ( 0u, outcome.realPacketsLost );
+        EXPECT_EQ( 1u, outcome.pollsToResync );
+    }
+}
+
+// A sync byte right at the end of the garbage makes a false packet out of
+// the start of the first real one.
+TEST( TestResponseParserFuzzing, FalseStartCostsAtMostOnePacket )
+{
+    Cedrus::Suppress_All_Assertions();
+
+    std::vector<unsigned char> garbage;
+    garbage.push_back(0x55);
+    garbage.push_back('k');
+    garbage.push_back(0);
+
+    ResponseParserFuzzing::Outcome outcome = RunWithGarbage(false, garbage, 1);
+    EXPECT_TRUE( outcome.intact );
+    EXPECT_EQ( 1u, outcome.realPacketsLost );
+    EXPECT_EQ( 2u * ResponseParserFuzzing::XID_PACKET_SIZE, outcome.bytesToResync );
+    EXPECT_EQ( outcome.bytesToResync, outcome.pollsToResync );
+
+    garbage.clear();
+    garbage.push_back('o');
+
+    outcome = RunWithGarbage(true, garbage, 1);
+    EXPECT_TRUE( outcome.intact );
+    EXPECT_EQ( 1u, outcome.realPacketsLost );
+    EXPECT_EQ( 2u * ResponseParserFuzzing::ST2_PACKET_SIZE, outcome.bytesToResync );
+
+    Cedrus::UnSuppress_All_Assertions();
+}
+
+// What the fuzz target checks, over a fixed set of inputs so it runs with
+// the rest of the tests. Some garbage is longer than the input ring.
+TEST( TestResponseParserFuzzing, SeededGarbageResyncsWithinOnePacket )
+{
+    enum { NUM_INPUTS = 4000 };
+    enum { MAX_GARBAGE = 700 };
+
+    Cedrus::Suppress_All_Assertions();
+
+    std::mt19937 rng(20100401);
+    unsigned int worst_bytes[2] = { 0, 0 };
+    unsigned int worst_polls[2] = { 0, 0 };
+
+    for (int i = 0; i < NUM_INPUTS; ++i)
+    {
+        const bool st2 = (i % 2) != 0;
+        const std::vector<unsigned char> input = FuzzInput(rng, st2, rng() % MAX_GARBAGE);
+        const ResponseParserFuzzing::Outcome outcome = ResponseParserFuzzing::Run(input.data(), input.size());
+
+        ASSERT_TRUE( outcome.intact ) << "input " << i << " lost " << outcome.realPacketsLost;
+
+        worst_bytes[st2] = std::max(worst_bytes[st2], outcome.bytesToResync);
+        worst_polls[st2] = std::max(worst_polls[st2], outcome.pollsToResync);
+    }
+
+    Cedrus::UnSuppress_All_Assertions();
+
+    // Two packets' worth, however the reads fall.
+    EXPECT_LE( worst_bytes[0], 2u * ResponseParserFuzzing::XID_PACKET_SIZE + ResponseParserFuzzing::MAX_BYTES_PER_POLL );
+    EXPECT_LE( worst_bytes[1], 2u * ResponseParserFuzzing::ST2_PACKET_SIZE + ResponseParserFuzzing::MAX_BYTES_PER_POLL );
+
+    std::printf("worst resync after garbage: XID %u bytes / %u polls, ST2 %u bytes / %u polls\n",
+        worst_bytes[0], worst_polls[0], worst_bytes[1], worst_polls[1]);
+}
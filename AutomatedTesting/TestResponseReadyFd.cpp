@@ -0,0 +1,166 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#if !defined(_WIN32)
+
+#include <poll.h>
+
+#include <chrono>
+#include <thread>
+
+#include "ReadinessNotifier.h"
+#include "ResponseFilter.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+namespace
+{
+    using namespace ResponseTestHelpers;
+
+    bool IsReadable(int fd, int timeoutMs = 0)
+    {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        return poll(&pfd, 1, timeoutMs) == 1 && (pfd.revents & POLLIN) != 0;
+    }
+}
+
+TEST( TestResponseReadyFd, ReadableWhileResponsesAreQueued )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    const int fd = manager.GetReadyFd();
+    ASSERT_GE( fd, 0 );
+    EXPECT_EQ( fd, manager.GetReadyFd() );
+    EXPECT_FALSE( IsReadable(fd) );
+
+    FeedST2Press(manager, 1);
+    FeedST2Press(manager, 2);
+    EXPECT_TRUE( IsReadable(fd) );
+
+    // Still readable until the last one is taken.
+    manager.GetNextResponse();
+    EXPECT_TRUE( IsReadable(fd) );
+
+    Cedrus::Response batch[4];
+    EXPECT_EQ( 1u, manager.GetResponses(batch, 4) );
+    EXPECT_FALSE( IsReadable(fd) );
+
+    FeedST2Press(manager, 3);
+    EXPECT_TRUE( IsReadable(fd) );
+    manager.ClearResponseQueue();
+    EXPECT_FALSE( IsReadable(fd) );
+}
+
+TEST( TestResponseReadyFd, ResponsesQueuedBeforehandCount )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+    FeedST2Press(manager, 1);
+
+    EXPECT_TRUE( IsReadable(manager.GetReadyFd()) );
+}
+
+TEST( TestResponseReadyFd, FilteredResponsesLeaveItUnreadable )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    Cedrus::ResponseFilter filter;
+    filter.SetPressReleaseMask(Cedrus::ResponseFilter::PASS_RELEASES);
+    manager.SetResponseFilter(filter);
+
+    const int fd = manager.GetReadyFd();
+    FeedST2Press(manager, 1);
+
+    EXPECT_FALSE( IsReadable(fd) );
+}
+
+TEST( TestResponseReadyFd, SharedAcrossManagers )
+{
+    Cedrus::ResponseManager first(StimTrackerQuad());
+    const int fd = first.GetReadyFd();
+
+    Cedrus::ResponseManager second(StimTrackerQuad());
+    second.SetReadinessNotifier(first.GetReadinessNotifier());
+    EXPECT_EQ( fd, second.GetReadyFd() );
+
+    FeedST2Press(second, 4);
+    EXPECT_TRUE( IsReadable(fd) );
+}
+
+TEST( TestResponseReadyFd, PollWakesWhenAnotherThreadQueues )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+    const int fd = manager.GetReadyFd();
+
+    std::thread feeder([&manager]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        FeedST2Press(manager, 5);
+    });
+
+    EXPECT_TRUE( IsReadable(fd, 5000) );
+    EXPECT_EQ( 5, manager.GetNextResponse().key );
+    EXPECT_FALSE( IsReadable(fd) );
+
+    feeder.join();
+}
+
+// Taking responses as fast as they come never leaves one stranded behind an
+// unreadable descriptor.
+TEST( TestResponseReadyFd, NoResponseIsStrandedUnderContention )
+{
+    enum { NUM_RESPONSES = 20000 };
+
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+    const int fd = manager.GetReadyFd();
+
+    std::thread feeder([&manager]()
+    {
+        for (int i = 0; i < NUM_RESPONSES; ++i)
+        {
+            FeedST2Press(manager, i % 16);
+            if (i % 64 == 0)
+                std::this_thread::yield();
+        }
+    });
+
+    int taken = 0;
+    Cedrus::Response batch[32];
+    while (taken < NUM_RESPONSES && IsReadable(fd, 5000))
+        taken += static_cast<int>(manager.GetResponses(batch, 32));
+
+    feeder.join();
+    EXPECT_EQ( NUM_RESPONSES, taken );
+}
+
+#endif // !_WIN32
@@ -0,0 +1,205 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "ResyncScanner.h"
+
+#include "ResponseTestHelpers.h"
+
+namespace
+{
+    void AppendXidPacket(std::vector<unsigned char> & bytes, unsigned int rt)
+    {
+        ResponseTestHelpers::AppendXidPacket(bytes, 0, 1, true, rt);
+    }
+
+    void AppendST2Packet(std::vector<unsigned char> & bytes, unsigned int rt)
+    {
+        ResponseTestHelpers::AppendST2Packet(bytes, 0, 3, true, rt);
+    }
+
+    // Noise that's heavy on the sync bytes, so that plenty of false starts
+    // get past the first check.
+    std::vector<unsigned char> Junk(unsigned int size, unsigned int seed)
+    {
+        static const unsigned char alphabet[] = { 'k', 'o', 0, '1', '0', 0x08, 0x30, 0xFF };
+
+        std::vector<unsigned char> bytes;
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            bytes.push_back(alphabet[(seed >> 16) % sizeof(alphabet)]);
+        }
+
+        return bytes;
+    }
+
+    unsigned int Xid(const std::vector<unsigned char> & bytes, bool requireZeroLastByte = true)
+    {
+        const unsigned int simd = Cedrus::FindXidResyncOffset(bytes.data(), static_cast<unsigned int>(bytes.size()), requireZeroLastByte);
+        EXPECT_EQ( Cedrus::FindXidResyncOffset_Scalar(bytes.data(), static_cast<unsigned int>(bytes.size()), requireZeroLastByte), simd );
+        return simd;
+    }
+
+    unsigned int ST2(const std::vector<unsigned char> & bytes)
+    {
+        const unsigned int simd = Cedrus::FindST2ResyncOffset(bytes.data(), static_cast<unsigned int>(bytes.size()));
+        EXPECT_EQ( Cedrus::FindST2ResyncOffset_Scalar(bytes.data(), static_cast<unsigned int>(bytes.size())), simd );
+        return simd;
+    }
+}
+
+TEST( TestResyncScanner, NothingToFindDropsEverything )
+{
+    const std::vector<unsigned char> bytes(100, 0x55);
+
+    EXPECT_EQ( 100u, Xid(bytes) );
+    EXPECT_EQ( 100u, ST2(bytes) );
+}
+
+TEST( TestResyncScanner, SkipsFalseStartsForARealPacketRun )
+{
+    std::vector<unsigned char> bytes(3, 0x55);
+    // A 'k' with port bits set, then one that would run into the real packets.
+    bytes.push_back('k');
+    bytes.push_back(0x08);
+    bytes.push_back('k');
+    bytes.push_back(0x00);
+    bytes.push_back(0x55);
+    const unsigned int real_start = static_cast<unsigned int>(bytes.size());
+    AppendXidPacket(bytes, 100);
+    AppendXidPacket(bytes, 200);
+
+    EXPECT_EQ( real_start, Xid(bytes, false) );
+}
+
+// Junk after a packet doesn't make it any less of a packet.
+TEST( TestResyncScanner, KeepsTheEarliestOfSeparateCandidates )
+{
+    std::vector<unsigned char> bytes(20, 0x55);
+    AppendXidPacket(bytes, 100);
+    bytes.push_back(0x55);
+    AppendXidPacket(bytes, 200);
+    AppendXidPacket(bytes, 300);
+
+    EXPECT_EQ( 20u, Xid(bytes) );
+}
+
+TEST( TestResyncScanner, FallsBackToTheFirstLonePacket )
+{
+    std::vector<unsigned char> bytes(20, 0x55);
+    AppendXidPacket(bytes, 100);
+    bytes.resize(bytes.size() + 20, 0x55);
+
+    EXPECT_EQ( 20u, Xid(bytes) );
+}
+
+TEST( TestResyncScanner, KeepsAPartialPacketAtTheEnd )
+{
+    std::vector<unsigned char> bytes(50, 0x55);
+    bytes.push_back('k');
+    bytes.push_back(0x20);
+
+    EXPECT_EQ( 50u, Xid(bytes) );
+}
+
+TEST( TestResyncScanner, NonzeroLastByteOnlyMattersWhenAskedTo )
+{
+    std::vector<unsigned char> bytes(30, 0x55);
+    const unsigned char late_packet[6] = { 'k', 0x20, 1, 2, 3, 4 };
+    bytes.insert(bytes.end(), late_packet, late_packet + sizeof(late_packet));
+    bytes.insert(bytes.end(), late_packet, late_packet + sizeof(late_packet));
+
+    EXPECT_EQ( 42u, Xid(bytes, true) );
+    EXPECT_EQ( 30u, Xid(bytes, false) );
+}
+
+TEST( TestResyncScanner, ST2NeedsStateAndTerminator )
+{
+    std::vector<unsigned char> bytes(10, 0x55);
+    const unsigned char bad_state[9] = { 'o', 0, 1, 'x', 0, 0, 0, 0, 0 };
+    bytes.insert(bytes.end(), bad_state, bad_state + sizeof(bad_state));
+    AppendST2Packet(bytes, 1);
+    AppendST2Packet(bytes, 2);
+
+    EXPECT_EQ( 19u, ST2(bytes) );
+}
+
+// Whatever the vector code finds, the scalar code must find the same, at
+// every length and alignment.
+TEST( TestResyncScanner, VectorAndScalarAgreeOnNoise )
+{
+    for (unsigned int seed = 1; seed <= 200; ++seed)
+    {
+        const std::vector<unsigned char> junk = Junk(seed * 3, seed);
+
+        for (unsigned int start = 0; start < 8 && start < junk.size(); ++start)
+        {
+            const std::vector<unsigned char> bytes(junk.begin() + start, junk.end());
+            Xid(bytes, true);
+            Xid(bytes, false);
+            ST2(bytes);
+        }
+    }
+}
+
+TEST( TestResyncScanner, ScannerThroughput )
+{
+    enum { NUM_PASSES = 200 };
+
+    std::vector<unsigned char> bytes(64 * 1024, 0x55);
+    AppendST2Packet(bytes, 1);
+    AppendST2Packet(bytes, 2);
+    const unsigned int count = static_cast<unsigned int>(bytes.size());
+
+    unsigned long long scalar_sum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+        scalar_sum += Cedrus::FindST2ResyncOffset_Scalar(bytes.data() + (pass & 1), count - (pass & 1));
+    const std::chrono::duration<double> scalar_elapsed = std::chrono::steady_clock::now() - start;
+
+    unsigned long long simd_sum = 0;
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+        simd_sum += Cedrus::FindST2ResyncOffset(bytes.data() + (pass & 1), count - (pass & 1));
+    const std::chrono::duration<double> simd_elapsed = std::chrono::steady_clock::now() - start;
+
+    EXPECT_EQ( scalar_sum, simd_sum );
+
+    const double megabytes = static_cast<double>(count) * NUM_PASSES / (1024.0 * 1024.0);
+    std::printf("resync scan over 64 KB: scalar %.0f MB/s, vector %.0f MB/s\n",
+        megabytes / scalar_elapsed.count(), megabytes / simd_elapsed.count());
+}
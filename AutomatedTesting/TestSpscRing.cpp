@@ -0,0 +1,217 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+
+#include "SpscRing.h"
+
+TEST( TestSpscRing, CapacityRoundsUpToPowerOfTwo )
+{
+    Cedrus::SpscRing<int> ring(100);
+
+    EXPECT_EQ( 128u, ring.Capacity() );
+    EXPECT_TRUE( ring.IsEmpty() );
+}
+
+TEST( TestSpscRing, PopsInPushOrder )
+{
+    Cedrus::SpscRing<int> ring(4);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_TRUE( ring.Push(i) );
+        EXPECT_TRUE( ring.Push(i + 100) );
+
+        int item = -1;
+        EXPECT_TRUE( ring.Pop(item) );
+        EXPECT_EQ( i, item );
+        EXPECT_TRUE( ring.Pop(item) );
+        EXPECT_EQ( i + 100, item );
+        EXPECT_FALSE( ring.Pop(item) );
+    }
+}
+
+TEST( TestSpscRing, DropNewestKeepsQueuedItems )
+{
+    Cedrus::SpscRing<int> ring(4, Cedrus::OVERFLOW_DROP_NEWEST);
+
+    for (int i = 0; i < 6; ++i)
+        ring.Push(i);
+
+    EXPECT_EQ( 4u, ring.Size() );
+    EXPECT_EQ( 2u, ring.GetOverflowCount() );
+
+    int item = -1;
+    for (int i = 0; i < 4; ++i)
+    {
+        ASSERT_TRUE( ring.Pop(item) );
+        EXPECT_EQ( i, item );
+    }
+}
+
+TEST( TestSpscRing, DropOldestKeepsNewestItems )
+{
+    Cedrus::SpscRing<int> ring(4, Cedrus::OVERFLOW_DROP_OLDEST);
+
+    for (int i = 0; i < 6; ++i)
+        EXPECT_TRUE( ring.Push(i) );
+
+    EXPECT_EQ( 4u, ring.Size() );
+    EXPECT_EQ( 2u, ring.GetOverflowCount() );
+
+    int item = -1;
+    for (int i = 2; i < 6; ++i)
+    {
+        ASSERT_TRUE( ring.Pop(item) );
+        EXPECT_EQ( i, item );
+    }
+}
+
+TEST( TestSpscRing, PopBatchStopsAtWhatIsThere )
+{
+    Cedrus::SpscRing<int> ring(8);
+
+    for (int i = 0; i < 11; ++i)
+    {
+        ring.Push(i);
+        if (i == 4)
+        {
+            int discard[3];
+            EXPECT_EQ( 3u, ring.PopBatch(discard, 3) );
+        }
+    }
+
+    // The rest wraps around the end of the slots.
+    int items[16];
+    ASSERT_EQ( 8u, ring.PopBatch(items, 16) );
+    for (int i = 0; i < 8; ++i)
+        EXPECT_EQ( i + 3, items[i] );
+
+    EXPECT_EQ( 0u, ring.PopBatch(items, 16) );
+}
+
+TEST( TestSpscRing, ClearEmptiesTheRing )
+{
+    Cedrus::SpscRing<int> ring(8);
+
+    for (int i = 0; i < 5; ++i)
+        ring.Push(i);
+
+    ring.Clear();
+
+    int item = -1;
+    EXPECT_TRUE( ring.IsEmpty() );
+    EXPECT_FALSE( ring.Pop(item) );
+}
+
+// Blocking hands every item across in order, however small the ring.
+TEST( TestSpscRing, BlockingPolicyLosesNothingAcrossThreads )
+{
+    enum { NUM_ITEMS = 20000 };
+    Cedrus::SpscRing<unsigned int> ring(16, Cedrus::OVERFLOW_BLOCK);
+
+    std::thread producer([&ring]()
+    {
+        for (unsigned int i = 0; i < NUM_ITEMS; ++i)
+            ring.Push(i);
+    });
+
+    unsigned int expected = 0;
+    while (expected < NUM_ITEMS)
+    {
+        unsigned int item = 0;
+        if (ring.Pop(item))
+        {
+            ASSERT_EQ( expected, item );
+            ++expected;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    EXPECT_EQ( 0u, ring.GetOverflowCount() );
+}
+
+// With nobody popping, a bounded blocking push drops the item in the end.
+TEST( TestSpscRing, BoundedBlockingPushGivesUp )
+{
+    Cedrus::SpscRing<int> ring(4, Cedrus::OVERFLOW_BLOCK);
+
+    for (int i = 0; i < 4; ++i)
+        EXPECT_TRUE( ring.Push(i) );
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_FALSE( ring.Push(4, std::chrono::milliseconds(5)) );
+    EXPECT_GE( std::chrono::steady_clock::now() - start, std::chrono::milliseconds(5) );
+    EXPECT_FALSE( ring.Push(5, std::chrono::steady_clock::duration::zero()) );
+
+    EXPECT_EQ( 2u, ring.GetOverflowCount() );
+    EXPECT_EQ( 4u, ring.Size() );
+}
+
+// Whatever survives dropping must still come out in order and add up.
+TEST( TestSpscRing, DropOldestStaysOrderedAcrossThreads )
+{
+    enum { NUM_ITEMS = 20000 };
+    Cedrus::SpscRing<unsigned int> ring(16, Cedrus::OVERFLOW_DROP_OLDEST);
+
+    std::thread producer([&ring]()
+    {
+        for (unsigned int i = 1; i <= NUM_ITEMS; ++i)
+            ring.Push(i);
+    });
+
+    unsigned int last = 0;
+    unsigned long long received = 0;
+    while (last < NUM_ITEMS)
+    {
+        unsigned int item = 0;
+        if (ring.Pop(item))
+        {
+            ASSERT_GT( item, last );
+            last = item;
+            ++received;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+    EXPECT_EQ( static_cast<unsigned long long>(NUM_ITEMS), received + ring.GetOverflowCount() );
+}
@@ -0,0 +1,276 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include "CedrusAssert.h"
+#include "ResponseManager.h"
+#include "constants.h"
+
+#include "ResponseTestHelpers.h"
+
+using namespace ResponseTestHelpers;
+
+class TestStreamingResponseParser : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        m_rb840 = RB840();
+        m_st2 = StimTrackerQuad();
+    }
+
+    std::shared_ptr<const Cedrus::DeviceConfig> m_rb840;
+    std::shared_ptr<const Cedrus::DeviceConfig> m_st2;
+};
+
+TEST_F( TestStreamingResponseParser, BurstIsParsedInOnePass )
+{
+    Cedrus::ResponseManager manager(m_st2);
+
+    std::vector<unsigned char> bytes;
+    for (int line = 0; line < 16; ++line)
+    {
+        AppendST2Packet(bytes, 0, line, true, 1000 + line);
+        AppendST2Packet(bytes, 0, line, false, 2000 + line);
+    }
+
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    for (int line = 0; line < 16; ++line)
+    {
+        ASSERT_TRUE( manager.HasQueuedResponses() );
+        Cedrus::Response pressed = manager.GetNextResponse();
+        EXPECT_EQ( line, pressed.key );
+        EXPECT_TRUE( pressed.wasPressed );
+        EXPECT_EQ( 1000 + line, pressed.GetReactionTime() );
+
+        ASSERT_TRUE( manager.HasQueuedResponses() );
+        Cedrus::Response released = manager.GetNextResponse();
+        EXPECT_EQ( line, released.key );
+        EXPECT_FALSE( released.wasPressed );
+        EXPECT_EQ( 2000 + line, released.GetReactionTime() );
+    }
+
+    EXPECT_FALSE( manager.HasQueuedResponses() );
+    EXPECT_EQ( 0u, manager.GetNumberOfKeysDown() );
+}
+
+TEST_F( TestStreamingResponseParser, PacketSplitAcrossReads )
+{
+    Cedrus::ResponseManager manager(m_rb840);
+
+    std::vector<unsigned char> bytes;
+    AppendXidPacket(bytes, 0, 3, true, 4660);
+    AppendXidPacket(bytes, 0, 3, false, 4700);
+
+    // Every possible split point, one byte at a time at worst.
+    for (unsigned int i = 0; i < bytes.size(); ++i)
+    {
+        manager.FeedInput(&bytes[i], 1);
+        EXPECT_EQ( i >= 5, manager.HasQueuedResponses() ) << i;
+    }
+
+    Cedrus::Response pressed = manager.GetNextResponse();
+    EXPECT_EQ( m_rb840->GetMappedKey(0, 3), pressed.key );
+    EXPECT_TRUE( pressed.wasPressed );
+    EXPECT_EQ( 4660, pressed.GetReactionTime() );
+
+    Cedrus::Response released = manager.GetNextResponse();
+    EXPECT_FALSE( released.wasPressed );
+    EXPECT_EQ( 4700, released.GetReactionTime() );
+
+    EXPECT_FALSE( manager.HasQueuedResponses() );
+}
+
+TEST_F( TestStreamingResponseParser, RecoversFromJunkBetweenPackets )
+{
+    Cedrus::Suppress_All_Assertions();
+
+    Cedrus::ResponseManager manager(m_rb840);
+
+    std::vector<unsigned char> bytes;
+    bytes.push_back('_');
+    bytes.push_back('x');
+    AppendXidPacket(bytes, 0, 1, true, 10);
+    bytes.push_back(0x55);
+    AppendXidPacket(bytes, 0, 1, false, 20);
+
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    ASSERT_TRUE( manager.HasQueuedResponses() );
+    EXPECT_EQ( 10, manager.GetNextResponse().GetReactionTime() );
+    ASSERT_TRUE( manager.HasQueuedResponses() );
+    EXPECT_EQ( 20, manager.GetNextResponse().GetReactionTime() );
+    EXPECT_FALSE( manager.HasQueuedResponses() );
+
+    Cedrus::UnSuppress_All_Assertions();
+}
+
+TEST_F( TestStreamingResponseParser, ST2PacketWithBadTerminatorIsSkipped )
+{
+    Cedrus::ResponseManager manager(m_st2);
+
+    std::vector<unsigned char> bytes;
+    AppendST2Packet(bytes, 0, 2, true, 30);
+    bytes.back() = 'x';
+    AppendST2Packet(bytes, 0, 4, true, 40);
+
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    ASSERT_TRUE( manager.HasQueuedResponses() );
+    Cedrus::Response res = manager.GetNextResponse();
+    EXPECT_EQ( 4, res.key );
+    EXPECT_EQ( 40, res.GetReactionTime() );
+    EXPECT_FALSE( manager.HasQueuedResponses() );
+}
+
+TEST_F( TestStreamingResponseParser, MoreThanTheRingHoldsAtOnce )
+{
+    Cedrus::ResponseManager manager(m_st2);
+
+    std::vector<unsigned char> bytes;
+    for (int i = 0; i < 1000; ++i)
+        AppendST2Packet(bytes, 0, i % 16, (i % 2) == 0, i);
+
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        ASSERT_TRUE( manager.HasQueuedResponses() );
+        EXPECT_EQ( i, manager.GetNextResponse().GetReactionTime() );
+    }
+}
+
+TEST_F( TestStreamingResponseParser, ResponseTakesTheTimeOfItsLastBytes )
+{
+    Cedrus::ResponseManager manager(m_rb840);
+
+    std::vector<unsigned char> bytes;
+    AppendXidPacket(bytes, 0, 1, true, 100);
+
+    const std::chrono::steady_clock::time_point first_read = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point second_read = first_read + std::chrono::milliseconds(3);
+    manager.FeedInput(bytes.data(), 4, first_read);
+    manager.FeedInput(bytes.data() + 4, 2, second_read);
+
+    ASSERT_TRUE( manager.HasQueuedResponses() );
+    EXPECT_TRUE( second_read == manager.GetNextResponse().hostTime );
+}
+
+TEST_F( TestStreamingResponseParser, GetResponsesTakesABatchInOrder )
+{
+    Cedrus::ResponseManager manager(m_st2);
+
+    std::vector<unsigned char> bytes;
+    for (int i = 0; i < 10; ++i)
+        AppendST2Packet(bytes, 0, i, true, 100 + i);
+
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    Cedrus::Response batch[4];
+    int next = 0;
+    size_t count;
+    while ((count = manager.GetResponses(batch, 4)) > 0)
+    {
+        EXPECT_LE( count, 4u );
+        for (size_t i = 0; i < count; ++i, ++next)
+        {
+            EXPECT_EQ( next, batch[i].key );
+            EXPECT_EQ( 100 + next, batch[i].GetReactionTime() );
+        }
+    }
+
+    EXPECT_EQ( 10, next );
+    EXPECT_FALSE( manager.HasQueuedResponses() );
+}
+
+TEST_F( TestStreamingResponseParser, KeyStateFollowsPressesAndReleases )
+{
+    Cedrus::ResponseManager manager(m_st2);
+
+    std::vector<unsigned char> bytes;
+    AppendST2Packet(bytes, 0, 1, true, 10);
+    AppendST2Packet(bytes, 0, 3, true, 20);
+    AppendST2Packet(bytes, 1, 0, true, 30);
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    EXPECT_EQ( 0xAull, manager.GetKeysDownMask(0) );
+    EXPECT_EQ( 0x1ull, manager.GetKeysDownMask(1) );
+    EXPECT_TRUE( manager.IsKeyDown(0, 3) );
+    EXPECT_FALSE( manager.IsKeyDown(0, 2) );
+    EXPECT_EQ( 3u, manager.GetNumberOfKeysDown() );
+
+    bytes.clear();
+    AppendST2Packet(bytes, 0, 1, false, 40);
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    EXPECT_EQ( 0x8ull, manager.GetKeysDownMask(0) );
+    EXPECT_FALSE( manager.IsKeyDown(0, 1) );
+    EXPECT_EQ( 2u, manager.GetNumberOfKeysDown() );
+    EXPECT_EQ( 0u, manager.GetImpossibleTransitionCount() );
+
+    // Out of range reads as up rather than going anywhere it shouldn't.
+    EXPECT_FALSE( manager.IsKeyDown(-1, 0) );
+    EXPECT_FALSE( manager.IsKeyDown(0, 64) );
+    EXPECT_EQ( 0ull, manager.GetKeysDownMask(99) );
+}
+
+TEST_F( TestStreamingResponseParser, ImpossibleTransitionsAreCountedNotApplied )
+{
+    Cedrus::ResponseManager manager(m_st2);
+
+    // The press that went with this release was lost.
+    std::vector<unsigned char> bytes;
+    AppendST2Packet(bytes, 0, 2, false, 10);
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    EXPECT_EQ( 1u, manager.GetImpossibleTransitionCount() );
+    EXPECT_EQ( 0u, manager.GetNumberOfKeysDown() );
+
+    // And here the release between two presses was.
+    bytes.clear();
+    AppendST2Packet(bytes, 0, 2, true, 20);
+    AppendST2Packet(bytes, 0, 2, true, 30);
+    manager.FeedInput(bytes.data(), static_cast<unsigned int>(bytes.size()));
+
+    EXPECT_EQ( 2u, manager.GetImpossibleTransitionCount() );
+    EXPECT_EQ( 1u, manager.GetNumberOfKeysDown() );
+    EXPECT_TRUE( manager.IsKeyDown(0, 2) );
+
+    // Every response is still queued.
+    Cedrus::Response batch[8];
+    EXPECT_EQ( 3u, manager.GetResponses(batch, 8) );
+}
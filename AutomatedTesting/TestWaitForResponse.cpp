@@ -0,0 +1,190 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+#include "ResponseFilter.h"
+#include "ResponseManager.h"
+
+#include "ResponseTestHelpers.h"
+
+namespace
+{
+    using namespace ResponseTestHelpers;
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TEST( TestWaitForResponse, TimesOutWhenNothingArrives )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_FALSE( manager.WaitForResponse(start + std::chrono::milliseconds(20)) );
+    EXPECT_GE( MillisecondsSince(start), 19.0 );
+}
+
+TEST( TestWaitForResponse, ReturnsAtOnceWhenSomethingIsQueued )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+    FeedST2Press(manager, 1);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_TRUE( manager.WaitForResponse(start + std::chrono::seconds(5)) );
+    EXPECT_LT( MillisecondsSince(start), 1000.0 );
+}
+
+TEST( TestWaitForResponse, WakesWhenAnotherThreadQueues )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    std::thread feeder([&manager]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        FeedST2Press(manager, 2);
+    });
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    EXPECT_TRUE( manager.WaitForResponse(start + std::chrono::seconds(5)) );
+    EXPECT_LT( MillisecondsSince(start), 1000.0 );
+    EXPECT_EQ( 2, manager.GetNextResponse().key );
+
+    feeder.join();
+}
+
+TEST( TestWaitForResponse, ArrivalsAreCountedAcrossManagers )
+{
+    Cedrus::ResponseManager first(StimTrackerQuad());
+    Cedrus::ResponseManager second(StimTrackerQuad());
+
+    const unsigned long long seen = Cedrus::ResponseManager::GetArrivalCount();
+    FeedST2Press(second, 3);
+
+    EXPECT_TRUE( Cedrus::ResponseManager::WaitForArrival(seen, std::chrono::steady_clock::now()) );
+    EXPECT_FALSE( first.HasQueuedResponses() );
+    EXPECT_TRUE( second.HasQueuedResponses() );
+}
+
+TEST( TestWaitForResponse, FilteredResponsesDontWakeAnyone )
+{
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    Cedrus::ResponseFilter filter;
+    filter.SetKeyMask(0);
+    manager.SetResponseFilter(filter);
+
+    const unsigned long long seen = Cedrus::ResponseManager::GetArrivalCount();
+    FeedST2Press(manager, 1);
+
+    EXPECT_EQ( seen, Cedrus::ResponseManager::GetArrivalCount() );
+    EXPECT_FALSE( manager.WaitForResponse(std::chrono::steady_clock::now() + std::chrono::milliseconds(5)) );
+}
+
+// What a waiting thread costs, and how long after a response is queued it
+// gets going, sleeping in WaitForResponse() versus looping on
+// HasQueuedResponses() as PollForResponse() callers do.
+TEST( TestWaitForResponse, WakeupLatencyVersusSpinning )
+{
+    enum { NUM_RESPONSES = 100 };
+    enum { IDLE_MS = 200 };
+
+    Cedrus::ResponseManager manager(StimTrackerQuad());
+
+    for (int spinning = 0; spinning < 2; ++spinning)
+    {
+        // CPU use while nothing happens.
+        const std::clock_t idle_cpu_start = std::clock();
+        const std::chrono::steady_clock::time_point idle_start = std::chrono::steady_clock::now();
+        const std::chrono::steady_clock::time_point idle_end = idle_start + std::chrono::milliseconds(IDLE_MS);
+        if (spinning)
+        {
+            while (!manager.HasQueuedResponses() && std::chrono::steady_clock::now() < idle_end)
+                std::this_thread::yield();
+        }
+        else
+        {
+            manager.WaitForResponse(idle_end);
+        }
+        const double idle_cpu_percent = 100.0 * (std::clock() - idle_cpu_start) / CLOCKS_PER_SEC / (MillisecondsSince(idle_start) / 1000.0);
+
+        std::vector<double> wakeup_us;
+        std::atomic<bool> done(false);
+        std::thread feeder([&manager, &done]()
+        {
+            for (int i = 0; i < NUM_RESPONSES; ++i)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                FeedST2Press(manager, i % 16);
+            }
+            done = true;
+        });
+
+        while (wakeup_us.size() < NUM_RESPONSES)
+        {
+            if (spinning)
+            {
+                while (!manager.HasQueuedResponses())
+                    std::this_thread::yield();
+            }
+            else if (!manager.WaitForResponse(std::chrono::steady_clock::now() + std::chrono::seconds(5)))
+            {
+                break;
+            }
+
+            const Cedrus::Response res = manager.GetNextResponse();
+            wakeup_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - res.hostTime).count());
+        }
+
+        feeder.join();
+        ASSERT_EQ( static_cast<size_t>(NUM_RESPONSES), wakeup_us.size() );
+
+        std::sort(wakeup_us.begin(), wakeup_us.end());
+        std::printf("%s: idle CPU %.0f%%, wakeup median %.0f us, 99th percentile %.0f us\n",
+            spinning ? "spinning on HasQueuedResponses" : "WaitForResponse",
+            idle_cpu_percent, wakeup_us[NUM_RESPONSES / 2], wakeup_us[NUM_RESPONSES * 99 / 100]);
+
+        if (!spinning)
+        {
+            EXPECT_LT( idle_cpu_percent, 50.0 );
+        }
+    }
+}
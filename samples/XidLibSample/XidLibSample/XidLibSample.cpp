@@ -53,7 +53,7 @@ int main()
                     // and this lets you know which one it was.
                     << "\nPressed: " << resp.wasPressed
                     // The response time is measured in ms since the last timer reset.
-                    << "\nReaction Time: " << resp.reactionTime << std::endl;
+                    << "\nReaction Time: " << resp.GetReactionTime() << std::endl;
 
                 ++responses;
             }
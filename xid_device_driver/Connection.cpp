@@ -35,6 +35,8 @@
 
 #include "constants.h"
 
+#include <algorithm>
+
 Cedrus::Connection::Connection(
     const DWORD location,
     DWORD port_speed,
@@ -49,6 +51,9 @@ Cedrus::Connection::Connection(
     m_Location(location),
     m_ConnectionDead(false),
     m_cmdThroughputLimit(3),
+    m_readTimeout(50),
+    m_hasReadDeadline(false),
+    m_cancelFlag(nullptr),
     m_DeviceHandle(nullptr)
 {
 }
@@ -61,6 +66,8 @@ Cedrus::Connection::~Connection(void)
 
 bool Cedrus::Connection::Close()
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
     DWORD close_status = FT_OK;
 
     // Don't bother if the handle is already null
@@ -75,16 +82,20 @@ bool Cedrus::Connection::Close()
 
 bool Cedrus::Connection::FlushWriteToDeviceBuffer()
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
     return (FT_Purge(m_DeviceHandle, FT_PURGE_TX) == FT_OK);
 }
 
 bool Cedrus::Connection::FlushReadFromDeviceBuffer()
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
     return (FT_Purge(m_DeviceHandle, FT_PURGE_RX) == FT_OK);
 }
 
 int Cedrus::Connection::Open()
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
     int status = XID_NO_ERR;
 
     // Erring on the side of caution in case we already have a handle.
@@ -117,7 +128,8 @@ bool Cedrus::Connection::SetupCOMPort()
     FT_SetBaudRate(m_DeviceHandle, m_BaudRate);
     FT_SetDataCharacteristics(m_DeviceHandle, m_ByteSize, m_StopBits, m_BitParity);
 
-    FT_SetTimeouts(m_DeviceHandle, 50, 50);
+    m_readTimeout = 50;
+    FT_SetTimeouts(m_DeviceHandle, m_readTimeout, 50);
     FT_SetUSBParameters(m_DeviceHandle, 64, 64);
     FT_SetLatencyTimer(m_DeviceHandle, 10);
 
@@ -130,14 +142,38 @@ bool Cedrus::Connection::SetupCOMPort()
 
 void Cedrus::Connection::SetReadTimeout(DWORD readTimeout)
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
+    m_readTimeout = readTimeout;
     FT_SetTimeouts(m_DeviceHandle, readTimeout, 50);
 }
 
+void Cedrus::Connection::SetReadDeadline(std::chrono::steady_clock::time_point deadline)
+{
+    m_hasReadDeadline = true;
+    m_readDeadline = deadline;
+}
+
+void Cedrus::Connection::ClearReadDeadline()
+{
+    m_hasReadDeadline = false;
+}
+
+void Cedrus::Connection::SetCancelFlag(const std::atomic<bool> * cancelFlag)
+{
+    m_cancelFlag = cancelFlag;
+}
+
 bool Cedrus::Connection::Read(
     unsigned char *inBuffer,
     DWORD bytesToRead,
     LPDWORD bytesRead)
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
+    if (m_hasReadDeadline || m_cancelFlag != nullptr)
+        return ReadInterruptible(inBuffer, bytesToRead, bytesRead);
+
     DWORD read_status = FT_OK;
 
     read_status = FT_Read(m_DeviceHandle, inBuffer, bytesToRead, bytesRead);
@@ -153,12 +189,87 @@ bool Cedrus::Connection::Read(
     return read_status == FT_OK;
 }
 
+DWORD Cedrus::Connection::GetBytesAvailable()
+{
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
+    DWORD bytes_queued = 0;
+
+    if (FT_GetQueueStatus(m_DeviceHandle, &bytes_queued) != FT_OK)
+    {
+        m_ConnectionDead = true;
+        return 0;
+    }
+
+    return bytes_queued;
+}
+
+bool Cedrus::Connection::ReadInterruptible(
+    unsigned char *inBuffer,
+    DWORD bytesToRead,
+    LPDWORD bytesRead)
+{
+    *bytesRead = 0;
+
+    // This mirrors what FT_Read does with the timeout given to FT_SetTimeouts,
+    // except that we only ever hand FT_Read as many bytes as are already queued,
+    // so it never blocks and we get to check the deadline and cancel flag often.
+    std::chrono::steady_clock::time_point give_up_at =
+        std::chrono::steady_clock::now() + std::chrono::milliseconds(m_readTimeout);
+
+    if (m_hasReadDeadline && m_readDeadline < give_up_at)
+        give_up_at = m_readDeadline;
+
+    FT_STATUS read_status = FT_OK;
+
+    while (*bytesRead < bytesToRead)
+    {
+        if (m_cancelFlag != nullptr && m_cancelFlag->load())
+            break;
+
+        DWORD bytes_queued = 0;
+        read_status = FT_GetQueueStatus(m_DeviceHandle, &bytes_queued);
+
+        if (read_status != FT_OK)
+            break;
+
+        if (bytes_queued > 0)
+        {
+            DWORD bytes_wanted = bytesToRead - *bytesRead;
+            DWORD bytes_this_pass = 0;
+
+            read_status = FT_Read(m_DeviceHandle,
+                inBuffer + *bytesRead,
+                bytes_queued < bytes_wanted ? bytes_queued : bytes_wanted,
+                &bytes_this_pass);
+
+            if (read_status != FT_OK)
+                break;
+
+            *bytesRead += bytes_this_pass;
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() >= give_up_at)
+            break;
+
+        SLEEP_FUNC(INTERRUPTIBLE_READ_POLL_MS * SLEEP_INC);
+    }
+
+    if (read_status != FT_OK)
+        m_ConnectionDead = true;
+
+    return read_status == FT_OK;
+}
+
 bool Cedrus::Connection::Write(
     unsigned char * const inBuffer,
     DWORD bytesToWrite,
     LPDWORD bytesWritten,
     bool savesToFlash )
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
     FlushWriteToDeviceBuffer();
 
     while (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_timestamp).count() < m_cmdThroughputLimit)
@@ -182,6 +293,8 @@ bool Cedrus::Connection::Write(
         ++p;
     }
 
+    m_lastWriteTime = std::chrono::steady_clock::now();
+
     if ( savesToFlash )
         SLEEP_FUNC ( 100 * SLEEP_INC );
 
@@ -235,6 +348,10 @@ DWORD Cedrus::Connection::SendXIDCommand(
     unsigned char outResponse[],
     unsigned int maxOutResponseSize)
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
     if (outResponse != NULL)
         memset(outResponse, 0x00, maxOutResponseSize);
 
@@ -265,6 +382,8 @@ DWORD Cedrus::Connection::SendXIDCommand(
         ++num_retries;
     } while (bytes_stored < maxOutResponseSize && num_retries < 3);
 
+    RecordCommandTiming(std::string(inCommand, std::min<DWORD>(commandSize, 3)), start);
+
     return bytes_stored;
 }
 
@@ -274,6 +393,10 @@ DWORD Cedrus::Connection::SendXIDCommand_PST_Proof(
     unsigned char outResponse[],
     unsigned int maxOutResponseSize)
 {
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
     if (outResponse != NULL)
         memset(outResponse, 0x00, maxOutResponseSize);
 
@@ -309,5 +432,107 @@ DWORD Cedrus::Connection::SendXIDCommand_PST_Proof(
         ++num_retries;
     } while (bytes_stored < maxOutResponseSize && num_retries < 3);
 
+    RecordCommandTiming(std::string(inCommand, std::min<DWORD>(commandSize, 3)), start);
+
     return bytes_stored;
 }
+
+bool Cedrus::Connection::SendXIDCommandBatch(
+    const std::vector<std::string> & inCommands,
+    const std::vector<unsigned int> & replySizes,
+    std::vector<std::string> & outReplies)
+{
+    std::lock_guard<std::recursive_mutex> io_lock(m_ioMutex);
+
+    CEDRUS_ASSERT(inCommands.size() == replySizes.size(), "SendXIDCommandBatch needs a reply size for every command");
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    outReplies.clear();
+
+    FlushReadFromDeviceBuffer();
+
+    unsigned int total_reply_size = 0;
+    for (unsigned int i = 0; i < inCommands.size(); ++i)
+    {
+        DWORD bytes_written = 0;
+        Write((unsigned char*)inCommands[i].data(), (DWORD)inCommands[i].size(), &bytes_written);
+
+        if (bytes_written != inCommands[i].size())
+            return false;
+
+        total_reply_size += replySizes[i];
+    }
+
+    std::string received;
+    unsigned char in_buff[64];
+    DWORD bytes_read = 0;
+
+    // Give up after three reads in a row bring nothing.
+    unsigned int num_retries = 0;
+    while (received.size() < total_reply_size && num_retries < 3)
+    {
+        Read(in_buff, sizeof(in_buff), &bytes_read);
+
+        if (bytes_read > 0)
+        {
+            received.append((char*)in_buff, bytes_read);
+            num_retries = 0;
+        }
+        else
+        {
+            ++num_retries;
+        }
+    }
+
+    RecordCommandTiming("batch", start);
+
+    if (received.size() != total_reply_size)
+        return false;
+
+    unsigned int offset = 0;
+    for (unsigned int i = 0; i < inCommands.size(); ++i)
+    {
+        if (received.compare(offset, inCommands[i].size(), inCommands[i]) != 0)
+        {
+            outReplies.clear();
+            return false;
+        }
+
+        outReplies.push_back(received.substr(offset, replySizes[i]));
+        offset += replySizes[i];
+    }
+
+    return true;
+}
+
+std::chrono::steady_clock::time_point Cedrus::Connection::GetLastWriteTime() const
+{
+    return m_lastWriteTime;
+}
+
+std::unique_lock<std::recursive_mutex> Cedrus::Connection::LockIO()
+{
+    return std::unique_lock<std::recursive_mutex>(m_ioMutex);
+}
+
+const std::map<std::string, Cedrus::CommandTiming> & Cedrus::Connection::GetCommandTimings() const
+{
+    return m_commandTimings;
+}
+
+void Cedrus::Connection::ResetCommandTimings()
+{
+    m_commandTimings.clear();
+}
+
+void Cedrus::Connection::RecordCommandTiming(const std::string & commandName, std::chrono::steady_clock::time_point start)
+{
+    const std::chrono::microseconds elapsed =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    CommandTiming & timing = m_commandTimings[commandName];
+    ++timing.count;
+    timing.totalTime += elapsed;
+    timing.longestTime = std::max(timing.longestTime, elapsed);
+}
@@ -32,6 +32,7 @@
 #pragma once
 
 #include "ftd2xx.h"
+#include "CommandTiming.h"
 
 #ifdef __APPLE__
 #   define SLEEP_FUNC usleep
@@ -42,7 +43,12 @@
 #   define SLEEP_INC 1
 #endif
 
+#include <atomic>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
 
 namespace Cedrus
 {
@@ -71,6 +77,9 @@ namespace Cedrus
 
         bool Read(unsigned char *inBuffer, DWORD bytesToRead, LPDWORD bytesRead);
 
+        // How many received bytes are waiting to be read, without waiting.
+        DWORD GetBytesAvailable();
+
         bool Write(
             unsigned char * const inBuffer,
             DWORD bytesToWrite,
@@ -89,6 +98,15 @@ namespace Cedrus
             unsigned char outResponse[],
             unsigned int maxOutResponseSize);
 
+        // Sends every query before reading any reply, so the device's answers
+        // come back in one read instead of one round trip each. Fails, leaving
+        // outReplies empty, unless every reply arrives in full and starts with
+        // its own query.
+        bool SendXIDCommandBatch(
+            const std::vector<std::string> & inCommands,
+            const std::vector<unsigned int> & replySizes,
+            std::vector<std::string> & outReplies);
+
         int GetBaudRate() const;
 
         void SetBaudRate(unsigned char rate);
@@ -99,8 +117,34 @@ namespace Cedrus
 
         void SetReadTimeout(DWORD readTimeout);
 
+        // While a deadline or a cancel flag is set, Read() polls the device
+        // queue in short steps instead of blocking in the driver, so that it
+        // gives up within a few milliseconds of either one firing. This is
+        // used by device detection, where a misbehaving port must not be
+        // allowed to hold up the whole scan.
+        void SetReadDeadline(std::chrono::steady_clock::time_point deadline);
+        void ClearReadDeadline();
+        void SetCancelFlag(const std::atomic<bool> * cancelFlag);
+
+        // When the last byte of the most recent Write() went out.
+        std::chrono::steady_clock::time_point GetLastWriteTime() const;
+
+        // Every call above that talks to the device holds this for its
+        // duration. Hold it yourself to keep another thread's reads out of a
+        // longer exchange.
+        std::unique_lock<std::recursive_mutex> LockIO();
+
+        // Keyed by command name, the first three characters of the command.
+        // Batches are recorded together under "batch".
+        const std::map<std::string, CommandTiming> & GetCommandTimings() const;
+        void ResetCommandTimings();
+
     private:
+        enum { INTERRUPTIBLE_READ_POLL_MS = 1 };
+
         bool SetupCOMPort();
+        bool ReadInterruptible(unsigned char *inBuffer, DWORD bytesToRead, LPDWORD bytesRead);
+        void RecordCommandTiming(const std::string & commandName, std::chrono::steady_clock::time_point start);
 
         DWORD m_BaudRate;
         BYTE m_ByteSize;
@@ -110,9 +154,18 @@ namespace Cedrus
 
         bool m_ConnectionDead;
         unsigned int m_cmdThroughputLimit;
+        DWORD m_readTimeout;
+
+        bool m_hasReadDeadline;
+        std::chrono::steady_clock::time_point m_readDeadline;
+        const std::atomic<bool> * m_cancelFlag;
+
+        std::map<std::string, CommandTiming> m_commandTimings;
 
         FT_HANDLE m_DeviceHandle;
+        std::recursive_mutex m_ioMutex;
 
         std::chrono::high_resolution_clock::time_point m_timestamp;
+        std::chrono::steady_clock::time_point m_lastWriteTime;
     };
 } // namespace Cedrus
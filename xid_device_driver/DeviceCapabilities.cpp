@@ -0,0 +1,128 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DeviceCapabilities.h"
+
+#include "DeviceConfig.h"
+
+Cedrus::DeviceCapabilities::DeviceCapabilities()
+{
+}
+
+Cedrus::DeviceCapabilities::DeviceCapabilities(const DeviceConfig & config, int modelID, unsigned int minorFirmwareVersion)
+{
+    const bool is_pod = config.IsMPod() || config.IsCPod();
+    const bool is_analog_pod = config.IsXID2() && modelID == 'V';
+
+    m_supported[CMD_OUTPUT_LOGIC] = config.IsXID1InputDevice();
+    m_supported[CMD_ACCESSORY_CONNECTOR_MODE] = config.IsXID1InputDevice();
+    m_supported[CMD_AC_DEBOUNCING_TIME] = config.IsXID1InputDevice();
+    m_supported[CMD_FLASH_BACKUP] = is_pod && minorFirmwareVersion >= 22;
+    m_supported[CMD_TRANSLATION_TABLE_CRC] = is_pod && minorFirmwareVersion >= 22;
+    m_supported[CMD_MPOD_OUTPUT_ENABLE] = config.IsXID2InputDevice();
+    m_supported[CMD_LINE_MAPPING_COMMIT] = config.IsXID2();
+    m_supported[CMD_POD_OUTPUT_LOGIC] = config.IsPod();
+    m_supported[CMD_MPOD_OUTPUT_MODE] = config.IsMPod();
+    m_supported[CMD_MPOD_CONNECTION] = config.IsXID2();
+    m_supported[CMD_TRANSLATION_TABLE] = config.IsMPod();
+    m_supported[CMD_MAPPED_SIGNALS] = config.IsXID2();
+    m_supported[CMD_POD_LOCK] = is_pod && minorFirmwareVersion >= 22;
+    m_supported[CMD_MPOD_PULSE_DURATION] = config.IsMPod();
+
+    m_supported[CMD_VK_DROP_DELAY] = config.IsXID1InputDevice();
+
+    m_supported[CMD_KB_MODE_PROTOCOL] = config.IsRBx40() || config.IsLumina3G();
+    m_supported[CMD_KEYBOARD_MODE] = config.IsRBx40() || config.IsLumina3G();
+    m_supported[CMD_CPOD_INPUT_MODE] = config.IsCPodWithInput();
+
+    m_supported[CMD_OUTPOST_MODEL] = config.IsXID2();
+    m_supported[CMD_HARDWARE_GENERATION] = config.IsXID2();
+
+    m_supported[CMD_BASE_TIMER] = config.IsXID1();
+    m_supported[CMD_RT_TIMER] = config.IsXID2();
+    m_supported[CMD_RESET_RT_TIMER] = !config.IsStimTracker1();
+
+    m_supported[CMD_LOCKING_LEVEL] = config.IsXID1();
+    m_supported[CMD_TRIGGER_DEFAULT] = config.IsLumina();
+    m_supported[CMD_TRIGGER_DEBOUNCE_TIME] = config.IsLumina();
+    m_supported[CMD_BUTTON_DEBOUNCE_TIME] = config.IsLumina() || config.IsRB();
+    m_supported[CMD_OSCILLATOR_TEST] = config.IsCPod();
+    m_supported[CMD_OPTICAL_ISOLATION_SWITCH] = config.IsLumina3G();
+
+    m_supported[CMD_SINGLE_SHOT_MODE] = config.IsXID2();
+    m_supported[CMD_CPOD_INPUT_LINES] = config.IsCPodWithInput();
+    m_supported[CMD_SIGNAL_FILTER] = config.IsXID2();
+    m_supported[CMD_KB_AUTOREPEAT] = (config.IsRBx40() || config.IsLumina3G()) && minorFirmwareVersion >= 21;
+    m_supported[CMD_LED_FUNCTION] = config.IsXID2();
+    m_supported[CMD_DIGITAL_OUTPUT] = config.IsXID2();
+    m_supported[CMD_SET_DIGITAL_OUTPUT] = config.IsStimTracker2();
+    m_supported[CMD_OUTPUT_PAUSE] = config.IsXID2InputDevice() && minorFirmwareVersion >= 21;
+    m_supported[CMD_TIMER_RESET_ON_ONSET] = config.IsXID2();
+    m_supported[CMD_ANALOG_INPUT_THRESHOLD] = config.IsXID2();
+    m_supported[CMD_USB_OUTPUT] = config.IsXID2();
+    m_supported[CMD_SET_USB_OUTPUT] = config.IsStimTracker2();
+    m_supported[CMD_MIXED_INPUT_MODE] = config.IsXID2();
+
+    m_supported[CMD_PULSE_TABLE] = config.IsXID2();
+    m_supported[CMD_NUMBER_OF_LINES] = config.IsXID2();
+    m_supported[CMD_PULSE_DURATION] = !(config.IsXID1InputDevice() || config.IsMPod());
+    m_supported[CMD_PULSE_TRAIN] = config.IsXID2();
+    m_supported[CMD_OUTPUT_LINES_RESET] = config.IsXID2();
+
+    m_supported[CMD_VOLTAGE_RANGE] = is_analog_pod;
+    m_supported[CMD_ANALOG_OUTPUT_MODE] = is_analog_pod;
+    m_supported[CMD_ANALOG_OUTPUT_LEVELS] = is_analog_pod;
+}
+
+bool Cedrus::DeviceCapabilities::Supports(XidCommand command) const
+{
+    return command >= 0 && command < XID_COMMAND_COUNT && m_supported[command];
+}
+
+/*static*/ bool Cedrus::DeviceCapabilities::DependsOnFirmwareVersion(const DeviceConfig & config)
+{
+    return config.IsMPod() || config.IsCPod() || config.IsRBx40() || config.IsLumina3G() || config.IsXID2InputDevice();
+}
+
+/*static*/ bool Cedrus::DeviceCapabilities::DependsOnFirmwareVersion(XidCommand command)
+{
+    switch (command)
+    {
+    case CMD_FLASH_BACKUP:
+    case CMD_TRANSLATION_TABLE_CRC:
+    case CMD_POD_LOCK:
+    case CMD_KB_AUTOREPEAT:
+    case CMD_OUTPUT_PAUSE:
+        return true;
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,123 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <bitset>
+
+namespace Cedrus
+{
+    class DeviceConfig;
+
+    // The device-specific XID commands, named after the setting or action.
+    // Unless a SET_ variant exists, one value covers both the query (_xx) and
+    // the command that changes it (xx).
+    enum XidCommand
+    {
+        CMD_OUTPUT_LOGIC, // a0
+        CMD_ACCESSORY_CONNECTOR_MODE, // a1
+        CMD_AC_DEBOUNCING_TIME, // a6
+        CMD_FLASH_BACKUP, // ab (v2.2.2)
+        CMD_TRANSLATION_TABLE_CRC, // _ac (v2.2.2)
+        CMD_MPOD_OUTPUT_ENABLE, // ae
+        CMD_LINE_MAPPING_COMMIT, // af
+        CMD_POD_OUTPUT_LOGIC, // al
+        CMD_MPOD_OUTPUT_MODE, // am
+        CMD_MPOD_CONNECTION, // aq
+        CMD_TRANSLATION_TABLE, // as
+        CMD_MAPPED_SIGNALS, // at
+        CMD_POD_LOCK, // au (v2.2.2)
+        CMD_MPOD_PULSE_DURATION, // aw
+        CMD_VK_DROP_DELAY, // b3
+        CMD_KB_MODE_PROTOCOL, // c2
+        CMD_KEYBOARD_MODE, // c3
+        CMD_CPOD_INPUT_MODE, // c4
+        CMD_OUTPOST_MODEL, // _d6
+        CMD_HARDWARE_GENERATION, // _d7
+        CMD_BASE_TIMER, // e1, e3
+        CMD_RT_TIMER, // _e5
+        CMD_RESET_RT_TIMER, // e5
+        CMD_LOCKING_LEVEL, // f2
+        CMD_TRIGGER_DEFAULT, // f4
+        CMD_TRIGGER_DEBOUNCE_TIME, // f5
+        CMD_BUTTON_DEBOUNCE_TIME, // f6
+        CMD_OSCILLATOR_TEST, // fa, fb, fc
+        CMD_OPTICAL_ISOLATION_SWITCH, // _fo
+        CMD_SINGLE_SHOT_MODE, // ia
+        CMD_CPOD_INPUT_LINES, // _ic
+        CMD_SIGNAL_FILTER, // if
+        CMD_KB_AUTOREPEAT, // ig (v2.2.1)
+        CMD_LED_FUNCTION, // il
+        CMD_DIGITAL_OUTPUT, // _io
+        CMD_SET_DIGITAL_OUTPUT, // io
+        CMD_OUTPUT_PAUSE, // ip (v2.2.1)
+        CMD_TIMER_RESET_ON_ONSET, // ir
+        CMD_ANALOG_INPUT_THRESHOLD, // it
+        CMD_USB_OUTPUT, // _iu
+        CMD_SET_USB_OUTPUT, // iu
+        CMD_MIXED_INPUT_MODE, // iv
+        CMD_PULSE_TABLE, // mc, mk, mr, ms, mt
+        CMD_NUMBER_OF_LINES, // ml
+        CMD_PULSE_DURATION, // mp
+        CMD_PULSE_TRAIN, // mx
+        CMD_OUTPUT_LINES_RESET, // mz
+        CMD_VOLTAGE_RANGE, // vr, vt
+        CMD_ANALOG_OUTPUT_MODE, // vm
+        CMD_ANALOG_OUTPUT_LEVELS, // vl
+
+        XID_COMMAND_COUNT
+    };
+
+    // Which XidCommands a device understands, worked out once from its
+    // config, model and firmware.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceCapabilities
+    {
+    public:
+        // Supports nothing.
+        DeviceCapabilities();
+
+        DeviceCapabilities(const DeviceConfig & config, int modelID, unsigned int minorFirmwareVersion);
+
+        bool Supports(XidCommand command) const;
+
+        // Whether the answer depends on the minor firmware version, which
+        // otherwise doesn't need to be asked for.
+        static bool DependsOnFirmwareVersion(const DeviceConfig & config);
+        // Whether the answer for this command can; the rest are settled by
+        // the config and model alone.
+        static bool DependsOnFirmwareVersion(XidCommand command);
+
+    private:
+        std::bitset<XID_COMMAND_COUNT> m_supported;
+    };
+} // namespace Cedrus
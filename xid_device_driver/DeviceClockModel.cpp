@@ -0,0 +1,138 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DeviceClockModel.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Keeps a near-perfect sample from drowning out all the others.
+    const double MIN_UNCERTAINTY_US = 1.0;
+}
+
+Cedrus::DeviceClockModel::DeviceClockModel()
+{
+    Reset();
+}
+
+void Cedrus::DeviceClockModel::AddSample(long long deviceTimeMs, std::chrono::steady_clock::time_point hostTime, std::chrono::microseconds uncertainty)
+{
+    Sample & sample = m_samples[m_nextSample];
+    sample.deviceTimeMs = deviceTimeMs;
+    sample.hostTime = hostTime;
+    sample.uncertaintyUs = std::max(static_cast<double>(uncertainty.count()), MIN_UNCERTAINTY_US);
+
+    m_nextSample = (m_nextSample + 1) % MAX_SAMPLES;
+    if (m_sampleCount < MAX_SAMPLES)
+        ++m_sampleCount;
+
+    Fit();
+}
+
+void Cedrus::DeviceClockModel::Reset()
+{
+    m_nextSample = 0;
+    m_sampleCount = 0;
+    m_originDeviceMs = 0;
+    m_originHost = std::chrono::steady_clock::time_point();
+    m_offsetUs = 0.0;
+    m_usPerMs = 1000.0;
+    m_errorBoundUs = 0.0;
+}
+
+unsigned int Cedrus::DeviceClockModel::GetSampleCount() const
+{
+    return m_sampleCount;
+}
+
+double Cedrus::DeviceClockModel::GetDriftRatio() const
+{
+    return m_usPerMs / 1000.0;
+}
+
+bool Cedrus::DeviceClockModel::DeviceToHost(long long deviceTimeMs, std::chrono::steady_clock::time_point & hostTime, std::chrono::microseconds & errorBound) const
+{
+    if (m_sampleCount < 2)
+        return false;
+
+    const double host_us = m_offsetUs + m_usPerMs * static_cast<double>(deviceTimeMs - m_originDeviceMs);
+
+    hostTime = m_originHost + std::chrono::microseconds(std::llround(host_us));
+    errorBound = std::chrono::microseconds(static_cast<long long>(std::ceil(m_errorBoundUs)));
+
+    return true;
+}
+
+void Cedrus::DeviceClockModel::Fit()
+{
+    // Everything is taken relative to the newest sample to keep the sums small.
+    const Sample & newest = m_samples[(m_nextSample + MAX_SAMPLES - 1) % MAX_SAMPLES];
+    m_originDeviceMs = newest.deviceTimeMs;
+    m_originHost = newest.hostTime;
+
+    double sum_w = 0.0, sum_x = 0.0, sum_y = 0.0;
+    for (unsigned int i = 0; i < m_sampleCount; ++i)
+    {
+        const double w = 1.0 / (m_samples[i].uncertaintyUs * m_samples[i].uncertaintyUs);
+        sum_w += w;
+        sum_x += w * static_cast<double>(m_samples[i].deviceTimeMs - m_originDeviceMs);
+        sum_y += w * std::chrono::duration<double, std::micro>(m_samples[i].hostTime - m_originHost).count();
+    }
+
+    const double mean_x = sum_x / sum_w;
+    const double mean_y = sum_y / sum_w;
+
+    double sum_xx = 0.0, sum_xy = 0.0;
+    for (unsigned int i = 0; i < m_sampleCount; ++i)
+    {
+        const double w = 1.0 / (m_samples[i].uncertaintyUs * m_samples[i].uncertaintyUs);
+        const double dx = static_cast<double>(m_samples[i].deviceTimeMs - m_originDeviceMs) - mean_x;
+        const double dy = std::chrono::duration<double, std::micro>(m_samples[i].hostTime - m_originHost).count() - mean_y;
+        sum_xx += w * dx * dx;
+        sum_xy += w * dx * dy;
+    }
+
+    // With no spread in device time there's nothing to learn drift from.
+    m_usPerMs = sum_xx > 0.0 ? sum_xy / sum_xx : 1000.0;
+    m_offsetUs = mean_y - m_usPerMs * mean_x;
+
+    m_errorBoundUs = 0.0;
+    for (unsigned int i = 0; i < m_sampleCount; ++i)
+    {
+        const double x = static_cast<double>(m_samples[i].deviceTimeMs - m_originDeviceMs);
+        const double y = std::chrono::duration<double, std::micro>(m_samples[i].hostTime - m_originHost).count();
+        const double residual = std::fabs(y - (m_offsetUs + m_usPerMs * x));
+
+        m_errorBoundUs = std::max(m_errorBoundUs, residual + m_samples[i].uncertaintyUs);
+    }
+}
@@ -0,0 +1,89 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <chrono>
+
+namespace Cedrus
+{
+    // Maps the device's millisecond RT timer onto the host's steady clock,
+    // fitting offset and drift to the most recent timer samples by weighted
+    // least squares. Each sample pairs a timer reading with the host time it
+    // was most likely taken at, give or take its uncertainty; samples with
+    // less uncertainty count for more.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceClockModel
+    {
+    public:
+        enum { MAX_SAMPLES = 64 };
+
+        DeviceClockModel();
+
+        // The oldest sample is forgotten once there are MAX_SAMPLES.
+        void AddSample(long long deviceTimeMs, std::chrono::steady_clock::time_point hostTime, std::chrono::microseconds uncertainty);
+
+        // For when the device timer has been reset.
+        void Reset();
+
+        unsigned int GetSampleCount() const;
+
+        // Host time elapsed per unit of device time; 1.0 means the clocks
+        // agree. Meaningless until there are two samples.
+        double GetDriftRatio() const;
+
+        // Fails until there are two samples. errorBound covers the worst
+        // combined fit residual and sample uncertainty seen in the window.
+        bool DeviceToHost(long long deviceTimeMs, std::chrono::steady_clock::time_point & hostTime, std::chrono::microseconds & errorBound) const;
+
+    private:
+        void Fit();
+
+        struct Sample
+        {
+            long long deviceTimeMs;
+            std::chrono::steady_clock::time_point hostTime;
+            double uncertaintyUs;
+        };
+
+        Sample m_samples[MAX_SAMPLES];
+        unsigned int m_nextSample;
+        unsigned int m_sampleCount;
+
+        // host = m_originHost + m_offsetUs + m_usPerMs * (device - m_originDeviceMs)
+        long long m_originDeviceMs;
+        std::chrono::steady_clock::time_point m_originHost;
+        double m_offsetUs;
+        double m_usPerMs;
+        double m_errorBoundUs;
+    };
+} // namespace Cedrus
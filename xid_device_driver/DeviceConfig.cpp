@@ -35,156 +35,83 @@
 
 #include "constants.h"
 
-#include <iostream>
-#include <sstream>
+#include <cstring>
 
-#include "CedrusAssert.h"
-
-void Cedrus::DeviceConfig::PopulateConfigList(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
+unsigned int Cedrus::DeviceConfig::BuiltInConfigCount()
 {
-    CreateRB530Config(listOfAllConfigs);
-    CreateRB540Config(listOfAllConfigs);
-    CreateRB730Config(listOfAllConfigs);
-    CreateRB740Config(listOfAllConfigs);
-    CreateRB830Config(listOfAllConfigs);
-    CreateRB840Config(listOfAllConfigs);
-    CreateRB834Config(listOfAllConfigs);
-    CreateRB844Config(listOfAllConfigs);
-
-    CreateRipondaModel_C_Config(listOfAllConfigs);
-    CreateRipondaModel_L_Config(listOfAllConfigs);
-    CreateRipondaModel_E_Config(listOfAllConfigs);
-    CreateRipondaModel_S_Config(listOfAllConfigs);
-    CreateRipondaModel_NoModel_Config(listOfAllConfigs);
-
-    CreateLuminaLP400Config(listOfAllConfigs);
-    CreateLumina3GConfig(listOfAllConfigs);
-
-    CreateSV1Config(listOfAllConfigs);
-
-    CreateST100Config(listOfAllConfigs);
-    CreateST2DuoConfig(listOfAllConfigs);
-    CreateST2QuadConfig(listOfAllConfigs);
-    CreateST2QuadWithMpod4(listOfAllConfigs);
-    CreateST2StimTrigger(listOfAllConfigs);
-
-    CreateAllmpodConfigs(listOfAllConfigs);
-
-    CreateAllcpodConfigs(listOfAllConfigs);
+    return NUM_BUILT_IN_CONFIGS;
 }
 
-void Cedrus::DeviceConfig::CreateInvalidConfig(std::shared_ptr<Cedrus::DeviceConfig> & invalidCfgPtr)
+const Cedrus::DeviceConfig & Cedrus::DeviceConfig::BuiltInConfigAtIndex(unsigned int i)
 {
-    CreateEmptyConfig(invalidCfgPtr);
+    return i < NUM_BUILT_IN_CONFIGS ? BUILT_IN_CONFIGS[i] : INVALID_CONFIG;
 }
 
-Cedrus::DeviceConfig::DeviceConfig(std::string deviceName,
-    int productID,
-    int modelID,
-    int majorFirmwareVer,
-    unsigned int outputLines,
-    std::map<unsigned int, DevicePort> devicePorts)
-    :
-    m_DeviceName(deviceName),
-    m_ProductID(productID),
-    m_ModelID(modelID),
-    m_MajorFirmwareVer(majorFirmwareVer),
-    m_requiresDelay(false),
-    m_outputLines(outputLines),
-    m_DevicePorts(devicePorts)
+const Cedrus::DeviceConfig & Cedrus::DeviceConfig::FindBuiltInConfig(int productID, int modelID, int majorFirmwareVer)
 {
-    m_requiresDelay = (IsRB() && IsXID1()) || IsSV1();
+    const unsigned int config_index = BUILT_IN_CONFIG_INDEX.Find(productID, modelID, majorFirmwareVer);
+
+    return config_index != DeviceConfigIndex::NO_CONFIG ? BUILT_IN_CONFIGS[config_index] : INVALID_CONFIG;
 }
 
-Cedrus::DeviceConfig::DeviceConfig(std::string deviceName,
-    int productID,
-    int modelID,
-    int majorFirmwareVer,
-    unsigned int outputLines)
-    :
-    m_DeviceName(deviceName),
-    m_ProductID(productID),
-    m_ModelID(modelID),
-    m_MajorFirmwareVer(majorFirmwareVer),
-    m_requiresDelay(false),
-    m_outputLines(outputLines)
+const Cedrus::DeviceConfig & Cedrus::DeviceConfig::InvalidConfig()
 {
-    m_requiresDelay = (IsRB() && IsXID1()) || IsSV1();
+    return INVALID_CONFIG;
 }
 
-Cedrus::DeviceConfig::~DeviceConfig(void)
+unsigned int Cedrus::DeviceConfig::GetNumberOfPorts() const
 {
+    return m_numberOfPorts;
 }
 
-int Cedrus::DeviceConfig::GetMappedKey(int port, int key) const
+const Cedrus::DevicePort * Cedrus::DeviceConfig::GetPortPtrByIndex(unsigned int i) const
 {
-    int mapped_key = key;
-
-    try
-    {
-        const Cedrus::DevicePort & key_port = m_DevicePorts.at(port);
-        if (!key_port.keyMap.empty())
-            mapped_key = key_port.keyMap[key];
-    }
-    catch (std::out_of_range e){}
-
-    return mapped_key;
+    return i < m_numberOfPorts ? &m_DevicePorts[i] : nullptr;
 }
 
-const std::map<unsigned int, Cedrus::DevicePort> * Cedrus::DeviceConfig::GetMapOfPorts() const
+const Cedrus::DevicePort * Cedrus::DeviceConfig::GetPortPtrByNumber(unsigned int portNum) const
 {
-    return &m_DevicePorts;
+    if (portNum >= LOOKUP_RANGE || m_portIndexByNumber[portNum] == NO_PORT)
+        return nullptr;
+
+    return &m_DevicePorts[m_portIndexByNumber[portNum]];
 }
 
-const Cedrus::DevicePort * Cedrus::DeviceConfig::GetPortPtrByNumber(unsigned int portNum) const
+bool Cedrus::DeviceConfig::IsWellFormed() const
 {
-    const Cedrus::DevicePort * port_ptr = nullptr;
+    if (memchr(m_DeviceName, '\0', MAX_NAME_LENGTH) == nullptr || m_numberOfPorts > MAX_DEVICE_PORTS)
+        return false;
 
-    try
-    {
-        port_ptr = &(m_DevicePorts.at(portNum));
-    }
-    catch (std::out_of_range e)
+    for (unsigned int i = 0; i < m_numberOfPorts; ++i)
     {
-        return nullptr;
+        const DevicePort & port = m_DevicePorts[i];
+
+        if (memchr(port.portName, '\0', DevicePort::MAX_NAME_LENGTH) == nullptr ||
+            port.keyMapSize < 0 || port.keyMapSize > DevicePort::MAX_KEYS)
+            return false;
     }
 
-    return port_ptr;
-}
+    // Read as a byte, since any other value than 0 or 1 isn't a valid bool.
+    unsigned char requires_delay = 0;
+    memcpy(&requires_delay, &m_requiresDelay, sizeof(requires_delay));
 
-std::string Cedrus::DeviceConfig::GetDeviceName() const
-{
-    return m_DeviceName;
-}
+    if (requires_delay != (((IsRB() && IsXID1()) || IsSV1()) ? 1 : 0))
+        return false;
 
-int Cedrus::DeviceConfig::GetProductID() const
-{
-    return m_ProductID;
-}
+    // The lookup tables must be exactly the ones the ports describe.
+    DeviceConfig rebuilt(*this);
+    rebuilt.BuildLookupTables();
 
-int Cedrus::DeviceConfig::GetModelID() const
-{
-    return m_ModelID;
+    return memcmp(m_portIndexByNumber, rebuilt.m_portIndexByNumber, sizeof(m_portIndexByNumber)) == 0 &&
+        memcmp(m_keyLookup, rebuilt.m_keyLookup, sizeof(m_keyLookup)) == 0;
 }
 
-int Cedrus::DeviceConfig::GetMajorVersion() const
+std::string Cedrus::DeviceConfig::GetDeviceName() const
 {
-    return m_MajorFirmwareVer;
+    return m_DeviceName;
 }
 
 unsigned int Cedrus::DeviceConfig::GetNumberOfOutputLines() const
 {
     return m_outputLines;
 }
-
-bool Cedrus::DeviceConfig::DoesConfigMatchDevice( int deviceID, int modelID, int majorFirmwareVer ) const
-{
-    bool does_match = false;
-    if ( m_ProductID == deviceID && m_MajorFirmwareVer == majorFirmwareVer &&
-        (!ModelIDMatters() || (m_ModelID == modelID)) )
-    {
-        does_match = true;
-    }
-
-    return does_match;
-}
@@ -34,230 +34,506 @@
 #include "constants.h"
 #include "XidDriverImpExpDefs.h"
 
-#include <map>
 #include <string>
-#include <vector>
-#include <memory>
+#include <initializer_list>
 
 namespace Cedrus
 {
+    // DevicePort and DeviceConfig are literal types made of fixed-size arrays
+    // so that the built-in device table can be evaluated entirely at compile
+    // time and kept in read-only storage.
     struct DevicePort
     {
-        DevicePort():
-            portName(""),
+        enum { MAX_NAME_LENGTH = 32 };
+        enum { MAX_KEYS = 8 };
+
+        constexpr DevicePort():
+            portName(),
             portNumber(-1),
             numberOfLines(-1),
-            keyMap(8, -1)
+            keyMapSize(0),
+            keyMap()
         {
         }
 
-        DevicePort(std::string portName,
+        constexpr DevicePort(const char * portName,
             int portNumber,
             int numberOfLines,
-            std::vector<int> keyMap)
+            std::initializer_list<int> keyMap)
             :
-            portName(portName),
+            portName(),
             portNumber(portNumber),
             numberOfLines(numberOfLines),
-            keyMap(keyMap)
+            keyMapSize(0),
+            keyMap()
         {
+            CopyName(this->portName, MAX_NAME_LENGTH, portName);
+
+            for (int key : keyMap)
+            {
+                if (keyMapSize < MAX_KEYS)
+                    this->keyMap[keyMapSize++] = key;
+            }
         }
 
-        DevicePort(std::string portName, int portNumber, int numberOfLines)
+        constexpr DevicePort(const char * portName, int portNumber, int numberOfLines)
             :
-            portName(portName),
+            portName(),
             portNumber(portNumber),
             numberOfLines(numberOfLines),
+            keyMapSize(0),
             keyMap()
         {
+            CopyName(this->portName, MAX_NAME_LENGTH, portName);
+        }
+
+        // Copies at most destSize - 1 characters and always null-terminates.
+        static constexpr void CopyName(char * dest, unsigned int destSize, const char * src)
+        {
+            unsigned int i = 0;
+            for (; src != nullptr && src[i] != '\0' && i + 1 < destSize; ++i)
+                dest[i] = src[i];
+
+            dest[i] = '\0';
         }
 
-        std::string portName;
+        char portName[MAX_NAME_LENGTH];
         int portNumber;
         int numberOfLines;
-        std::vector<int> keyMap;
+        // A port without a key map reports its keys as they are.
+        int keyMapSize;
+        int keyMap[MAX_KEYS];
 
         bool operator == (const DevicePort& other) const
         {
-            return (portName == other.portName &&
-                portNumber == other.portNumber &&
-                numberOfLines == other.numberOfLines &&
-                keyMap == other.keyMap);
+            if (std::string(portName) != std::string(other.portName) ||
+                portNumber != other.portNumber ||
+                numberOfLines != other.numberOfLines ||
+                keyMapSize != other.keyMapSize)
+                return false;
+
+            for (int i = 0; i < keyMapSize; ++i)
+            {
+                if (keyMap[i] != other.keyMap[i])
+                    return false;
+            }
+
+            return true;
         }
     };
 
     class CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceConfig
     {
     public:
-        DeviceConfig(std::string deviceName,
+        enum { MAX_NAME_LENGTH = 64 };
+        enum { MAX_DEVICE_PORTS = 3 };
+        // Ports and keys are both looked up in the range 0-15.
+        enum { LOOKUP_RANGE = 16 };
+
+        constexpr DeviceConfig(const char * deviceName,
             int productID,
             int modelID,
             int majorFirmwareVer,
             unsigned int outputLines,
-            std::map<unsigned int, DevicePort> devicePorts);
+            std::initializer_list<DevicePort> devicePorts = {})
+            :
+            DeviceConfig(deviceName, productID, modelID, majorFirmwareVer, outputLines,
+                devicePorts.begin(), static_cast<unsigned int>(devicePorts.size()))
+        {
+        }
 
-        DeviceConfig(std::string deviceName,
+        // For configs that are put together at run time. Ports past
+        // MAX_DEVICE_PORTS are ignored.
+        constexpr DeviceConfig(const char * deviceName,
             int productID,
             int modelID,
             int majorFirmwareVer,
-            unsigned int outputLines);
+            unsigned int outputLines,
+            const DevicePort * devicePorts,
+            unsigned int numberOfPorts)
+            :
+            m_DeviceName(),
+            m_ProductID(productID),
+            m_ModelID(modelID),
+            m_MajorFirmwareVer(majorFirmwareVer),
+            m_requiresDelay(false),
+            m_outputLines(outputLines),
+            m_numberOfPorts(0),
+            m_DevicePorts(),
+            m_portIndexByNumber(),
+            m_keyLookup()
+        {
+            DevicePort::CopyName(m_DeviceName, MAX_NAME_LENGTH, deviceName);
+
+            for (unsigned int i = 0; i < numberOfPorts && m_numberOfPorts < MAX_DEVICE_PORTS; ++i)
+                m_DevicePorts[m_numberOfPorts++] = devicePorts[i];
+
+            m_requiresDelay = (IsRB() && IsXID1()) || IsSV1();
+
+            BuildLookupTables();
+        }
 
-        ~DeviceConfig(void);
+        // The built-in device table. Lookups go through an index built at
+        // compile time, so they cost the same regardless of the table size.
+        static unsigned int BuiltInConfigCount();
+        static const DeviceConfig & BuiltInConfigAtIndex(unsigned int i);
 
-        static void PopulateConfigList(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs);
-        static void CreateInvalidConfig(std::shared_ptr<Cedrus::DeviceConfig> & invalidCfgPtr);
+        // Never fails: pods with an unknown model get their "no model set"
+        // config, and anything else unknown gets InvalidConfig().
+        static const DeviceConfig & FindBuiltInConfig(int productID, int modelID, int majorFirmwareVer);
+        static const DeviceConfig & InvalidConfig();
 
-        int GetMappedKey(int port, int key) const;
+        // This is on the response path, so it's a single table read for every
+        // port and key an XID packet can describe (4 bits of port, 3 of key).
+        // Anything outside that range is passed through unchanged.
+        int GetMappedKey(int port, int key) const
+        {
+            const unsigned int lookup_port = static_cast<unsigned int>(port);
+            const unsigned int lookup_key = static_cast<unsigned int>(key);
+
+            if ((lookup_port | lookup_key) >= LOOKUP_RANGE)
+                return key;
+
+            return m_keyLookup[lookup_port * LOOKUP_RANGE + lookup_key];
+        }
 
         std::string GetDeviceName() const;
 
-        int GetProductID() const;
+        constexpr int GetProductID() const
+        {
+            return m_ProductID;
+        }
 
-        int GetModelID() const;
+        constexpr int GetModelID() const
+        {
+            return m_ModelID;
+        }
 
-        int GetMajorVersion() const;
+        constexpr int GetMajorVersion() const
+        {
+            return m_MajorFirmwareVer;
+        }
 
         unsigned int GetNumberOfOutputLines() const;
 
-        const std::map<unsigned int, DevicePort> * GetMapOfPorts() const;
+        unsigned int GetNumberOfPorts() const;
+
+        const Cedrus::DevicePort * GetPortPtrByIndex(unsigned int i) const;
 
         const Cedrus::DevicePort * GetPortPtrByNumber(unsigned int portNum) const;
 
-        bool DoesConfigMatchDevice( int deviceID, int modelID, int majorFirmwareVer ) const;
+        constexpr bool DoesConfigMatchDevice( int deviceID, int modelID, int majorFirmwareVer ) const
+        {
+            return m_ProductID == deviceID && m_MajorFirmwareVer == majorFirmwareVer &&
+                (!ModelIDMatters() || (m_ModelID == modelID));
+        }
 
-        bool IsLumina() const
+        constexpr bool IsLumina() const
         {
             return m_ProductID == XidProductID::LUMINA;
         }
 
-        bool IsLuminaLP400() const
+        constexpr bool IsLuminaLP400() const
         {
             return IsLumina() && IsXID1();
         }
 
-        bool IsLumina3G() const
+        constexpr bool IsLumina3G() const
         {
             return IsLumina() && IsXID2();
         }
 
-        bool IsSV1() const
+        constexpr bool IsSV1() const
         {
             return m_ProductID == XidProductID::SV1;
         }
 
-        bool IsRB() const
+        constexpr bool IsRB() const
         {
             return m_ProductID == XidProductID::RB;
         }
 
-        bool IsRBx30() const
+        constexpr bool IsRBx30() const
         {
             return IsRB() && IsXID1();
         }
 
-        bool IsRBx40() const
+        constexpr bool IsRBx40() const
         {
             return IsRB() && IsXID2();
         }
 
-        bool IsRiponda() const
+        constexpr bool IsRiponda() const
         {
             return m_ProductID == XidProductID::RIPONDA;
         }
 
-        bool IsMPod() const
+        constexpr bool IsMPod() const
         {
             return m_ProductID == XidProductID::MPOD;
         }
 
-        bool IsCPod() const
+        constexpr bool IsCPod() const
         {
             return m_ProductID == XidProductID::CPOD;
         }
 
-        bool IsPod() const
+        constexpr bool IsPod() const
         {
             return IsMPod() || IsCPod();
         }
 
-        bool IsStimTracker() const
+        constexpr bool IsStimTracker() const
         {
             return m_ProductID == XidProductID::STIMTRACKER;
         }
 
-        bool IsStimTracker1() const
+        constexpr bool IsStimTracker1() const
         {
             return IsStimTracker() && IsXID1();
         }
 
-        bool IsStimTracker2() const
+        constexpr bool IsStimTracker2() const
         {
             return IsStimTracker() && IsXID2();
         }
 
-        bool IsStimTracker2Duo() const
+        constexpr bool IsStimTracker2Duo() const
         {
             return IsStimTracker2() && m_ModelID == '1';
         }
 
-        bool IsStimTracker2Quad() const
+        constexpr bool IsStimTracker2Quad() const
         {
             return IsStimTracker2() && m_ModelID == '2';
         }
 
-        bool IsStimTracker2WithMpod4() const
+        constexpr bool IsStimTracker2WithMpod4() const
         {
             return IsStimTracker2() && m_ModelID == '3';
         }
 
-        bool IsStimTracker2StimTrigger() const
+        constexpr bool IsStimTracker2StimTrigger() const
         {
             return IsStimTracker2() && m_ModelID == '4';
         }
 
-        bool IsXID1() const
+        constexpr bool IsXID1() const
         {
             return m_MajorFirmwareVer == 1;
         }
 
-        bool IsXID2() const
+        constexpr bool IsXID2() const
         {
             return m_MajorFirmwareVer == 2;
         }
 
-        bool IsXID1InputDevice() const
+        constexpr bool IsXID1InputDevice() const
         {
             return IsXID1() && !IsStimTracker();
         }
 
-        bool IsXID2InputDevice() const
+        constexpr bool IsXID2InputDevice() const
         {
             return IsXID2() && !IsMPod() && !IsCPod();
         }
 
-        bool IsInputDevice() const
+        constexpr bool IsInputDevice() const
         {
             return IsXID1InputDevice() || IsXID2InputDevice() || IsCPodWithInput();
         }
 
-        bool IsCPodWithInput() const
+        constexpr bool IsCPodWithInput() const
         {
             return (IsCPod()) && (m_ModelID == 'g' || m_ModelID == 'U');
         }
 
-        bool ModelIDMatters() const
+        constexpr bool ModelIDMatters() const
         {
             return IsRB() || IsStimTracker() || IsCPod() || IsMPod() || IsRiponda();
         }
 
+        // For configs that weren't put together by a constructor, such as the
+        // ones in a mapped image file. True when every count, name and lookup
+        // table entry is one a constructor could have produced.
+        bool IsWellFormed() const;
+
     private:
-        std::string m_DeviceName;
+        enum { NO_PORT = -1 };
+
+        constexpr void BuildLookupTables()
+        {
+            for (int port_number = 0; port_number < LOOKUP_RANGE; ++port_number)
+            {
+                m_portIndexByNumber[port_number] = NO_PORT;
+
+                for (unsigned int i = 0; i < m_numberOfPorts; ++i)
+                {
+                    if (m_DevicePorts[i].portNumber == port_number)
+                    {
+                        m_portIndexByNumber[port_number] = static_cast<signed char>(i);
+                        break;
+                    }
+                }
+
+                for (int key = 0; key < LOOKUP_RANGE; ++key)
+                {
+                    int mapped_key = key;
+
+                    if (m_portIndexByNumber[port_number] != NO_PORT)
+                    {
+                        const DevicePort & port = m_DevicePorts[m_portIndexByNumber[port_number]];
+                        if (key < port.keyMapSize)
+                            mapped_key = port.keyMap[key];
+                    }
+
+                    m_keyLookup[port_number * LOOKUP_RANGE + key] = static_cast<signed char>(mapped_key);
+                }
+            }
+        }
+
+        char m_DeviceName[MAX_NAME_LENGTH];
         int m_ProductID;
         int m_ModelID;
         int m_MajorFirmwareVer;
         bool m_requiresDelay;
         unsigned int m_outputLines;
 
-        std::map<unsigned int, DevicePort> m_DevicePorts;
+        unsigned int m_numberOfPorts;
+        DevicePort m_DevicePorts[MAX_DEVICE_PORTS];
+
+        signed char m_portIndexByNumber[LOOKUP_RANGE];
+        signed char m_keyLookup[LOOKUP_RANGE * LOOKUP_RANGE];
+    };
+
+    // Maps (product, model, major firmware) straight to a position in a config
+    // table. It is meant to be built at compile time from that same table.
+    class DeviceConfigIndex
+    {
+    public:
+        enum { NO_CONFIG = 0xFFFF };
+
+        constexpr DeviceConfigIndex()
+            : m_slots()
+        {
+            for (unsigned int i = 0; i < NUM_SLOTS; ++i)
+                m_slots[i] = NO_CONFIG;
+        }
+
+        // Whether Build() can place config at all. Configs for products the
+        // index doesn't know, or with a model or firmware version outside its
+        // slots, are never found.
+        static constexpr bool CanHold(const DeviceConfig & config)
+        {
+            return IsIndexable(config.GetProductID(), config.GetMajorVersion()) &&
+                (!config.ModelIDMatters() || (config.GetModelID() >= 0 && config.GetModelID() < NUM_MODEL_SLOTS));
+        }
+
+        // Matching follows DeviceConfig::DoesConfigMatchDevice(), and the first
+        // matching config in the table wins. Pod models that are missing from
+        // the table fall back to the pod's "no model set" ('0') config.
+        static constexpr DeviceConfigIndex Build(const DeviceConfig * configs, unsigned int count)
+        {
+            DeviceConfigIndex index;
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                const DeviceConfig & config = configs[i];
+
+                if (!CanHold(config))
+                    continue;
+
+                if (config.ModelIDMatters())
+                {
+                    index.Claim(config.GetProductID(), config.GetModelID(), config.GetMajorVersion(), i);
+                }
+                else
+                {
+                    for (int model = 0; model < NUM_MODEL_SLOTS; ++model)
+                        index.Claim(config.GetProductID(), model, config.GetMajorVersion(), i);
+                }
+            }
+
+            const int pods[] = { XidProductID::MPOD, XidProductID::CPOD };
+            for (int pod : pods)
+            {
+                for (int firmware = 0; firmware < NUM_FIRMWARE_SLOTS; ++firmware)
+                {
+                    const unsigned int no_model_config = index.Find(pod, '0', firmware);
+
+                    for (int model = 0; model < NUM_MODEL_SLOTS; ++model)
+                        index.Claim(pod, model, firmware, no_model_config);
+                }
+            }
+
+            return index;
+        }
+
+        // Returns NO_CONFIG when nothing matches.
+        constexpr unsigned int Find(int productID, int modelID, int majorFirmwareVer) const
+        {
+            if (!IsIndexable(productID, majorFirmwareVer))
+                return NO_CONFIG;
+
+            // Model 0 is never a real model, so out of range IDs can share its
+            // slot. It holds NO_CONFIG, or the fallback for pods.
+            const int model_slot = (modelID >= 0 && modelID < NUM_MODEL_SLOTS) ? modelID : 0;
+
+            return m_slots[SlotFor(productID, model_slot, majorFirmwareVer)];
+        }
+
+        // For an index that wasn't made by Build(), such as the one in a
+        // mapped image file: every slot must be empty or name one of the
+        // configCount configs it was built from.
+        bool IsWellFormed(unsigned int configCount) const
+        {
+            for (unsigned int i = 0; i < NUM_SLOTS; ++i)
+            {
+                if (m_slots[i] != NO_CONFIG && m_slots[i] >= configCount)
+                    return false;
+            }
+
+            return true;
+        }
+
+    private:
+        enum { NUM_PRODUCT_SLOTS = 7 };
+        enum { NUM_MODEL_SLOTS = 128 };
+        enum { NUM_FIRMWARE_SLOTS = 3 };
+        enum { NUM_SLOTS = NUM_PRODUCT_SLOTS * NUM_MODEL_SLOTS * NUM_FIRMWARE_SLOTS };
+
+        static constexpr int ProductSlot(int productID)
+        {
+            switch (productID)
+            {
+            case XidProductID::LUMINA: return 0;
+            case XidProductID::SV1: return 1;
+            case XidProductID::RB: return 2;
+            case XidProductID::MPOD: return 3;
+            case XidProductID::CPOD: return 4;
+            case XidProductID::RIPONDA: return 5;
+            case XidProductID::STIMTRACKER: return 6;
+            default: return -1;
+            }
+        }
+
+        static constexpr bool IsIndexable(int productID, int majorFirmwareVer)
+        {
+            return ProductSlot(productID) >= 0 && majorFirmwareVer >= 0 && majorFirmwareVer < NUM_FIRMWARE_SLOTS;
+        }
+
+        static constexpr unsigned int SlotFor(int productID, int model, int majorFirmwareVer)
+        {
+            return (ProductSlot(productID) * NUM_FIRMWARE_SLOTS + majorFirmwareVer) * NUM_MODEL_SLOTS + model;
+        }
+
+        constexpr void Claim(int productID, int model, int majorFirmwareVer, unsigned int configIndex)
+        {
+            unsigned short & slot = m_slots[SlotFor(productID, model, majorFirmwareVer)];
+            if (slot == NO_CONFIG)
+                slot = static_cast<unsigned short>(configIndex);
+        }
+
+        unsigned short m_slots[NUM_SLOTS];
     };
 } // namespace Cedrus
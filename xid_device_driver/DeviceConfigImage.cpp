@@ -0,0 +1,621 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DeviceConfigImage.h"
+
+#if defined(_WIN32)
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <type_traits>
+
+namespace
+{
+    using Cedrus::DeviceConfig;
+    using Cedrus::DeviceConfigIndex;
+    using Cedrus::DevicePort;
+
+    // Both are copied to and from the image byte for byte.
+    static_assert(std::is_trivially_copyable<DeviceConfig>::value, "DeviceConfig must be trivially copyable");
+    static_assert(std::is_trivially_copyable<DeviceConfigIndex>::value, "DeviceConfigIndex must be trivially copyable");
+
+    enum { IMAGE_MAGIC = 0x43444958 }; // "XIDC" when written little-endian
+    enum { IMAGE_VERSION = 1 };
+
+    // The configs follow the header directly, and the index follows the configs.
+    struct ImageHeader
+    {
+        unsigned int magic;
+        unsigned int version;
+        unsigned int configSize;
+        unsigned int indexSize;
+        unsigned int configCount;
+        unsigned int configOffset;
+        unsigned int indexOffset;
+        unsigned int imageSize;
+    };
+
+    static_assert(sizeof(ImageHeader) % alignof(DeviceConfig) == 0, "configs must be aligned in the image");
+    static_assert(sizeof(DeviceConfig) % alignof(DeviceConfigIndex) == 0, "the index must be aligned in the image");
+
+    ImageHeader HeaderForConfigCount(unsigned int configCount)
+    {
+        ImageHeader header;
+        header.magic = IMAGE_MAGIC;
+        header.version = IMAGE_VERSION;
+        header.configSize = sizeof(DeviceConfig);
+        header.indexSize = sizeof(DeviceConfigIndex);
+        header.configCount = configCount;
+        header.configOffset = sizeof(ImageHeader);
+        header.indexOffset = header.configOffset + configCount * header.configSize;
+        header.imageSize = header.indexOffset + header.indexSize;
+
+        return header;
+    }
+
+    // Everything collected for one [DeviceInfo] section and the ports after it.
+    struct DeviceDescription
+    {
+        DeviceDescription()
+            : productID(-1),
+            modelID(-1),
+            majorFirmwareVer(-1),
+            outputLines(-1),
+            numberOfPorts(0),
+            firstLine(0)
+        {
+        }
+
+        std::string deviceName;
+        int productID;
+        int modelID;
+        int majorFirmwareVer;
+        int outputLines;
+        DevicePort ports[DeviceConfig::MAX_DEVICE_PORTS];
+        unsigned int numberOfPorts;
+        unsigned int firstLine;
+    };
+
+    struct PortDescription
+    {
+        PortDescription()
+            : portNumber(-1),
+            numberOfLines(0),
+            useableAsResponse(true),
+            keyMapSize(0)
+        {
+        }
+
+        std::string portName;
+        int portNumber;
+        int numberOfLines;
+        bool useableAsResponse;
+        int keyMapSize;
+        int keyMap[DevicePort::MAX_KEYS];
+    };
+
+    std::string Trim(const std::string & text)
+    {
+        const char * whitespace = " \t\r\n";
+        const size_t first = text.find_first_not_of(whitespace);
+
+        if (first == std::string::npos)
+            return std::string();
+
+        return text.substr(first, text.find_last_not_of(whitespace) - first + 1);
+    }
+
+    bool ParseInt(const std::string & text, int * value)
+    {
+        if (text.empty())
+            return false;
+
+        char * end = nullptr;
+        errno = 0;
+        const long result = strtol(text.c_str(), &end, 10);
+
+        if (*end != '\0' || errno != 0 || result < -0x7FFFFFFFL || result > 0x7FFFFFFFL)
+            return false;
+
+        *value = static_cast<int>(result);
+        return true;
+    }
+
+    class DescriptionParser
+    {
+    public:
+        DescriptionParser(const std::string & path,
+            std::vector<DeviceConfig> * configs,
+            std::function< void(std::string) > reportFunction)
+            : m_path(path),
+            m_configs(configs),
+            m_reportFunction(reportFunction),
+            m_lineNumber(0),
+            m_inDevice(false),
+            m_inPort(false),
+            m_deviceIsBad(false)
+        {
+        }
+
+        bool Parse()
+        {
+            std::ifstream file(m_path.c_str());
+            if (!file)
+            {
+                Report("could not be opened");
+                return false;
+            }
+
+            std::string line;
+            while (std::getline(file, line))
+            {
+                ++m_lineNumber;
+                line = Trim(line);
+
+                if (line.empty() || line[0] == ';' || line[0] == '#' || line.compare(0, 2, "//") == 0)
+                    continue;
+
+                if (line[0] == '[')
+                    StartSection(line);
+                else
+                    ParseSetting(line);
+            }
+
+            FinishDevice();
+            return true;
+        }
+
+    private:
+        void Report(const std::string & message)
+        {
+            if (m_reportFunction)
+            {
+                std::string location = m_path;
+                if (m_lineNumber > 0)
+                    location += ":" + std::to_string(m_lineNumber);
+
+                m_reportFunction(location + ": " + message);
+            }
+        }
+
+        void StartSection(const std::string & line)
+        {
+            FinishPort();
+
+            const size_t close = line.find(']');
+            const std::string section = close == std::string::npos ? std::string() : Trim(line.substr(1, close - 1));
+
+            if (section == "DeviceInfo")
+            {
+                FinishDevice();
+
+                m_device = DeviceDescription();
+                m_device.firstLine = m_lineNumber;
+                m_inDevice = true;
+                m_deviceIsBad = false;
+            }
+            else if (section.compare(0, 4, "Port") == 0)
+            {
+                m_port = PortDescription();
+                m_inPort = true;
+
+                if (!m_inDevice)
+                {
+                    Report("[" + section + "] comes before any [DeviceInfo]");
+                    m_inPort = false;
+                }
+                else if (!ParseInt(section.substr(4), &m_port.portNumber) || m_port.portNumber < 0)
+                {
+                    Report("bad port section [" + section + "]");
+                    m_deviceIsBad = true;
+                    m_inPort = false;
+                }
+                else if (m_port.portNumber >= DeviceConfig::LOOKUP_RANGE)
+                {
+                    // Responses are looked up by port in a table of this size.
+                    Report("[" + section + "]: port numbers above " +
+                        std::to_string(DeviceConfig::LOOKUP_RANGE - 1) + " are not supported");
+                    m_deviceIsBad = true;
+                    m_inPort = false;
+                }
+            }
+            else
+            {
+                // The old files have sections the library has no use for.
+                m_inPort = false;
+            }
+        }
+
+        void ParseSetting(const std::string & line)
+        {
+            if (!m_inDevice)
+                return;
+
+            const size_t equals = line.find('=');
+            if (equals == std::string::npos)
+            {
+                Report("expected \"Name = Value\"");
+                m_deviceIsBad = true;
+                return;
+            }
+
+            const std::string name = Trim(line.substr(0, equals));
+            const std::string value = Trim(line.substr(equals + 1));
+
+            if (m_inPort)
+                ParsePortSetting(name, value);
+            else
+                ParseDeviceSetting(name, value);
+        }
+
+        void ParseDeviceSetting(const std::string & name, const std::string & value)
+        {
+            int * number = nullptr;
+
+            if (name == "DeviceName")
+                m_device.deviceName = value;
+            else if (name == "XidProductID")
+                number = &m_device.productID;
+            else if (name == "XidModelID")
+                number = &m_device.modelID;
+            else if (name == "MajorFirmwareVersion")
+                number = &m_device.majorFirmwareVer;
+            else if (name == "OutputLines")
+                number = &m_device.outputLines;
+
+            if (number != nullptr && !ParseInt(value, number))
+            {
+                Report(name + " is not a number");
+                m_deviceIsBad = true;
+            }
+        }
+
+        void ParsePortSetting(const std::string & name, const std::string & value)
+        {
+            static const std::string key_map_prefix = "XidDeviceKeyMap";
+
+            if (name == "PortName")
+            {
+                m_port.portName = value;
+            }
+            else if (name == "NumberOfLines")
+            {
+                if (!ParseInt(value, &m_port.numberOfLines))
+                {
+                    Report("NumberOfLines is not a number");
+                    m_deviceIsBad = true;
+                }
+            }
+            else if (name == "UseableAsResponse")
+            {
+                m_port.useableAsResponse = (value != "No");
+            }
+            else if (name.compare(0, key_map_prefix.size(), key_map_prefix) == 0)
+            {
+                int key = -1;
+                int mapped_key = -1;
+
+                if (!ParseInt(name.substr(key_map_prefix.size()), &key) || key < 0 || key >= DevicePort::MAX_KEYS ||
+                    !ParseInt(value, &mapped_key) || mapped_key < -1 || mapped_key >= DevicePort::MAX_KEYS)
+                {
+                    Report("bad key mapping " + name + " = " + value);
+                    m_deviceIsBad = true;
+                    return;
+                }
+
+                // Keys without a mapping of their own are reported as they are.
+                for (; m_port.keyMapSize <= key; ++m_port.keyMapSize)
+                    m_port.keyMap[m_port.keyMapSize] = m_port.keyMapSize;
+
+                m_port.keyMap[key] = mapped_key;
+            }
+        }
+
+        void FinishPort()
+        {
+            if (!m_inPort)
+                return;
+
+            m_inPort = false;
+
+            if (!m_port.useableAsResponse)
+            {
+                if (m_device.outputLines < 0)
+                    m_device.outputLines = m_port.numberOfLines;
+
+                return;
+            }
+
+            if (m_device.numberOfPorts == DeviceConfig::MAX_DEVICE_PORTS)
+            {
+                Report("too many response ports, the limit is " + std::to_string(DeviceConfig::MAX_DEVICE_PORTS));
+                m_deviceIsBad = true;
+                return;
+            }
+
+            DevicePort & port = m_device.ports[m_device.numberOfPorts++];
+            port = DevicePort(m_port.portName.c_str(), m_port.portNumber, m_port.numberOfLines);
+            port.keyMapSize = m_port.keyMapSize;
+
+            for (int i = 0; i < m_port.keyMapSize; ++i)
+                port.keyMap[i] = m_port.keyMap[i];
+        }
+
+        void FinishDevice()
+        {
+            FinishPort();
+
+            if (!m_inDevice)
+                return;
+
+            m_inDevice = false;
+
+            const unsigned int line_number = m_lineNumber;
+            m_lineNumber = m_device.firstLine;
+
+            if (m_device.deviceName.empty() || m_device.productID < 0 || m_device.modelID < 0 || m_device.majorFirmwareVer < 0)
+            {
+                Report("DeviceName, XidProductID, XidModelID and MajorFirmwareVersion are all required");
+                m_deviceIsBad = true;
+            }
+
+            const DeviceConfig config(m_device.deviceName.c_str(),
+                m_device.productID,
+                m_device.modelID,
+                m_device.majorFirmwareVer,
+                m_device.outputLines < 0 ? 0 : m_device.outputLines,
+                m_device.ports,
+                m_device.numberOfPorts);
+
+            if (!m_deviceIsBad && !DeviceConfigIndex::CanHold(config))
+            {
+                Report("XidProductID " + std::to_string(m_device.productID) +
+                    ", XidModelID " + std::to_string(m_device.modelID) +
+                    " and MajorFirmwareVersion " + std::to_string(m_device.majorFirmwareVer) +
+                    " can never be matched to a device");
+                m_deviceIsBad = true;
+            }
+
+            if (m_deviceIsBad)
+                Report("device left out");
+            else
+                m_configs->push_back(config);
+
+            m_lineNumber = line_number;
+        }
+
+        const std::string m_path;
+        std::vector<DeviceConfig> * m_configs;
+        std::function< void(std::string) > m_reportFunction;
+
+        unsigned int m_lineNumber;
+        bool m_inDevice;
+        bool m_inPort;
+        bool m_deviceIsBad;
+        DeviceDescription m_device;
+        PortDescription m_port;
+    };
+}
+
+Cedrus::DeviceConfigImage::DeviceConfigImage()
+    : m_mapping(nullptr),
+    m_mappingSize(0),
+    m_configs(nullptr),
+    m_configCount(0),
+    m_index(nullptr)
+{
+}
+
+Cedrus::DeviceConfigImage::~DeviceConfigImage()
+{
+    Unload();
+}
+
+bool Cedrus::DeviceConfigImage::Compile(
+    const std::vector<std::string> & descriptionPaths,
+    const std::string & imagePath,
+    std::function< void(std::string) > reportFunction)
+{
+    std::vector<DeviceConfig> configs;
+
+    for (const std::string & path : descriptionPaths)
+    {
+        DescriptionParser parser(path, &configs, reportFunction);
+        parser.Parse();
+    }
+
+    if (configs.empty() || configs.size() >= DeviceConfigIndex::NO_CONFIG)
+    {
+        if (reportFunction)
+            reportFunction(imagePath + ": " + std::to_string(configs.size()) + " usable device configs, nothing written");
+
+        return false;
+    }
+
+    const ImageHeader header = HeaderForConfigCount(static_cast<unsigned int>(configs.size()));
+
+    const DeviceConfigIndex index = DeviceConfigIndex::Build(configs.data(), header.configCount);
+
+    std::ofstream image(imagePath.c_str(), std::ios::binary | std::ios::trunc);
+    image.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    image.write(reinterpret_cast<const char *>(configs.data()), configs.size() * sizeof(DeviceConfig));
+    image.write(reinterpret_cast<const char *>(&index), sizeof(DeviceConfigIndex));
+    image.close();
+
+    if (!image)
+    {
+        if (reportFunction)
+            reportFunction(imagePath + ": could not be written");
+
+        return false;
+    }
+
+    return true;
+}
+
+bool Cedrus::DeviceConfigImage::Load(const std::string & imagePath)
+{
+    Unload();
+
+    const void * mapping = nullptr;
+    size_t mapping_size = 0;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(imagePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart >= static_cast<LONGLONG>(sizeof(ImageHeader)))
+    {
+        HANDLE file_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (file_mapping != NULL)
+        {
+            mapping = MapViewOfFile(file_mapping, FILE_MAP_READ, 0, 0, 0);
+            mapping_size = static_cast<size_t>(file_size.QuadPart);
+            // The view keeps the mapping alive.
+            CloseHandle(file_mapping);
+        }
+    }
+
+    CloseHandle(file);
+#else
+    const int file = open(imagePath.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat file_info;
+    if (fstat(file, &file_info) == 0 && file_info.st_size >= static_cast<off_t>(sizeof(ImageHeader)))
+    {
+        void * view = mmap(nullptr, static_cast<size_t>(file_info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED)
+        {
+            mapping = view;
+            mapping_size = static_cast<size_t>(file_info.st_size);
+        }
+    }
+
+    close(file);
+#endif
+
+    if (mapping == nullptr)
+        return false;
+
+    m_mapping = mapping;
+    m_mappingSize = mapping_size;
+
+    const ImageHeader & header = *static_cast<const ImageHeader *>(mapping);
+    const ImageHeader expected = HeaderForConfigCount(header.configCount);
+
+    if (header.configCount == 0 ||
+        header.configCount >= DeviceConfigIndex::NO_CONFIG ||
+        memcmp(&header, &expected, sizeof(ImageHeader)) != 0 ||
+        header.imageSize != mapping_size)
+    {
+        Unload();
+        return false;
+    }
+
+    const char * image_bytes = static_cast<const char *>(mapping);
+    const DeviceConfig * configs = reinterpret_cast<const DeviceConfig *>(image_bytes + header.configOffset);
+    const DeviceConfigIndex * index = reinterpret_cast<const DeviceConfigIndex *>(image_bytes + header.indexOffset);
+
+    // Everything after the header is used as it is, so a damaged image has to
+    // be caught here rather than by a read out of bounds later.
+    bool well_formed = index->IsWellFormed(header.configCount);
+
+    for (unsigned int i = 0; i < header.configCount && well_formed; ++i)
+        well_formed = configs[i].IsWellFormed();
+
+    if (!well_formed)
+    {
+        Unload();
+        return false;
+    }
+
+    m_configs = configs;
+    m_configCount = header.configCount;
+    m_index = index;
+
+    return true;
+}
+
+void Cedrus::DeviceConfigImage::Unload()
+{
+    if (m_mapping != nullptr)
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(m_mapping);
+#else
+        munmap(const_cast<void *>(m_mapping), m_mappingSize);
+#endif
+    }
+
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_configs = nullptr;
+    m_configCount = 0;
+    m_index = nullptr;
+}
+
+bool Cedrus::DeviceConfigImage::IsLoaded() const
+{
+    return m_mapping != nullptr;
+}
+
+unsigned int Cedrus::DeviceConfigImage::ConfigCount() const
+{
+    return m_configCount;
+}
+
+const Cedrus::DeviceConfig * Cedrus::DeviceConfigImage::ConfigAtIndex(unsigned int i) const
+{
+    return i < m_configCount ? &m_configs[i] : nullptr;
+}
+
+const Cedrus::DeviceConfig * Cedrus::DeviceConfigImage::FindConfig(int productID, int modelID, int majorFirmwareVer) const
+{
+    if (m_index == nullptr)
+        return nullptr;
+
+    const unsigned int config_index = m_index->Find(productID, modelID, majorFirmwareVer);
+
+    return config_index < m_configCount ? &m_configs[config_index] : nullptr;
+}
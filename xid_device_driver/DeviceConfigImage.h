@@ -0,0 +1,97 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "DeviceConfig.h"
+#include "XidDriverImpExpDefs.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace Cedrus
+{
+    // Device configs for hardware that isn't in the built-in table. They are
+    // described in text files laid out like the old .devconfig files (see
+    // DeviceConfigRepository.h), with any number of devices per file, each
+    // starting at its [DeviceInfo] section. The output line count can be
+    // given as OutputLines in [DeviceInfo], or as a port that isn't
+    // UseableAsResponse, the way the old files did it.
+    //
+    // Description files are compiled into a binary image that holds the
+    // configs and their index exactly as they sit in memory, so loading one
+    // is a single file mapping with no parsing or allocation. An image is
+    // tied to the layout of the library that wrote it, and Load() rejects
+    // anything else, as well as any image whose contents don't check out;
+    // recompile from the description files when that happens.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceConfigImage
+    {
+    public:
+        DeviceConfigImage();
+        ~DeviceConfigImage();
+
+        // Problems with individual devices are passed to reportFunction and
+        // those devices are left out. Returns false if no image was written.
+        static bool Compile(
+            const std::vector<std::string> & descriptionPaths,
+            const std::string & imagePath,
+            std::function< void(std::string) > reportFunction = NULL);
+
+        bool Load(const std::string & imagePath);
+
+        void Unload();
+
+        bool IsLoaded() const;
+
+        unsigned int ConfigCount() const;
+
+        // nullptr when i is out of range.
+        const DeviceConfig * ConfigAtIndex(unsigned int i) const;
+
+        // Matches the same way as DeviceConfig::FindBuiltInConfig(), but
+        // returns nullptr rather than the invalid config when nothing in the
+        // image matches.
+        const DeviceConfig * FindConfig(int productID, int modelID, int majorFirmwareVer) const;
+
+    private:
+        DeviceConfigImage(const DeviceConfigImage &) = delete;
+        DeviceConfigImage & operator = (const DeviceConfigImage &) = delete;
+
+        const void * m_mapping;
+        size_t m_mappingSize;
+
+        const DeviceConfig * m_configs;
+        unsigned int m_configCount;
+        const DeviceConfigIndex * m_index;
+    };
+} // namespace Cedrus
@@ -1,15 +1,14 @@
 /*
 To whom it may concern, here is how this maps to the old .devconfig files:
 
-std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-530", 50, 49, 1, 6, devicePorts));
+DeviceConfig("RB-530", 50, 49, 1, 6, { ... })
 [DeviceInfo]
 MajorFirmwareVersion = 1
 DeviceName = RB-530
 XidProductID = 50
 XidModelID = 49
 
-std::vector<int> keyMap = { -1, 0, -1, 1, 2, 3, 4, -1 };
-Cedrus::DevicePort port("Key", 0, 5, keyMap);
+DevicePort("Key", 0, 5, { -1, 0, -1, 1, 2, 3, 4, -1 })
 [Port0]
 PortName = Key
 NumberOfLines = 5
@@ -33,395 +32,149 @@ UseableAsResponse = No
 #pragma once
 
 #include "DeviceConfig.h"
-#include <memory>
-
 
 namespace
 {
-    void CreateEmptyConfig(std::shared_ptr<Cedrus::DeviceConfig> & invalidCfgPtr)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Invalid Device", -1, -1, -1, 0, devicePorts));
-
-        invalidCfgPtr = config;
-    }
-
-    void CreateRB530Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { -1, 0, -1, 1, 2, 3, 4, -1 };
-        Cedrus::DevicePort port("Key", 0, 5, keyMap);
-        devicePorts.emplace(0, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-530", 50, 49, 1, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB540Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { -1, 0, -1, 1, 2, 3, 4, -1 };
-        Cedrus::DevicePort port("Key", 0, 5, keyMap);
-        devicePorts.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        devicePorts.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-540", 50, 49, 2, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB730Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { -1, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort port("Key", 0, 7, keyMap);
-        devicePorts.emplace(0, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-730", 50, 50, 1, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB740Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { -1, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort port("Key", 0, 7, keyMap);
-        devicePorts.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        devicePorts.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-740", 50, 50, 2, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB830Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { 7, 3, 4, 1, 2, 5, 6, 0 };
-        Cedrus::DevicePort port("Key", 0, 8, keyMap);
-        devicePorts.emplace(0, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-830", 50, 51, 1, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB840Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { 7, 3, 4, 1, 2, 5, 6, 0 };
-        Cedrus::DevicePort port("Key", 0, 8, keyMap);
-        devicePorts.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        devicePorts.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-840", 50, 51, 2, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB834Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { 7, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort port("Key", 0, 8, keyMap);
-        devicePorts.emplace(0, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-834", 50, 52, 1, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRB844Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { 7, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort port("Key", 0, 8, keyMap);
-        devicePorts.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        devicePorts.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("RB-844", 50, 52, 2, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRipondaModel_C_Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> device_ports;
-
-        std::vector<int>    key_map = { -1, 0, -1, 1, 2, 3, 4, -1 };
-        Cedrus::DevicePort  port("Key", 0, 5, key_map);
-        device_ports.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        device_ports.emplace(2, port);
-
-        port = Cedrus::DevicePort("Voice Key", 2, 1);
-        device_ports.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Riponda Model C", 53, 49, 2, 8, device_ports));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRipondaModel_L_Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> device_ports;
-
-        std::vector<int>    key_map = { -1, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort  port("Key", 0, 7, key_map);
-        device_ports.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        device_ports.emplace(2, port);
-
-        port = Cedrus::DevicePort("Voice Key", 2, 1);
-        device_ports.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Riponda Model L", 53, 50, 2, 8, device_ports));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRipondaModel_E_Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> device_ports;
-
-        std::vector<int>    key_map = { 7, 3, 4, 1, 2, 5, 6, 0 };
-        Cedrus::DevicePort  port("Key", 0, 8, key_map);
-        device_ports.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        device_ports.emplace(2, port);
-
-        port = Cedrus::DevicePort("Voice Key", 2, 1);
-        device_ports.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Riponda Model E", 53, 51, 2, 8, device_ports));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRipondaModel_S_Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> device_ports;
-
-        std::vector<int>    key_map = { 7, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort  port("Key", 0, 8, key_map);
-        device_ports.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        device_ports.emplace(2, port);
-
-        port = Cedrus::DevicePort("Voice Key", 2, 1);
-        device_ports.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Riponda Model S", 53, 52, 2, 8, device_ports));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateRipondaModel_NoModel_Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> device_ports;
-
-        std::vector<int>    key_map = { -1, 0, 1, 2, 3, 4, 5, 6 };
-        Cedrus::DevicePort  port("Key", 0, 7, key_map);
-        device_ports.emplace(0, port);
-
-        port = Cedrus::DevicePort("Light Sensor", 2, 1);
-        device_ports.emplace(2, port);
-
-        port = Cedrus::DevicePort("Voice Key", 2, 1);
-        device_ports.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Riponda No Model Set", 53, 48, 2, 8, device_ports));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateLuminaLP400Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { -1, 0, 1, 2, 3, 4, -1, -1 };
-        Cedrus::DevicePort port("Key + Scanner Trigger", 0, 5, keyMap);
-        devicePorts.emplace(0, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Lumina LP-400", 48, 69, 1, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateLumina3GConfig(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::vector<int> keyMap = { -1, 0, 1, 2, 3, 4, -1, -1 };
-        Cedrus::DevicePort port("Lumina Pad 1", 0, 5, keyMap);
-        devicePorts.emplace(0, port);
-
-        keyMap = { -1, 0, 1, 2, 3, 4, -1, -1 };
-        port = Cedrus::DevicePort("Lumina Pad 2", 1, 5, keyMap);
-        devicePorts.emplace(1, port);
-
-        port = Cedrus::DevicePort("Light Sensor + Scanner Trigger", 2, 2);
-        devicePorts.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("Lumina 3G", 48, 65, 2, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateSV1Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        Cedrus::DevicePort port("Voice Key", 2, 1);
-        devicePorts.emplace(2, port);
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("SV-1 Voice Key", 49, 66, 1, 8, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateST100Config(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        // 'S' and 'C'
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("StimTracker ST-100", 83, 67, 0, 8));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateST2DuoConfig(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        // 'S' and '1'
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("StimTracker Duo", 83, 49, 2, 16));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateST2QuadConfig(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        // 'S' and '2'
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("StimTracker Quad", 83, 50, 2, 16));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateST2QuadWithMpod4(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        // 'S' and '3'
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("StimTracker Quad", 83, 51, 2, 16));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateST2StimTrigger(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        // 'S' and '4'
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig("StimTrigger", 83, 52, 2, 16));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void AddPodConfig(std::string deviceName,
-        int productID,
-        int modelID,
-        int majorFirmwareVer,
-        unsigned int num_lines,
-        std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        std::map<unsigned int, Cedrus::DevicePort> devicePorts;
-
-        std::shared_ptr<Cedrus::DeviceConfig> config(new Cedrus::DeviceConfig(deviceName, productID, modelID, majorFirmwareVer, num_lines, devicePorts));
-
-        listOfAllConfigs.push_back(config);
-    }
-
-    void CreateAllmpodConfigs(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        AddPodConfig("m-pod for ABM", 51, 97, 2, 8, listOfAllConfigs); // 'a'
-        AddPodConfig("m-pod for ADI", 51, 65, 2, 8, listOfAllConfigs); // 'A'
-        AddPodConfig("m-pod for ANT Neuro", 51, 67, 2, 8, listOfAllConfigs); // 'C'
-        AddPodConfig("m-pod for Biopac MP35/36", 51, 68, 2, 8, listOfAllConfigs); // 'D'
-        AddPodConfig("m-pod for Biopac MP150(STP100C module)", 51, 69, 2, 8, listOfAllConfigs); // 'E'
-        AddPodConfig("m-pod for Biosemi", 51, 70, 2, 16, listOfAllConfigs); // 'F'
-        AddPodConfig("m-pod for BNC", 51, 99, 2, 8, listOfAllConfigs); // 'c'
-        AddPodConfig("m-pod for Brain Products actiCHamp", 51, 77, 2, 8, listOfAllConfigs); // 'M'
-        AddPodConfig("m-pod for Brain Products DB-26", 51, 66, 2, 16, listOfAllConfigs); // 'B'
-        AddPodConfig("m-pod for Bittium NeurOne", 51, 110, 2, 8, listOfAllConfigs); // 'n'
-        AddPodConfig("m-pod for CGX Systems", 51, 88, 2, 16, listOfAllConfigs); // 'X'
-        AddPodConfig("m-pod for EGI (rev A)", 51, 79, 2, 8, listOfAllConfigs); // 'O'
-        AddPodConfig("m-pod for EGI (rev B, opto isolated)", 51, 111, 2, 8, listOfAllConfigs); // 'o'
-        AddPodConfig("m-pod for iWorx", 51, 105, 2, 8, listOfAllConfigs); // 'i'
-        AddPodConfig("m-pod for MindWare (rev B)", 51, 103, 2, 9, listOfAllConfigs); // 'g'
-        AddPodConfig("m-pod for Natus", 51, 89, 2, 8, listOfAllConfigs); // 'Y'
-        AddPodConfig("m-pod for NeuraLynx", 51, 82, 2, 16, listOfAllConfigs); // 'R'
-        AddPodConfig("m-pod for Neuroscan 16-bit", 51, 72, 2, 16, listOfAllConfigs); // 'H'
-        AddPodConfig("m-pod for Neuroscan Grael", 51, 104, 2, 16, listOfAllConfigs); // 'h'
-        AddPodConfig("m-pod for NIRx", 51, 78, 2, 8, listOfAllConfigs); // 'N'
-        AddPodConfig("m-pod for Parallel port", 51, 80, 2, 13, listOfAllConfigs); // 'P'
-        AddPodConfig("m-pod for SMI", 51, 74, 2, 8, listOfAllConfigs); // 'J'
-        AddPodConfig("m-pod for SR Research", 51, 115, 2, 8, listOfAllConfigs); // 's'
-        AddPodConfig("m-pod for Smart Eye", 51, 101, 2, 8, listOfAllConfigs); // 'e'
-        AddPodConfig("m-pod for TMSi", 51, 116, 2, 8, listOfAllConfigs); // 't'
-        AddPodConfig("m-pod for Tobii", 51, 84, 2, 8, listOfAllConfigs); // 'T'
-        AddPodConfig("m-pod for Zeto", 51, 122, 2, 8, listOfAllConfigs); // 'Z'
-        AddPodConfig("Universal m-pod", 51, 85, 2, 9, listOfAllConfigs); // 'U'
-        AddPodConfig("Analog m-pod", 51, 86, 2, 8, listOfAllConfigs); // 'V'
-        AddPodConfig("m-pod no model set", 51, 48, 2, 16, listOfAllConfigs); // '0'
-    }
-
-    void CreateAllcpodConfigs(std::vector<std::shared_ptr<Cedrus::DeviceConfig> > & listOfAllConfigs)
-    {
-        AddPodConfig("c-pod for ABM", 52, 97, 2, 8, listOfAllConfigs); // 'a'
-        AddPodConfig("c-pod for ADI", 52, 65, 2, 8, listOfAllConfigs); // 'A'
-        AddPodConfig("c-pod for ANT Neuro", 52, 67, 2, 8, listOfAllConfigs); // 'C'
-        AddPodConfig("c-pod for Biopac MP35/36", 52, 68, 2, 8, listOfAllConfigs); // 'D'
-        AddPodConfig("c-pod for Biopac MP150(STP100C module)", 52, 69, 2, 8, listOfAllConfigs); // 'E'
-        AddPodConfig("c-pod for Biosemi", 52, 70, 2, 16, listOfAllConfigs); // 'F'
-        AddPodConfig("c-pod for BNC", 52, 99, 2, 8, listOfAllConfigs); // 'c'
-        AddPodConfig("c-pod for Brain Products actiCHamp", 52, 77, 2, 8, listOfAllConfigs); // 'M'
-        AddPodConfig("c-pod for Brain Products DB-26", 52, 66, 2, 16, listOfAllConfigs); // 'B'
-        AddPodConfig("c-pod for Bittium NeurOne", 52, 110, 2, 8, listOfAllConfigs); // 'n'
-        AddPodConfig("c-pod for CGX Systems", 52, 88, 2, 16, listOfAllConfigs); // 'X'
-        AddPodConfig("c-pod for EGI (rev A)", 52, 79, 2, 8, listOfAllConfigs); // 'O'
-        AddPodConfig("c-pod for EGI (rev B, opto isolated)", 52, 111, 2, 8, listOfAllConfigs); // 'o'
-        AddPodConfig("c-pod for iWorx", 52, 105, 2, 8, listOfAllConfigs); // 'i'
-        AddPodConfig("c-pod for MindWare (rev B)", 52, 103, 2, 9, listOfAllConfigs); // 'g'
-        AddPodConfig("c-pod for Natus", 52, 89, 2, 8, listOfAllConfigs); // 'Y'
-        AddPodConfig("c-pod for NeuraLynx", 52, 82, 2, 16, listOfAllConfigs); // 'R'
-        AddPodConfig("c-pod for Neuroscan 16-bit", 52, 72, 2, 16, listOfAllConfigs); // 'H'
-        AddPodConfig("c-pod for Neuroscan Grael", 52, 104, 2, 16, listOfAllConfigs); // 'h'
-        AddPodConfig("c-pod for NIRx", 52, 78, 2, 8, listOfAllConfigs); // 'N'
-        AddPodConfig("c-pod for Parallel port", 52, 80, 2, 13, listOfAllConfigs); // 'P'
-        AddPodConfig("c-pod for SMI", 52, 74, 2, 8, listOfAllConfigs); // 'J'
-        AddPodConfig("c-pod for SR Research", 52, 115, 2, 8, listOfAllConfigs); // 's'
-        AddPodConfig("c-pod for Smart Eye", 52, 101, 2, 8, listOfAllConfigs); // 'e'
-        AddPodConfig("c-pod for TMSi", 52, 116, 2, 8, listOfAllConfigs); // 't'
-        AddPodConfig("c-pod for Tobii", 52, 84, 2, 8, listOfAllConfigs); // 'T'
-        AddPodConfig("c-pod for Zeto", 52, 122, 2, 8, listOfAllConfigs); // 'Z'
-        AddPodConfig("Universal c-pod", 52, 85, 2, 9, listOfAllConfigs); // 'U'
-        AddPodConfig("Analog c-pod", 52, 86, 2, 8, listOfAllConfigs); // 'V'
-        AddPodConfig("c-pod no model set", 52, 48, 2, 16, listOfAllConfigs); // '0'
-    }
+    using Cedrus::DeviceConfig;
+    using Cedrus::DevicePort;
+    using Cedrus::DeviceConfigIndex;
+
+    // Order matters: when more than one config matches a device, the first one wins.
+    constexpr DeviceConfig BUILT_IN_CONFIGS[] =
+    {
+        DeviceConfig("RB-530", 50, 49, 1, 8,
+            { DevicePort("Key", 0, 5, { -1, 0, -1, 1, 2, 3, 4, -1 }) }),
+
+        DeviceConfig("RB-540", 50, 49, 2, 8,
+            { DevicePort("Key", 0, 5, { -1, 0, -1, 1, 2, 3, 4, -1 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("RB-730", 50, 50, 1, 8,
+            { DevicePort("Key", 0, 7, { -1, 0, 1, 2, 3, 4, 5, 6 }) }),
+
+        DeviceConfig("RB-740", 50, 50, 2, 8,
+            { DevicePort("Key", 0, 7, { -1, 0, 1, 2, 3, 4, 5, 6 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("RB-830", 50, 51, 1, 8,
+            { DevicePort("Key", 0, 8, { 7, 3, 4, 1, 2, 5, 6, 0 }) }),
+
+        DeviceConfig("RB-840", 50, 51, 2, 8,
+            { DevicePort("Key", 0, 8, { 7, 3, 4, 1, 2, 5, 6, 0 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("RB-834", 50, 52, 1, 8,
+            { DevicePort("Key", 0, 8, { 7, 0, 1, 2, 3, 4, 5, 6 }) }),
+
+        DeviceConfig("RB-844", 50, 52, 2, 8,
+            { DevicePort("Key", 0, 8, { 7, 0, 1, 2, 3, 4, 5, 6 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        // The Riponda's voice key reports on port 2 as well, so it shares the
+        // light sensor's entry.
+        DeviceConfig("Riponda Model C", 53, 49, 2, 8,
+            { DevicePort("Key", 0, 5, { -1, 0, -1, 1, 2, 3, 4, -1 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("Riponda Model L", 53, 50, 2, 8,
+            { DevicePort("Key", 0, 7, { -1, 0, 1, 2, 3, 4, 5, 6 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("Riponda Model E", 53, 51, 2, 8,
+            { DevicePort("Key", 0, 8, { 7, 3, 4, 1, 2, 5, 6, 0 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("Riponda Model S", 53, 52, 2, 8,
+            { DevicePort("Key", 0, 8, { 7, 0, 1, 2, 3, 4, 5, 6 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("Riponda No Model Set", 53, 48, 2, 8,
+            { DevicePort("Key", 0, 7, { -1, 0, 1, 2, 3, 4, 5, 6 }),
+              DevicePort("Light Sensor", 2, 1) }),
+
+        DeviceConfig("Lumina LP-400", 48, 69, 1, 8,
+            { DevicePort("Key + Scanner Trigger", 0, 5, { -1, 0, 1, 2, 3, 4, -1, -1 }) }),
+
+        DeviceConfig("Lumina 3G", 48, 65, 2, 8,
+            { DevicePort("Lumina Pad 1", 0, 5, { -1, 0, 1, 2, 3, 4, -1, -1 }),
+              DevicePort("Lumina Pad 2", 1, 5, { -1, 0, 1, 2, 3, 4, -1, -1 }),
+              DevicePort("Light Sensor + Scanner Trigger", 2, 2) }),
+
+        DeviceConfig("SV-1 Voice Key", 49, 66, 1, 8,
+            { DevicePort("Voice Key", 2, 1) }),
+
+        DeviceConfig("StimTracker ST-100", 83, 67, 0, 8), // 'S' and 'C'
+        DeviceConfig("StimTracker Duo", 83, 49, 2, 16), // 'S' and '1'
+        DeviceConfig("StimTracker Quad", 83, 50, 2, 16), // 'S' and '2'
+        DeviceConfig("StimTracker Quad", 83, 51, 2, 16), // 'S' and '3'
+        DeviceConfig("StimTrigger", 83, 52, 2, 16), // 'S' and '4'
+
+        DeviceConfig("m-pod for ABM", 51, 97, 2, 8), // 'a'
+        DeviceConfig("m-pod for ADI", 51, 65, 2, 8), // 'A'
+        DeviceConfig("m-pod for ANT Neuro", 51, 67, 2, 8), // 'C'
+        DeviceConfig("m-pod for Biopac MP35/36", 51, 68, 2, 8), // 'D'
+        DeviceConfig("m-pod for Biopac MP150(STP100C module)", 51, 69, 2, 8), // 'E'
+        DeviceConfig("m-pod for Biosemi", 51, 70, 2, 16), // 'F'
+        DeviceConfig("m-pod for BNC", 51, 99, 2, 8), // 'c'
+        DeviceConfig("m-pod for Brain Products actiCHamp", 51, 77, 2, 8), // 'M'
+        DeviceConfig("m-pod for Brain Products DB-26", 51, 66, 2, 16), // 'B'
+        DeviceConfig("m-pod for Bittium NeurOne", 51, 110, 2, 8), // 'n'
+        DeviceConfig("m-pod for CGX Systems", 51, 88, 2, 16), // 'X'
+        DeviceConfig("m-pod for EGI (rev A)", 51, 79, 2, 8), // 'O'
+        DeviceConfig("m-pod for EGI (rev B, opto isolated)", 51, 111, 2, 8), // 'o'
+        DeviceConfig("m-pod for iWorx", 51, 105, 2, 8), // 'i'
+        DeviceConfig("m-pod for MindWare (rev B)", 51, 103, 2, 9), // 'g'
+        DeviceConfig("m-pod for Natus", 51, 89, 2, 8), // 'Y'
+        DeviceConfig("m-pod for NeuraLynx", 51, 82, 2, 16), // 'R'
+        DeviceConfig("m-pod for Neuroscan 16-bit", 51, 72, 2, 16), // 'H'
+        DeviceConfig("m-pod for Neuroscan Grael", 51, 104, 2, 16), // 'h'
+        DeviceConfig("m-pod for NIRx", 51, 78, 2, 8), // 'N'
+        DeviceConfig("m-pod for Parallel port", 51, 80, 2, 13), // 'P'
+        DeviceConfig("m-pod for SMI", 51, 74, 2, 8), // 'J'
+        DeviceConfig("m-pod for SR Research", 51, 115, 2, 8), // 's'
+        DeviceConfig("m-pod for Smart Eye", 51, 101, 2, 8), // 'e'
+        DeviceConfig("m-pod for TMSi", 51, 116, 2, 8), // 't'
+        DeviceConfig("m-pod for Tobii", 51, 84, 2, 8), // 'T'
+        DeviceConfig("m-pod for Zeto", 51, 122, 2, 8), // 'Z'
+        DeviceConfig("Universal m-pod", 51, 85, 2, 9), // 'U'
+        DeviceConfig("Analog m-pod", 51, 86, 2, 8), // 'V'
+        DeviceConfig("m-pod no model set", 51, 48, 2, 16), // '0'
+
+        DeviceConfig("c-pod for ABM", 52, 97, 2, 8), // 'a'
+        DeviceConfig("c-pod for ADI", 52, 65, 2, 8), // 'A'
+        DeviceConfig("c-pod for ANT Neuro", 52, 67, 2, 8), // 'C'
+        DeviceConfig("c-pod for Biopac MP35/36", 52, 68, 2, 8), // 'D'
+        DeviceConfig("c-pod for Biopac MP150(STP100C module)", 52, 69, 2, 8), // 'E'
+        DeviceConfig("c-pod for Biosemi", 52, 70, 2, 16), // 'F'
+        DeviceConfig("c-pod for BNC", 52, 99, 2, 8), // 'c'
+        DeviceConfig("c-pod for Brain Products actiCHamp", 52, 77, 2, 8), // 'M'
+        DeviceConfig("c-pod for Brain Products DB-26", 52, 66, 2, 16), // 'B'
+        DeviceConfig("c-pod for Bittium NeurOne", 52, 110, 2, 8), // 'n'
+        DeviceConfig("c-pod for CGX Systems", 52, 88, 2, 16), // 'X'
+        DeviceConfig("c-pod for EGI (rev A)", 52, 79, 2, 8), // 'O'
+        DeviceConfig("c-pod for EGI (rev B, opto isolated)", 52, 111, 2, 8), // 'o'
+        DeviceConfig("c-pod for iWorx", 52, 105, 2, 8), // 'i'
+        DeviceConfig("c-pod for MindWare (rev B)", 52, 103, 2, 9), // 'g'
+        DeviceConfig("c-pod for Natus", 52, 89, 2, 8), // 'Y'
+        DeviceConfig("c-pod for NeuraLynx", 52, 82, 2, 16), // 'R'
+        DeviceConfig("c-pod for Neuroscan 16-bit", 52, 72, 2, 16), // 'H'
+        DeviceConfig("c-pod for Neuroscan Grael", 52, 104, 2, 16), // 'h'
+        DeviceConfig("c-pod for NIRx", 52, 78, 2, 8), // 'N'
+        DeviceConfig("c-pod for Parallel port", 52, 80, 2, 13), // 'P'
+        DeviceConfig("c-pod for SMI", 52, 74, 2, 8), // 'J'
+        DeviceConfig("c-pod for SR Research", 52, 115, 2, 8), // 's'
+        DeviceConfig("c-pod for Smart Eye", 52, 101, 2, 8), // 'e'
+        DeviceConfig("c-pod for TMSi", 52, 116, 2, 8), // 't'
+        DeviceConfig("c-pod for Tobii", 52, 84, 2, 8), // 'T'
+        DeviceConfig("c-pod for Zeto", 52, 122, 2, 8), // 'Z'
+        DeviceConfig("Universal c-pod", 52, 85, 2, 9), // 'U'
+        DeviceConfig("Analog c-pod", 52, 86, 2, 8), // 'V'
+        DeviceConfig("c-pod no model set", 52, 48, 2, 16), // '0'
+    };
+
+    constexpr unsigned int NUM_BUILT_IN_CONFIGS = sizeof(BUILT_IN_CONFIGS) / sizeof(BUILT_IN_CONFIGS[0]);
+
+    constexpr DeviceConfigIndex BUILT_IN_CONFIG_INDEX = DeviceConfigIndex::Build(BUILT_IN_CONFIGS, NUM_BUILT_IN_CONFIGS);
+
+    constexpr DeviceConfig INVALID_CONFIG("Invalid Device", -1, -1, -1, 0);
 }
@@ -0,0 +1,175 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DeviceSettingsSnapshot.h"
+
+namespace
+{
+    using Cedrus::DeviceSettingsSnapshot;
+
+    typedef long long DeviceSettingsSnapshot::*ScalarSetting;
+    typedef long long (DeviceSettingsSnapshot::*PerInputSetting)[DeviceSettingsSnapshot::MAX_INPUT_SELECTORS];
+
+    struct NamedScalarSetting
+    {
+        const char * name;
+        ScalarSetting field;
+    };
+
+    struct NamedPerInputSetting
+    {
+        const char * name;
+        PerInputSetting field;
+    };
+
+    const NamedScalarSetting SCALAR_SETTINGS[] =
+    {
+        { "outputLogic", &DeviceSettingsSnapshot::outputLogic },
+        { "accessoryConnectorMode", &DeviceSettingsSnapshot::accessoryConnectorMode },
+        { "acDebouncingTime", &DeviceSettingsSnapshot::acDebouncingTime },
+        { "mpodOutputEnabled", &DeviceSettingsSnapshot::mpodOutputEnabled },
+        { "mpodOutputMode", &DeviceSettingsSnapshot::mpodOutputMode },
+        { "translationTable", &DeviceSettingsSnapshot::translationTable },
+        { "mpodPulseDuration", &DeviceSettingsSnapshot::mpodPulseDuration },
+        { "podOutputLogic", &DeviceSettingsSnapshot::podOutputLogic },
+        { "triggerDefault", &DeviceSettingsSnapshot::triggerDefault },
+        { "triggerDebounceTime", &DeviceSettingsSnapshot::triggerDebounceTime },
+        { "buttonDebounceTime", &DeviceSettingsSnapshot::buttonDebounceTime },
+        { "opticalIsolationSwitch", &DeviceSettingsSnapshot::opticalIsolationSwitch },
+        { "kbAutorepeat", &DeviceSettingsSnapshot::kbAutorepeat },
+        { "ledFunction", &DeviceSettingsSnapshot::ledFunction },
+        { "outputPaused", &DeviceSettingsSnapshot::outputPaused },
+        { "mixedInputMode", &DeviceSettingsSnapshot::mixedInputMode },
+        { "numberOfLines", &DeviceSettingsSnapshot::numberOfLines },
+        { "pulseDuration", &DeviceSettingsSnapshot::pulseDuration },
+        { "maxVoltageRange", &DeviceSettingsSnapshot::maxVoltageRange },
+        { "maxVoltageRangeForTesting", &DeviceSettingsSnapshot::maxVoltageRangeForTesting },
+        { "analogOutputMode", &DeviceSettingsSnapshot::analogOutputMode },
+        { "analogOutputLevels", &DeviceSettingsSnapshot::analogOutputLevels },
+    };
+
+    const NamedPerInputSetting PER_INPUT_SETTINGS[] =
+    {
+        { "singleShotEnabled", &DeviceSettingsSnapshot::singleShotEnabled },
+        { "singleShotDelay", &DeviceSettingsSnapshot::singleShotDelay },
+        { "signalFilterHoldOn", &DeviceSettingsSnapshot::signalFilterHoldOn },
+        { "signalFilterHoldOff", &DeviceSettingsSnapshot::signalFilterHoldOff },
+        { "digitalOutputEnabled", &DeviceSettingsSnapshot::digitalOutputEnabled },
+        { "timerResetOnOnset", &DeviceSettingsSnapshot::timerResetOnOnset },
+        { "usbOutputEnabled", &DeviceSettingsSnapshot::usbOutputEnabled },
+        { "analogInputThreshold", &DeviceSettingsSnapshot::analogInputThreshold },
+    };
+
+    long long PerInputValue(const DeviceSettingsSnapshot & snapshot, PerInputSetting field, char selector)
+    {
+        const std::string::size_type i = snapshot.inputSelectors.find(selector);
+
+        return i < DeviceSettingsSnapshot::MAX_INPUT_SELECTORS ? (snapshot.*field)[i] : DeviceSettingsSnapshot::NOT_APPLICABLE;
+    }
+}
+
+Cedrus::DeviceSettingsSnapshot::DeviceSettingsSnapshot()
+{
+    for (const NamedScalarSetting & setting : SCALAR_SETTINGS)
+        this->*setting.field = NOT_APPLICABLE;
+
+    for (const NamedPerInputSetting & setting : PER_INPUT_SETTINGS)
+    {
+        for (long long & value : this->*setting.field)
+            value = NOT_APPLICABLE;
+    }
+}
+
+std::vector<Cedrus::SettingDifference> Cedrus::DiffSettingsSnapshots(
+    const DeviceSettingsSnapshot & before,
+    const DeviceSettingsSnapshot & after)
+{
+    std::vector<SettingDifference> differences;
+
+    for (const NamedScalarSetting & setting : SCALAR_SETTINGS)
+    {
+        if (before.*setting.field != after.*setting.field)
+            differences.push_back({ setting.name, before.*setting.field, after.*setting.field });
+    }
+
+    std::string selectors = before.inputSelectors;
+    for (char selector : after.inputSelectors)
+    {
+        if (selectors.find(selector) == std::string::npos)
+            selectors += selector;
+    }
+
+    for (const NamedPerInputSetting & setting : PER_INPUT_SETTINGS)
+    {
+        for (char selector : selectors)
+        {
+            const long long before_value = PerInputValue(before, setting.field, selector);
+            const long long after_value = PerInputValue(after, setting.field, selector);
+
+            if (before_value != after_value)
+                differences.push_back({ std::string(setting.name) + "[" + selector + "]", before_value, after_value });
+        }
+    }
+
+    return differences;
+}
+
+Cedrus::DeviceSettingsSnapshot Cedrus::MergeSettingsSnapshots(
+    const DeviceSettingsSnapshot & base,
+    const DeviceSettingsSnapshot & overrides)
+{
+    DeviceSettingsSnapshot merged = base;
+
+    for (const NamedScalarSetting & setting : SCALAR_SETTINGS)
+    {
+        if (base.*setting.field != DeviceSettingsSnapshot::NOT_APPLICABLE &&
+            overrides.*setting.field != DeviceSettingsSnapshot::NOT_APPLICABLE)
+        {
+            merged.*setting.field = overrides.*setting.field;
+        }
+    }
+
+    for (const NamedPerInputSetting & setting : PER_INPUT_SETTINGS)
+    {
+        for (unsigned int i = 0; i < base.inputSelectors.size() && i < DeviceSettingsSnapshot::MAX_INPUT_SELECTORS; ++i)
+        {
+            const long long override_value = PerInputValue(overrides, setting.field, base.inputSelectors[i]);
+
+            if ((base.*setting.field)[i] != DeviceSettingsSnapshot::NOT_APPLICABLE &&
+                override_value != DeviceSettingsSnapshot::NOT_APPLICABLE)
+            {
+                (merged.*setting.field)[i] = override_value;
+            }
+        }
+    }
+
+    return merged;
+}
@@ -0,0 +1,121 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace Cedrus
+{
+    // The device's settings as of one moment, read by
+    // XIDDevice::GetSettingsSnapshot(). Each field holds the value its query
+    // (noted next to it) reported, or NOT_APPLICABLE when the device doesn't
+    // have that setting or gave no valid answer. Per-input settings are indexed like inputSelectors.
+    struct CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceSettingsSnapshot
+    {
+        static constexpr long long NOT_APPLICABLE = -1;
+        enum { MAX_INPUT_SELECTORS = 4 };
+
+        DeviceSettingsSnapshot();
+
+        long long outputLogic; // _a0
+        long long accessoryConnectorMode; // _a1
+        long long acDebouncingTime; // _a6
+        long long mpodOutputEnabled; // _ae
+        long long mpodOutputMode; // _am
+        long long translationTable; // _as
+        long long mpodPulseDuration; // _aw
+        long long podOutputLogic; // _al
+
+        long long triggerDefault; // _f4
+        long long triggerDebounceTime; // _f5
+        long long buttonDebounceTime; // _f6
+        long long opticalIsolationSwitch; // _fo
+
+        long long kbAutorepeat; // _ig
+        long long ledFunction; // _il
+        long long outputPaused; // _ip
+        long long mixedInputMode; // _iv
+
+        long long numberOfLines; // _ml
+        long long pulseDuration; // _mp
+
+        long long maxVoltageRange; // _vr
+        long long maxVoltageRangeForTesting; // _vt
+        long long analogOutputMode; // _vm
+        long long analogOutputLevels; // _vl
+
+        std::string inputSelectors;
+        long long singleShotEnabled[MAX_INPUT_SELECTORS]; // _ia
+        long long singleShotDelay[MAX_INPUT_SELECTORS]; // _ia
+        long long signalFilterHoldOn[MAX_INPUT_SELECTORS]; // _if
+        long long signalFilterHoldOff[MAX_INPUT_SELECTORS]; // _if
+        long long digitalOutputEnabled[MAX_INPUT_SELECTORS]; // _io
+        long long timerResetOnOnset[MAX_INPUT_SELECTORS]; // _ir
+        long long usbOutputEnabled[MAX_INPUT_SELECTORS]; // _iu
+        long long analogInputThreshold[MAX_INPUT_SELECTORS]; // _it
+    };
+
+    struct SettingDifference
+    {
+        std::string setting; // e.g. "pulseDuration" or "signalFilterHoldOn[A]"
+        long long before;
+        long long after;
+    };
+
+    // What XIDDevice::ApplySettingsProfile() changed, as read back from the
+    // device, and how long it took including the initial read and the flash
+    // commit. committedToFlash is false if nothing needed writing, or if
+    // saving the settings or the line mapping failed.
+    struct SettingsProfileResult
+    {
+        std::vector<SettingDifference> changes;
+        std::chrono::microseconds elapsed = std::chrono::microseconds(0);
+        bool committedToFlash = false;
+    };
+
+    // Lists every setting whose value differs between the two snapshots,
+    // including settings that only apply in one of them. Per-input settings
+    // are matched by selector.
+    CEDRUS_XIDDRIVER_IMPORTEXPORT std::vector<SettingDifference> DiffSettingsSnapshots(
+        const DeviceSettingsSnapshot & before,
+        const DeviceSettingsSnapshot & after);
+
+    // Returns base with every setting that applies in both snapshots taken
+    // from overrides. Per-input settings are matched by selector.
+    CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceSettingsSnapshot MergeSettingsSnapshots(
+        const DeviceSettingsSnapshot & base,
+        const DeviceSettingsSnapshot & overrides);
+} // namespace Cedrus
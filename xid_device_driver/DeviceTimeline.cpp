@@ -0,0 +1,93 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "DeviceTimeline.h"
+
+namespace
+{
+    const long long TIMER_PERIOD_MS = 0x100000000LL;
+}
+
+Cedrus::DeviceTimeline::DeviceTimeline()
+{
+    Forget();
+}
+
+void Cedrus::DeviceTimeline::Reset(std::chrono::steady_clock::time_point hostTime)
+{
+    m_known = true;
+    m_lastDeviceTimeMs = 0;
+    m_lastHostTime = hostTime;
+}
+
+void Cedrus::DeviceTimeline::Forget()
+{
+    m_known = false;
+    m_lastDeviceTimeMs = 0;
+    m_lastHostTime = std::chrono::steady_clock::time_point();
+}
+
+bool Cedrus::DeviceTimeline::IsKnown() const
+{
+    return m_known;
+}
+
+long long Cedrus::DeviceTimeline::Extend(unsigned int deviceTimeMs, std::chrono::steady_clock::time_point hostTime)
+{
+    long long extended = deviceTimeMs;
+
+    if (m_known)
+    {
+        // Whichever rollover puts the reading closest to where the timer
+        // should be by now.
+        const long long expected = EstimateDeviceTime(hostTime);
+        extended += expected - expected % TIMER_PERIOD_MS;
+
+        if (extended - expected > TIMER_PERIOD_MS / 2)
+            extended -= TIMER_PERIOD_MS;
+        else if (expected - extended > TIMER_PERIOD_MS / 2)
+            extended += TIMER_PERIOD_MS;
+
+        if (extended < 0)
+            extended += TIMER_PERIOD_MS;
+    }
+
+    m_known = true;
+    m_lastDeviceTimeMs = extended;
+    m_lastHostTime = hostTime;
+
+    return extended;
+}
+
+long long Cedrus::DeviceTimeline::EstimateDeviceTime(std::chrono::steady_clock::time_point hostTime) const
+{
+    return m_lastDeviceTimeMs + std::chrono::duration_cast<std::chrono::milliseconds>(hostTime - m_lastHostTime).count();
+}
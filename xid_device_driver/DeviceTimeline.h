@@ -0,0 +1,72 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <chrono>
+
+namespace Cedrus
+{
+    // Extends the device's 32-bit millisecond timer, which rolls over every
+    // 49.7 days, to 64 bits. Host time elapsed since the previous reading
+    // says which rollover a reading belongs to, so even readings many
+    // rollovers apart come out right.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT DeviceTimeline
+    {
+    public:
+        // The device time after which the last byte of an XID packet, the
+        // top byte of the timer, is no longer 0. About 4.66 hours.
+        static constexpr long long HIGH_TIME_BYTE_BOUNDARY_MS = 0x01000000;
+
+        DeviceTimeline();
+
+        // The timer was reset to 0 at hostTime.
+        void Reset(std::chrono::steady_clock::time_point hostTime);
+
+        // Nothing is known about the timer. The next reading is taken to be
+        // from before the first rollover.
+        void Forget();
+
+        bool IsKnown() const;
+
+        long long Extend(unsigned int deviceTimeMs, std::chrono::steady_clock::time_point hostTime);
+
+        // Where the timer should be at hostTime. Only meaningful if IsKnown().
+        long long EstimateDeviceTime(std::chrono::steady_clock::time_point hostTime) const;
+
+    private:
+        bool m_known;
+        long long m_lastDeviceTimeMs;
+        std::chrono::steady_clock::time_point m_lastHostTime;
+    };
+} // namespace Cedrus
@@ -0,0 +1,197 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "LatencyHistogram.h"
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    const std::memory_order RELAXED = std::memory_order_relaxed;
+
+    unsigned int HighestSetBit(unsigned long long value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+            return index + 32;
+        _BitScanReverse(&index, static_cast<unsigned long>(value));
+        return index;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    // Only one thread records at a time, so there's no need for the cost of
+    // an atomic increment.
+    void Add(std::atomic<unsigned long long> & counter, unsigned long long amount)
+    {
+        counter.store(counter.load(RELAXED) + amount, RELAXED);
+    }
+}
+
+Cedrus::LatencyHistogram::LatencyHistogram()
+{
+    Reset();
+}
+
+Cedrus::LatencyHistogram::LatencyHistogram(const LatencyHistogram & other)
+{
+    *this = other;
+}
+
+Cedrus::LatencyHistogram& Cedrus::LatencyHistogram::operator=(const LatencyHistogram & other)
+{
+    for (unsigned int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+        m_buckets[bucket].store(other.m_buckets[bucket].load(RELAXED), RELAXED);
+
+    m_count.store(other.m_count.load(RELAXED), RELAXED);
+    m_totalNs.store(other.m_totalNs.load(RELAXED), RELAXED);
+    m_minNs.store(other.m_minNs.load(RELAXED), RELAXED);
+    m_maxNs.store(other.m_maxNs.load(RELAXED), RELAXED);
+
+    return *this;
+}
+
+void Cedrus::LatencyHistogram::Record(std::chrono::nanoseconds latency)
+{
+    const unsigned long long ns = latency.count() > 0 ? static_cast<unsigned long long>(latency.count()) : 0;
+
+    Add(m_buckets[BucketIndex(ns)], 1);
+    Add(m_count, 1);
+    Add(m_totalNs, ns);
+
+    if (ns < m_minNs.load(RELAXED))
+        m_minNs.store(ns, RELAXED);
+    if (ns > m_maxNs.load(RELAXED))
+        m_maxNs.store(ns, RELAXED);
+}
+
+void Cedrus::LatencyHistogram::Reset()
+{
+    for (unsigned int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+        m_buckets[bucket].store(0, RELAXED);
+
+    m_count.store(0, RELAXED);
+    m_totalNs.store(0, RELAXED);
+    m_minNs.store(std::numeric_limits<unsigned long long>::max(), RELAXED);
+    m_maxNs.store(0, RELAXED);
+}
+
+unsigned long long Cedrus::LatencyHistogram::GetCount() const
+{
+    return m_count.load(RELAXED);
+}
+
+std::chrono::nanoseconds Cedrus::LatencyHistogram::GetMin() const
+{
+    return std::chrono::nanoseconds(GetCount() > 0 ? m_minNs.load(RELAXED) : 0);
+}
+
+std::chrono::nanoseconds Cedrus::LatencyHistogram::GetMax() const
+{
+    return std::chrono::nanoseconds(m_maxNs.load(RELAXED));
+}
+
+std::chrono::nanoseconds Cedrus::LatencyHistogram::GetMean() const
+{
+    const unsigned long long count = GetCount();
+
+    return std::chrono::nanoseconds(count > 0 ? m_totalNs.load(RELAXED) / count : 0);
+}
+
+std::chrono::nanoseconds Cedrus::LatencyHistogram::GetPercentile(double percent) const
+{
+    unsigned long long total = 0;
+    for (unsigned int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+        total += m_buckets[bucket].load(RELAXED);
+
+    if (total == 0)
+        return std::chrono::nanoseconds(0);
+
+    const double wanted = std::ceil(total * (percent < 0 ? 0 : percent > 100 ? 100 : percent) / 100.0);
+    const unsigned long long rank = wanted < 1 ? 1 : static_cast<unsigned long long>(wanted);
+
+    unsigned long long seen = 0;
+    for (unsigned int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    {
+        seen += m_buckets[bucket].load(RELAXED);
+        if (seen >= rank)
+            return std::min(std::chrono::nanoseconds(BucketHigh(bucket)), GetMax());
+    }
+
+    return GetMax();
+}
+
+void Cedrus::LatencyHistogram::WriteCsv(std::ostream & out, const std::string & label) const
+{
+    for (unsigned int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+    {
+        const unsigned long long count = m_buckets[bucket].load(RELAXED);
+        if (count > 0)
+            out << label << ',' << BucketLow(bucket) << ',' << BucketHigh(bucket) << ',' << count << '\n';
+    }
+}
+
+unsigned long long Cedrus::LatencyHistogram::BucketLow(unsigned int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket;
+
+    return static_cast<unsigned long long>(SUB_BUCKETS + bucket % SUB_BUCKETS) << (bucket / SUB_BUCKETS - 1);
+}
+
+unsigned long long Cedrus::LatencyHistogram::BucketHigh(unsigned int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket + 1;
+
+    return BucketLow(bucket) + (1ull << (bucket / SUB_BUCKETS - 1));
+}
+
+// Below SUB_BUCKETS, one bucket per nanosecond. Above, the top bit picks the
+// doubling and the three bits under it the bucket within it.
+unsigned int Cedrus::LatencyHistogram::BucketIndex(unsigned long long ns)
+{
+    if (ns < SUB_BUCKETS)
+        return static_cast<unsigned int>(ns);
+
+    const unsigned int top_bit = HighestSetBit(ns);
+    const unsigned int bucket = (top_bit - 2) * SUB_BUCKETS + static_cast<unsigned int>((ns >> (top_bit - 3)) & (SUB_BUCKETS - 1));
+
+    return bucket < NUM_BUCKETS ? bucket : NUM_BUCKETS - 1;
+}
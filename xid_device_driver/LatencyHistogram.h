@@ -0,0 +1,91 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <atomic>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace Cedrus
+{
+    // Counts durations in buckets eight to a doubling, so that a bucket is
+    // never wider than an eighth of what it holds, from 1 ns up to 2^40 ns
+    // (about 18 minutes); anything longer lands in the last bucket. Meant to
+    // be recorded into by one thread at a time and read from any.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT LatencyHistogram
+    {
+    public:
+        enum { SUB_BUCKETS = 8 };
+        enum { NUM_BUCKETS = SUB_BUCKETS * 38 };
+
+        LatencyHistogram();
+
+        // Copies are snapshots. Taken while something is being recorded,
+        // the counts may be a record or two apart.
+        LatencyHistogram(const LatencyHistogram & other);
+        LatencyHistogram& operator=(const LatencyHistogram & other);
+
+        // Negative durations count as 0.
+        void Record(std::chrono::nanoseconds latency);
+
+        void Reset();
+
+        unsigned long long GetCount() const;
+        std::chrono::nanoseconds GetMin() const;
+        std::chrono::nanoseconds GetMax() const;
+        std::chrono::nanoseconds GetMean() const;
+
+        // The upper edge of the bucket the given percentile falls in, but no
+        // more than GetMax(). 0 when nothing has been recorded.
+        std::chrono::nanoseconds GetPercentile(double percent) const;
+
+        // One "label,low_ns,high_ns,count" line per bucket that isn't empty,
+        // lowest first. A bucket holds durations from low_ns up to but not
+        // including high_ns.
+        void WriteCsv(std::ostream & out, const std::string & label) const;
+
+        static unsigned long long BucketLow(unsigned int bucket);
+        static unsigned long long BucketHigh(unsigned int bucket);
+
+    private:
+        static unsigned int BucketIndex(unsigned long long ns);
+
+        std::atomic<unsigned long long> m_buckets[NUM_BUCKETS];
+        std::atomic<unsigned long long> m_count;
+        std::atomic<unsigned long long> m_totalNs;
+        std::atomic<unsigned long long> m_minNs;
+        std::atomic<unsigned long long> m_maxNs;
+    };
+} // namespace Cedrus
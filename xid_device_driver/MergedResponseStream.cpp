@@ -0,0 +1,149 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "MergedResponseStream.h"
+
+#include "XIDDevice.h"
+
+#include <algorithm>
+
+Cedrus::MergedResponseStream::MergedResponseStream()
+    : m_reorderWindow(0)
+{
+}
+
+Cedrus::MergedResponseStream::~MergedResponseStream()
+{
+}
+
+int Cedrus::MergedResponseStream::AddSource(PollFunction poll, DrainFunction drain)
+{
+    Source source;
+    source.poll = poll;
+    source.drain = drain;
+    source.staged.reset(new Response[STAGING_CAPACITY]);
+    source.start = 0;
+    source.count = 0;
+
+    m_sources.push_back(std::move(source));
+
+    return static_cast<int>(m_sources.size() - 1);
+}
+
+int Cedrus::MergedResponseStream::AddDevice(std::shared_ptr<XIDDevice> device)
+{
+    return AddSource(
+        [device]() { device->PollForResponse(); },
+        [device](Response * out, size_t maxResponses) { return device->GetResponses(out, maxResponses); });
+}
+
+size_t Cedrus::MergedResponseStream::GetNumberOfSources() const
+{
+    return m_sources.size();
+}
+
+void Cedrus::MergedResponseStream::SetReorderWindow(std::chrono::microseconds window)
+{
+    m_reorderWindow = window;
+}
+
+std::chrono::microseconds Cedrus::MergedResponseStream::GetReorderWindow() const
+{
+    return m_reorderWindow;
+}
+
+std::chrono::steady_clock::time_point Cedrus::MergedResponseStream::Fill(Source & source)
+{
+    if (source.start > 0)
+    {
+        std::copy(source.staged.get() + source.start, source.staged.get() + source.start + source.count, source.staged.get());
+        source.start = 0;
+    }
+
+    // Anything read from here on is stamped later than this.
+    const std::chrono::steady_clock::time_point poll_time = std::chrono::steady_clock::now();
+
+    source.poll();
+    source.count += static_cast<unsigned int>(source.drain(source.staged.get() + source.count, STAGING_CAPACITY - source.count));
+
+    // With no room for all of it, what's left behind is only known to be no
+    // earlier than the last response taken.
+    if (source.count == STAGING_CAPACITY)
+        return source.staged[source.count - 1].hostTime;
+
+    return poll_time - m_reorderWindow;
+}
+
+size_t Cedrus::MergedResponseStream::Poll(MergedResponse * out, size_t maxResponses)
+{
+    if (m_sources.empty())
+        return 0;
+
+    std::chrono::steady_clock::time_point complete_through = std::chrono::steady_clock::time_point::max();
+    for (std::vector<Source>::iterator source = m_sources.begin(); source != m_sources.end(); ++source)
+        complete_through = std::min(complete_through, Fill(*source));
+
+    // A k-way merge. There are only ever a handful of devices, so the
+    // earliest head is found by looking at each of them.
+    size_t delivered = 0;
+    while (delivered < maxResponses)
+    {
+        Source * earliest = nullptr;
+        for (std::vector<Source>::iterator source = m_sources.begin(); source != m_sources.end(); ++source)
+        {
+            if (source->count > 0 &&
+                (!earliest || source->staged[source->start].hostTime < earliest->staged[earliest->start].hostTime))
+            {
+                earliest = &*source;
+            }
+        }
+
+        if (!earliest || earliest->staged[earliest->start].hostTime > complete_through)
+            break;
+
+        out[delivered].response = earliest->staged[earliest->start];
+        out[delivered].source = static_cast<int>(earliest - &m_sources[0]);
+        ++earliest->start;
+        --earliest->count;
+        ++delivered;
+    }
+
+    return delivered;
+}
+
+size_t Cedrus::MergedResponseStream::GetPendingCount() const
+{
+    size_t pending = 0;
+    for (std::vector<Source>::const_iterator source = m_sources.begin(); source != m_sources.end(); ++source)
+        pending += source->count;
+
+    return pending;
+}
@@ -0,0 +1,118 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "ResponseManager.h"
+#include "XidDriverImpExpDefs.h"
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Cedrus
+{
+    class XIDDevice;
+
+    // A response and the source it came from, as numbered by
+    // MergedResponseStream::AddSource().
+    struct MergedResponse
+    {
+        Response response;
+        int source;
+    };
+
+    // Merges the responses of several devices into one stream, in order of
+    // hostTime. Each Poll() reads every source, then hands over whatever no
+    // source could still come up with something earlier than, so a response
+    // is delivered by the first Poll() after the one that read it. Nothing
+    // is allocated per response.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT MergedResponseStream
+    {
+    public:
+        // Make noncopyable
+        MergedResponseStream(const MergedResponseStream&) = delete;
+        MergedResponseStream& operator=(const MergedResponseStream&) = delete;
+
+        typedef std::function<void ()> PollFunction;
+        typedef std::function<size_t (Response * out, size_t maxResponses)> DrainFunction;
+
+        MergedResponseStream();
+        ~MergedResponseStream();
+
+        // poll reads the source's device and drain takes what it read, oldest
+        // first. Returns the source's number, counting up from 0.
+        int AddSource(PollFunction poll, DrainFunction drain);
+
+        // Takes the device's responses through GetResponses(), so don't give
+        // it response callbacks as well.
+        int AddDevice(std::shared_ptr<XIDDevice> device);
+
+        size_t GetNumberOfSources() const;
+
+        // Responses are held back this much longer, for sources read on
+        // threads of their own (StartAcquisition()) that may still be queuing
+        // a response when the stream takes from them. 0 by default.
+        void SetReorderWindow(std::chrono::microseconds window);
+        std::chrono::microseconds GetReorderWindow() const;
+
+        // Reads every source and moves up to maxResponses merged responses
+        // into out, oldest first. Returns how many. From an event loop, call
+        // this when any device's GetResponseReadyFd() is readable, and again
+        // after the reorder window while GetPendingCount() isn't 0.
+        size_t Poll(MergedResponse * out, size_t maxResponses);
+
+        // Read from the sources but not yet handed over.
+        size_t GetPendingCount() const;
+
+    private:
+        enum { STAGING_CAPACITY = 256 };
+
+        struct Source
+        {
+            PollFunction poll;
+            DrainFunction drain;
+
+            // Read but not handed over yet, count of them from start.
+            std::unique_ptr<Response[]> staged;
+            unsigned int start;
+            unsigned int count;
+        };
+
+        // Reads one source into its staging, and returns the time up to which
+        // it has nothing more to come.
+        std::chrono::steady_clock::time_point Fill(Source & source);
+
+        std::vector<Source> m_sources;
+        std::chrono::microseconds m_reorderWindow;
+    };
+} // namespace Cedrus
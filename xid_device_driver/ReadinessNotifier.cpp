@@ -0,0 +1,120 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ReadinessNotifier.h"
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+Cedrus::ReadinessNotifier::ReadinessNotifier()
+    : m_readFd(-1),
+      m_writeFd(-1),
+      m_signaled(false)
+{
+#if defined(__linux__)
+    m_readFd = m_writeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#elif !defined(_WIN32)
+    int fds[2];
+    if (pipe(fds) == 0)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+        }
+
+        m_readFd = fds[0];
+        m_writeFd = fds[1];
+    }
+#endif
+}
+
+Cedrus::ReadinessNotifier::~ReadinessNotifier()
+{
+#if !defined(_WIN32)
+    if (m_writeFd != m_readFd && m_writeFd >= 0)
+        close(m_writeFd);
+    if (m_readFd >= 0)
+        close(m_readFd);
+#endif
+}
+
+int Cedrus::ReadinessNotifier::GetFd() const
+{
+    return m_readFd;
+}
+
+void Cedrus::ReadinessNotifier::Signal()
+{
+    if (m_signaled.exchange(true))
+        return;
+
+#if defined(__linux__)
+    const uint64_t one = 1;
+    if (m_writeFd >= 0)
+        (void) write(m_writeFd, &one, sizeof(one));
+#elif !defined(_WIN32)
+    const unsigned char one = 1;
+    if (m_writeFd >= 0)
+        (void) write(m_writeFd, &one, sizeof(one));
+#endif
+}
+
+void Cedrus::ReadinessNotifier::Reset()
+{
+    // Drained before the flag comes down. The other way round, a Signal() in
+    // between would have its write drained and leave the flag up, and the
+    // descriptor would never become readable again. This way the worst is a
+    // Signal() skipped, which the caller's second look catches.
+#if defined(__linux__)
+    uint64_t count;
+    if (m_readFd >= 0)
+        (void) read(m_readFd, &count, sizeof(count));
+#elif !defined(_WIN32)
+    unsigned char drain[16];
+    while (m_readFd >= 0 && read(m_readFd, drain, sizeof(drain)) > 0)
+        ;
+#endif
+
+    m_signaled = false;
+}
+
+bool Cedrus::ReadinessNotifier::IsSignaled() const
+{
+    return m_signaled;
+}
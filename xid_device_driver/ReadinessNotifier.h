@@ -0,0 +1,74 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <atomic>
+
+namespace Cedrus
+{
+    // A file descriptor that is readable while a flag is set, for event
+    // loops that can't call into the library to find out. An eventfd on
+    // Linux and a pipe on other POSIX systems. There is no descriptor on
+    // Windows, where GetFd() returns -1.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT ReadinessNotifier
+    {
+    public:
+        // Make noncopyable
+        ReadinessNotifier(const ReadinessNotifier&) = delete;
+        ReadinessNotifier& operator=(const ReadinessNotifier&) = delete;
+
+        ReadinessNotifier();
+        ~ReadinessNotifier();
+
+        // For epoll, poll, select and the like; only ever read by Reset().
+        // -1 if there isn't one.
+        int GetFd() const;
+
+        // Makes the descriptor readable. Costs a system call only when it
+        // wasn't already.
+        void Signal();
+
+        // Makes it unreadable again. A caller clearing the flag because it
+        // ran out of work should look for work once more afterwards, and
+        // Signal() if there is some, since it may have raced with Signal().
+        void Reset();
+
+        bool IsSignaled() const;
+
+    private:
+        int m_readFd;
+        int m_writeFd;
+        std::atomic<bool> m_signaled;
+    };
+} // namespace Cedrus
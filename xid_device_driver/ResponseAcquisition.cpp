@@ -0,0 +1,202 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ResponseAcquisition.h"
+
+#include <algorithm>
+
+Cedrus::ResponseAcquisition::ResponseAcquisition()
+    : m_stopRequested(false),
+      m_paused(false),
+      m_overrunCount(0),
+      m_maxLatency(0),
+      m_nextSubscriberID(1)
+{
+}
+
+Cedrus::ResponseAcquisition::~ResponseAcquisition()
+{
+    Stop();
+}
+
+bool Cedrus::ResponseAcquisition::Start(std::function<void ()> poll, std::shared_ptr<ResponseManager> responses, std::chrono::microseconds maxLatency)
+{
+    if (IsRunning() || !poll || !responses)
+        return false;
+
+    m_poll = poll;
+    m_maxLatency = std::max(maxLatency, std::chrono::microseconds(100));
+
+    {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+
+        m_responses = responses;
+        m_stopRequested = false;
+        UpdateBlockingOverflow();
+    }
+
+    m_thread = std::thread(&Cedrus::ResponseAcquisition::Run, this);
+
+    return true;
+}
+
+void Cedrus::ResponseAcquisition::Stop()
+{
+    if (!IsRunning())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+
+        // Also gets the thread out of a poll that is waiting on a full queue.
+        m_stopRequested = true;
+        UpdateBlockingOverflow();
+    }
+
+    m_thread.join();
+
+    m_poll = std::function<void ()>();
+
+    std::lock_guard<std::mutex> lock(m_subscriberMutex);
+    m_responses.reset();
+}
+
+bool Cedrus::ResponseAcquisition::IsRunning() const
+{
+    return m_thread.joinable();
+}
+
+void Cedrus::ResponseAcquisition::Pause(bool pause)
+{
+    m_paused = pause;
+}
+
+bool Cedrus::ResponseAcquisition::IsPaused() const
+{
+    return m_paused;
+}
+
+std::chrono::microseconds Cedrus::ResponseAcquisition::GetMaxLatency() const
+{
+    return m_maxLatency;
+}
+
+int Cedrus::ResponseAcquisition::AddSubscriber(ResponseCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_subscriberMutex);
+
+    m_subscribers.push_back(std::make_pair(m_nextSubscriberID, callback));
+    UpdateBlockingOverflow();
+
+    return m_nextSubscriberID++;
+}
+
+bool Cedrus::ResponseAcquisition::RemoveSubscriber(int subscriberID)
+{
+    std::lock_guard<std::mutex> lock(m_subscriberMutex);
+
+    for (auto it = m_subscribers.begin(); it != m_subscribers.end(); ++it)
+    {
+        if (it->first == subscriberID)
+        {
+            m_subscribers.erase(it);
+            UpdateBlockingOverflow();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+unsigned long long Cedrus::ResponseAcquisition::GetOverrunCount() const
+{
+    return m_overrunCount;
+}
+
+void Cedrus::ResponseAcquisition::UpdateBlockingOverflow()
+{
+    if (m_responses)
+        m_responses->AllowBlockingOverflow(m_subscribers.empty() && !m_stopRequested);
+}
+
+void Cedrus::ResponseAcquisition::Run()
+{
+    // Polling at half the bound leaves the other half for oversleeping and
+    // for the poll itself.
+    const std::chrono::microseconds poll_interval = m_maxLatency / 2;
+    std::chrono::steady_clock::time_point last_poll = std::chrono::steady_clock::now();
+
+    while (!m_stopRequested)
+    {
+        const std::chrono::steady_clock::time_point poll_start = std::chrono::steady_clock::now();
+
+        if (!m_paused)
+        {
+            if (poll_start - last_poll > m_maxLatency)
+                ++m_overrunCount;
+
+            m_poll();
+            DeliverQueuedResponses();
+        }
+
+        last_poll = poll_start;
+
+        std::this_thread::sleep_until(poll_start + poll_interval);
+    }
+}
+
+void Cedrus::ResponseAcquisition::DeliverQueuedResponses()
+{
+    if (!m_responses->HasQueuedResponses())
+        return;
+
+    // Called without the lock held, so that callbacks can change the list.
+    std::vector< std::pair<int, ResponseCallback> > subscribers;
+    {
+        std::lock_guard<std::mutex> lock(m_subscriberMutex);
+        subscribers = m_subscribers;
+    }
+
+    if (subscribers.empty())
+        return;
+
+    Response batch[DELIVERY_BATCH_SIZE];
+    size_t count;
+
+    while ((count = m_responses->GetResponses(batch, DELIVERY_BATCH_SIZE)) > 0)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (const auto & subscriber : subscribers)
+                subscriber.second(batch[i]);
+        }
+    }
+}
@@ -0,0 +1,119 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "ResponseManager.h"
+#include "XidDriverImpExpDefs.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace Cedrus
+{
+    typedef std::function<void (const Response &)> ResponseCallback;
+
+    // Polls a device from a thread of its own so that callers don't have to
+    // loop on PollForResponse(). Responses go to the subscribed callbacks, on
+    // the acquisition thread, or stay queued in the ResponseManager for the
+    // caller to take if nothing is subscribed.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT ResponseAcquisition
+    {
+    public:
+        // Make noncopyable
+        ResponseAcquisition(const ResponseAcquisition&) = delete;
+        ResponseAcquisition& operator=(const ResponseAcquisition&) = delete;
+
+        ResponseAcquisition();
+
+        // Stops the thread.
+        ~ResponseAcquisition();
+
+        // poll reads the device into responses. It's called often enough that
+        // no response waits longer than maxLatency between reaching the host
+        // and being delivered. Returns false if already running.
+        bool Start(std::function<void ()> poll, std::shared_ptr<ResponseManager> responses, std::chrono::microseconds maxLatency);
+
+        // Returns once the thread has exited. Responses already queued stay
+        // queued.
+        void Stop();
+
+        // The queue may only block the thread on overflow (OVERFLOW_BLOCK)
+        // while the thread is running with no subscribers, since subscribers
+        // are fed from the same thread that fills the queue. This is kept up
+        // to date through ResponseManager::AllowBlockingOverflow().
+
+        bool IsRunning() const;
+
+        // While paused the device isn't read at all. This persists across
+        // Stop() and Start().
+        void Pause(bool pause);
+        bool IsPaused() const;
+
+        std::chrono::microseconds GetMaxLatency() const;
+
+        // Returns an id for RemoveSubscriber(). Callbacks may add or remove
+        // subscribers, but must not block.
+        int AddSubscriber(ResponseCallback callback);
+        bool RemoveSubscriber(int subscriberID);
+
+        // Times the gap between two polls came out longer than maxLatency.
+        unsigned long long GetOverrunCount() const;
+
+    private:
+        enum { DELIVERY_BATCH_SIZE = 64 };
+
+        void Run();
+        void DeliverQueuedResponses();
+        // Called with m_subscriberMutex held.
+        void UpdateBlockingOverflow();
+
+        std::thread m_thread;
+        std::atomic<bool> m_stopRequested;
+        std::atomic<bool> m_paused;
+        std::atomic<unsigned long long> m_overrunCount;
+
+        std::function<void ()> m_poll;
+        // Set and cleared under m_subscriberMutex as well.
+        std::shared_ptr<ResponseManager> m_responses;
+        std::chrono::microseconds m_maxLatency;
+
+        std::mutex m_subscriberMutex;
+        std::vector< std::pair<int, ResponseCallback> > m_subscribers;
+        int m_nextSubscriberID;
+    };
+} // namespace Cedrus
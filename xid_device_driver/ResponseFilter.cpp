@@ -0,0 +1,112 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ResponseFilter.h"
+
+Cedrus::ResponseFilter::ResponseFilter()
+    : m_portMask(~0u),
+      m_keyMask(~0ull),
+      m_pressReleaseMask(PASS_PRESSES_AND_RELEASES),
+      m_debounceMs(0)
+{
+    ResetDebounce();
+}
+
+void Cedrus::ResponseFilter::SetPortMask(unsigned int mask)
+{
+    m_portMask = mask;
+}
+
+unsigned int Cedrus::ResponseFilter::GetPortMask() const
+{
+    return m_portMask;
+}
+
+void Cedrus::ResponseFilter::SetKeyMask(unsigned long long mask)
+{
+    m_keyMask = mask;
+}
+
+unsigned long long Cedrus::ResponseFilter::GetKeyMask() const
+{
+    return m_keyMask;
+}
+
+void Cedrus::ResponseFilter::SetPressReleaseMask(unsigned int mask)
+{
+    m_pressReleaseMask = mask & PASS_PRESSES_AND_RELEASES;
+}
+
+unsigned int Cedrus::ResponseFilter::GetPressReleaseMask() const
+{
+    return m_pressReleaseMask;
+}
+
+void Cedrus::ResponseFilter::SetDebounceInterval(std::chrono::milliseconds interval)
+{
+    m_debounceMs = interval.count() > 0 ? interval.count() : 0;
+}
+
+std::chrono::milliseconds Cedrus::ResponseFilter::GetDebounceInterval() const
+{
+    return std::chrono::milliseconds(m_debounceMs);
+}
+
+bool Cedrus::ResponseFilter::PassesEverything() const
+{
+    return m_portMask == ~0u && m_keyMask == ~0ull &&
+        m_pressReleaseMask == PASS_PRESSES_AND_RELEASES && m_debounceMs == 0;
+}
+
+void Cedrus::ResponseFilter::ResetDebounce()
+{
+    for (int port = 0; port < DEBOUNCE_PORTS; ++port)
+    {
+        for (int key = 0; key < DEBOUNCE_KEYS; ++key)
+            m_lastChangeMs[port][key] = -1;
+    }
+}
+
+bool Cedrus::ResponseFilter::Debounce(int port, int key, long long deviceTimeMs)
+{
+    if (static_cast<unsigned int>(port) >= DEBOUNCE_PORTS || static_cast<unsigned int>(key) >= DEBOUNCE_KEYS)
+        return true;
+
+    long long & last_change = m_lastChangeMs[port][key];
+
+    // Time going backwards means the timer was reset under us.
+    if (last_change >= 0 && deviceTimeMs >= last_change && deviceTimeMs - last_change < m_debounceMs)
+        return false;
+
+    last_change = deviceTimeMs;
+
+    return true;
+}
@@ -0,0 +1,104 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+#include <chrono>
+
+namespace Cedrus
+{
+    // Which responses ResponseManager queues. Everything passes by default.
+    // Runs in the parser, so a response filtered out costs a few compares
+    // and never reaches the queue.
+    class CEDRUS_XIDDRIVER_IMPORTEXPORT ResponseFilter
+    {
+    public:
+        enum { PASS_PRESSES = 0x1, PASS_RELEASES = 0x2, PASS_PRESSES_AND_RELEASES = 0x3 };
+
+        ResponseFilter();
+
+        // Bit n passes port n. Ports past 31 always pass.
+        void SetPortMask(unsigned int mask);
+        unsigned int GetPortMask() const;
+
+        // Bit n passes key n, after mapping. Keys past 63 always pass.
+        void SetKeyMask(unsigned long long mask);
+        unsigned long long GetKeyMask() const;
+
+        // PASS_PRESSES, PASS_RELEASES or both.
+        void SetPressReleaseMask(unsigned int mask);
+        unsigned int GetPressReleaseMask() const;
+
+        // Software debounce: a key's presses and releases are dropped until
+        // this long after the last one that got through, in device time.
+        // 0 turns it off. Only for ports below DEBOUNCE_PORTS and keys below
+        // DEBOUNCE_KEYS.
+        void SetDebounceInterval(std::chrono::milliseconds interval);
+        std::chrono::milliseconds GetDebounceInterval() const;
+
+        bool PassesEverything() const;
+
+        // Forgets when keys last changed, say because the timer was reset.
+        void ResetDebounce();
+
+        // Whether a response should be queued. Debounce comes first and sees
+        // every response, so that masking out releases doesn't make the
+        // chatter on the next press look new.
+        bool Accept(int port, int key, bool wasPressed, long long deviceTimeMs)
+        {
+            if (m_debounceMs > 0 && !Debounce(port, key, deviceTimeMs))
+                return false;
+
+            if (static_cast<unsigned int>(port) < 32 && (m_portMask & (1u << port)) == 0)
+                return false;
+
+            if (static_cast<unsigned int>(key) < 64 && (m_keyMask & (1ull << key)) == 0)
+                return false;
+
+            return (m_pressReleaseMask & (wasPressed ? PASS_PRESSES : PASS_RELEASES)) != 0;
+        }
+
+        enum { DEBOUNCE_PORTS = 16, DEBOUNCE_KEYS = 64 };
+
+    private:
+        bool Debounce(int port, int key, long long deviceTimeMs);
+
+        unsigned int m_portMask;
+        unsigned long long m_keyMask;
+        unsigned int m_pressReleaseMask;
+        long long m_debounceMs;
+
+        // Device time of the last response through on each key, -1 for none.
+        long long m_lastChangeMs[DEBOUNCE_PORTS][DEBOUNCE_KEYS];
+    };
+} // namespace Cedrus
@@ -4,213 +4,437 @@
 
 #include "Connection.h"
 #include "DeviceConfig.h"
+#include "ResyncScanner.h"
 #include "constants.h"
 
-Cedrus::ResponseManager::ResponseManager(std::shared_ptr<const DeviceConfig> devConfig )
-    : m_BytesInBuffer(0),
-      m_XIDPacketIndex(INVALID_PACKET_INDEX),
-      m_numKeysDown(0),
-      m_packetSize(XID_PACKET_SIZE),
-      m_ResponseParsingFunction(  ),
-      m_respDevConfig(devConfig)
+#include <algorithm>
+#include <condition_variable>
+
+namespace
 {
-    m_packetSize = devConfig->IsStimTracker2() ? ST2_PACKET_SIZE : XID_PACKET_SIZE;
-    for (int i = 0; i < m_packetSize; ++i)
+    // Shared by every ResponseManager, so that one wait can cover several
+    // devices.
+    struct ArrivalSignal
     {
-        m_InputBuffer[i] = '\0';
-    }
+        ArrivalSignal() : arrivals(0), waiters(0) {}
 
-    if (devConfig && devConfig->IsStimTracker2())
+        std::mutex mutex;
+        std::condition_variable arrived;
+        std::atomic<unsigned long long> arrivals;
+        std::atomic<int> waiters;
+    };
+
+    ArrivalSignal & Arrivals()
     {
-        m_ResponseParsingFunction = std::bind(&Cedrus::ResponseManager::ST2InputFound, this, std::placeholders::_1);
+        static ArrivalSignal signal;
+        return signal;
     }
-    else
+
+    void SignalArrival()
     {
-        m_ResponseParsingFunction = std::bind(&Cedrus::ResponseManager::XidInputFound, this, std::placeholders::_1);
-    }
-}
+        ArrivalSignal & signal = Arrivals();
+        signal.arrivals.fetch_add(1);
 
-Cedrus::ResponseManager::~ResponseManager()
-{
+        // Only a waiter that saw the old count can be asleep; one that comes
+        // after sees the new count and doesn't sleep.
+        if (signal.waiters.load() > 0)
+        {
+            { std::lock_guard<std::mutex> lock(signal.mutex); }
+            signal.arrived.notify_all();
+        }
+    }
 }
 
-bool Cedrus::ResponseManager::XidInputFound(Response &res)
+// The packet formats, as policies for ParseInput(). XID 1 and XID 2 response
+// pads, Luminas, SV-1s and c-pods with inputs all send the same 'k' packet.
+struct Cedrus::ResponseManager::XidPacketDecoder
 {
-    bool input_found = false;
-    m_XIDPacketIndex = INVALID_PACKET_INDEX;
+    enum { PACKET_SIZE = 6 };
+    enum { SYNC_BYTE = 'k' };
+    enum { PORT_AND_KEY = 1, TIME = 2 };
+    enum { PORT_BITS = 0x0F, KEY_BITS = 0xE0, KEY_SHIFT = 5 };
 
-    if (m_InputBuffer[0] == 'k' && ((m_InputBuffer[1] & INVALID_PORT_BITS) == 0))
+    static ParseResult Decode(ResponseManager & mgr, Response & res)
     {
-        m_XIDPacketIndex = 0;
+        if (mgr.m_inputCount == 0)
+            return NEED_MORE_BYTES;
 
-        // If this is false, all is not yet lost. Looks like we have a partial XID
-        // packet for whatever reason. We don't need to adjust the buffer in any way,
-        // we'll just read in fewer bytes on the next pass in an attempt to finish it.
-        if (m_BytesInBuffer == XID_PACKET_SIZE)
+        if (mgr.PeekInput(0) == SYNC_BYTE && (mgr.m_inputCount < 2 || (mgr.PeekInput(PORT_AND_KEY) & INVALID_PORT_BITS) == 0))
         {
-            res.wasPressed = (m_InputBuffer[1] & KEY_RELEASE_BITMASK) == KEY_RELEASE_BITMASK;
-            res.port = m_InputBuffer[1] & 0x0F;
-            res.key = (m_InputBuffer[1] & 0xE0) >> 5;
+            // A partial packet, the rest of it should be along shortly.
+            if (mgr.m_inputCount < PACKET_SIZE)
+                return NEED_MORE_BYTES;
+
+            // The last byte is the top byte of the timer, so it stays 0 for the
+            // first 4.66 hours. Until the timer could be that far along, a
+            // nonzero one means we've latched on to a 'k' that isn't a packet.
+            if (mgr.PeekInput(PACKET_SIZE - 1) != 0 && !mgr.m_acceptHighTimeByte)
+                return Resync(mgr);
+
+            const unsigned char port_and_key = mgr.PeekInput(PORT_AND_KEY);
+            res.wasPressed = (port_and_key & KEY_RELEASE_BITMASK) == KEY_RELEASE_BITMASK;
+            res.port = port_and_key & PORT_BITS;
+            res.key = (port_and_key & KEY_BITS) >> KEY_SHIFT;
 
-            res.reactionTime = AdjustEndiannessCharsToUint
-            (m_InputBuffer[2], m_InputBuffer[3], m_InputBuffer[4], m_InputBuffer[5]);
+            res.extendedReactionTime = AdjustEndiannessCharsToUint
+            (mgr.PeekInput(TIME), mgr.PeekInput(TIME + 1), mgr.PeekInput(TIME + 2), mgr.PeekInput(TIME + 3));
 
-            input_found = true;
+            mgr.DropInput(PACKET_SIZE);
+
+            return PACKET_FOUND;
         }
+
+        // We never want to be here. This means that we either have random junk
+        // in the buffer, or that we just ate some other valid output from the
+        // device that was not meant for us. That can have mystifying consequences
+        // elsewhere, so take note.
+        CEDRUS_ASSERT(false, "ResponseManager just read something inappropriate from the device buffer!");
+
+        return Resync(mgr);
+    }
+
+    // Nothing before the next place a packet could start can be salvaged.
+    static ParseResult Resync(ResponseManager & mgr)
+    {
+        mgr.DropInput(FindXidResyncOffset(mgr.ContiguousInput(), mgr.m_inputCount, !mgr.m_acceptHighTimeByte));
+
+        return BYTES_DROPPED;
     }
+};
+
+struct Cedrus::ResponseManager::ST2PacketDecoder
+{
+    enum { PACKET_SIZE = 9 };
+    enum { SYNC_BYTE = 'o' };
+    enum { PORT = 1, KEY = 2, STATE = 3, TIME = 4, TERMINATOR = 8 };
 
-    if (m_XIDPacketIndex == INVALID_PACKET_INDEX)
+    static ParseResult Decode(ResponseManager & mgr, Response & res)
     {
-        // Something is amiss, but perhaps the packet is later in the buffer?
-        for (int i = 1; i < XID_PACKET_SIZE; ++i)
+        if (mgr.m_inputCount == 0)
+            return NEED_MORE_BYTES;
+
+        if (mgr.PeekInput(0) == SYNC_BYTE)
         {
-            if (m_InputBuffer[i] == 'k')
+            if (mgr.m_inputCount < PACKET_SIZE)
+                return NEED_MORE_BYTES;
+
+            if (mgr.PeekInput(TERMINATOR) == 0)
             {
-                // We have found a k later in the buffer. Setting the index will
-                // allow AdjustBufferForPacketRecovery() to adjust the buffer
-                // accordingly in preparation for recovery.
-                m_XIDPacketIndex = i;
-                break;
+                res.port = mgr.PeekInput(PORT);
+                res.key = mgr.PeekInput(KEY);
+                res.wasPressed = mgr.PeekInput(STATE) == '1';
+
+                res.extendedReactionTime = AdjustEndiannessCharsToUint
+                (mgr.PeekInput(TIME), mgr.PeekInput(TIME + 1), mgr.PeekInput(TIME + 2), mgr.PeekInput(TIME + 3));
+
+                mgr.DropInput(PACKET_SIZE);
+
+                return PACKET_FOUND;
             }
         }
 
-        // We never want to be here. This means that we either have random junk
-        // in the buffer, or that we just ate some other valid output from the
-        // device that was not meant for us. That can have mystifying consequences
-        // elsewhere, so take note.
-        CEDRUS_ASSERT(m_XIDPacketIndex == INVALID_PACKET_INDEX, "ResponseManager just read something inappropriate from the device buffer!");
+        mgr.DropInput(FindST2ResyncOffset(mgr.ContiguousInput(), mgr.m_inputCount));
+
+        return BYTES_DROPPED;
     }
+};
 
-    // If m_XIDPacketIndex == INVALID_PACKET_INDEX, recovery is impossible, as
-    // we have no point of reference to attempt to reconstruct a response packet.
-    // If m_XIDPacketIndex is 0, there is no need to adjust the buffer for recovery.
-    // Otherwise, we need to flush some unwanted bytes from the buffer.
-    if (m_XIDPacketIndex != INVALID_PACKET_INDEX && m_XIDPacketIndex != 0)
-        AdjustBufferForPacketRecovery();
+Cedrus::ResponseManager::ResponseManager(std::shared_ptr<const DeviceConfig> devConfig )
+    : m_inputStart(0),
+      m_inputCount(0),
+      m_filtering(false),
+      m_acceptHighTimeByte(true),
+      m_queuedThisPass(false),
+      m_overflowWaitExpired(false),
+      m_trackLatencyThisPass(false),
+      m_numKeysDown(0),
+      m_impossibleTransitions(0),
+      m_filteredCount(0),
+      m_trackLatency(false),
+      m_responseQueue(RESPONSE_QUEUE_CAPACITY),
+      m_overflowPolicy(OVERFLOW_DROP_NEWEST),
+      m_blockingOverflowAllowed(false),
+      m_readiness(nullptr),
+      m_parseInput(nullptr),
+      m_respDevConfig(devConfig)
+{
+    memset(m_inputRing, 0x00, sizeof(m_inputRing));
 
-    if (m_BytesInBuffer == XID_PACKET_SIZE)
-    {
-        /*
-        This is the end of our journey. We have either successfully cobbled together an XID packet
-        or we have failed utterly. Enjoy the complimentary assert if that was the case, and keep in
-        mind that we cannot process responses from XID devices that have been on for 4.66 hours.
-        If you're fairly certain 4.66 hours haven't passed and/or if you're getting SOME responses,
-        there's probably something terribly wrong!
-        */
+    for (int port = 0; port < KEY_STATE_PORTS; ++port)
+        m_keysDown[port] = 0;
 
-        CEDRUS_ASSERT(input_found, "We failed to get a response from an XID device! See comments for why it may have failed.");
+    if (devConfig && devConfig->IsStimTracker2())
+        m_parseInput = &Cedrus::ResponseManager::ParseInput<ST2PacketDecoder>;
+    else
+        m_parseInput = &Cedrus::ResponseManager::ParseInput<XidPacketDecoder>;
+}
 
-        // Either way, we're starting fresh.
-        m_BytesInBuffer = 0;
+Cedrus::ResponseManager::~ResponseManager()
+{
+}
 
-        // We need to clean out the buffer. If the next read doesn't grab a full
-        // XID_PACKET_SIZE bytes, things can get REALLY weird.
-        memset(m_InputBuffer, 0x00, XID_PACKET_SIZE);
+// Everything per packet inlines into this, one copy for each format.
+template <class Decoder>
+void Cedrus::ResponseManager::ParseInput(std::chrono::steady_clock::time_point readTime)
+{
+    Response res;
+    ParseResult result;
+
+    while ((result = Decoder::Decode(*this, res)) != NEED_MORE_BYTES)
+    {
+        if (result == PACKET_FOUND)
+        {
+            res.hostTime = readTime;
+            QueueResponse(res);
+            res = Response();
+        }
+    }
+}
+
+// Unwraps the input ring if need be, so the scanner can see it in one piece.
+const unsigned char * Cedrus::ResponseManager::ContiguousInput()
+{
+    if (m_inputStart + m_inputCount > INPUT_RING_SIZE)
+    {
+        std::rotate(m_inputRing, m_inputRing + m_inputStart, m_inputRing + INPUT_RING_SIZE);
+        m_inputStart = 0;
     }
 
-    return input_found;
+    return m_inputRing + m_inputStart;
 }
 
-bool Cedrus::ResponseManager::ST2InputFound(Response &res)
+void Cedrus::ResponseManager::QueueResponse(Response &res)
 {
-    bool input_found = false;
-    m_XIDPacketIndex = INVALID_PACKET_INDEX;
+    const std::chrono::steady_clock::time_point parsed_time =
+        m_trackLatencyThisPass ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+    // The parsers leave the raw 32-bit timer in here.
+    res.extendedReactionTime = m_deviceTimeline.Extend(static_cast<unsigned int>(res.extendedReactionTime), res.hostTime);
+    res.key = m_respDevConfig->GetMappedKey(res.port, res.key);
+
+    // Whether or not it's queued, the key is still down.
+    UpdateKeyState(res);
 
-    if (m_BytesInBuffer == ST2_PACKET_SIZE && m_InputBuffer[0] == 'o' && m_InputBuffer[ST2_PACKET_SIZE - 1] == 0)
+    if (m_filtering && !m_filter.Accept(static_cast<int>(res.port), static_cast<int>(res.key), res.wasPressed != 0, res.extendedReactionTime))
     {
-        m_XIDPacketIndex = 0;
+        m_filteredCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // The thread feeding input holds m_parseMutex, and usually the device's
+    // I/O lock, while it waits here, and the thread that should make room
+    // may want either of them. So the wait is bounded, and once one runs
+    // out, responses are dropped without waiting until there's room again.
+    const std::chrono::steady_clock::duration max_block = m_overflowWaitExpired ?
+        std::chrono::steady_clock::duration::zero() :
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::milliseconds(BLOCKING_OVERFLOW_WAIT_MS));
 
-        res.port = m_InputBuffer[1];
-        res.key = m_InputBuffer[2];
-        res.wasPressed = m_InputBuffer[3] == '1';
+    m_overflowWaitExpired = !m_responseQueue.Push(res, max_block);
+    if (m_overflowWaitExpired)
+        return;
 
-        res.reactionTime = AdjustEndiannessCharsToUint
-        (m_InputBuffer[4], m_InputBuffer[5], m_InputBuffer[6], m_InputBuffer[7]);
+    m_queuedThisPass = true;
 
-        input_found = true;
+    if (m_trackLatencyThisPass)
+    {
+        m_latency[LATENCY_PARSED_TO_QUEUED].Record(std::chrono::steady_clock::now() - parsed_time);
+        m_latency[LATENCY_READ_TO_PARSED].Record(parsed_time - res.hostTime);
+
+        std::chrono::steady_clock::time_point device_time;
+        std::chrono::microseconds error_bound;
+        if (m_clockModel.DeviceToHost(res.extendedReactionTime, device_time, error_bound))
+            m_latency[LATENCY_DEVICE_TO_READ].Record(res.hostTime - device_time);
+    }
+}
+
+void Cedrus::ResponseManager::UpdateKeyState(const Response &res)
+{
+    const unsigned int port = static_cast<unsigned int>(res.port);
+    const unsigned int key = static_cast<unsigned int>(res.key);
+
+    bool possible;
+    if (port < KEY_STATE_PORTS && key < KEY_STATE_KEYS)
+    {
+        const unsigned long long bit = 1ull << key;
+        const unsigned long long was_down = res.wasPressed ?
+            m_keysDown[port].fetch_or(bit, std::memory_order_relaxed) & bit :
+            m_keysDown[port].fetch_and(~bit, std::memory_order_relaxed) & bit;
+
+        possible = res.wasPressed ? was_down == 0 : was_down != 0;
     }
     else
     {
-        for (int i = 1; i < m_BytesInBuffer; ++i)
+        // Not tracked individually, so all we can catch is a count gone negative.
+        possible = res.wasPressed || m_numKeysDown > 0;
+    }
+
+    if (!possible)
+        m_impossibleTransitions.fetch_add(1, std::memory_order_relaxed);
+    else if (res.wasPressed)
+        ++m_numKeysDown;
+    else
+        --m_numKeysDown;
+}
+
+// Only while the timeline is known and still well short of the boundary is
+// a nonzero high byte a sign of trouble.
+bool Cedrus::ResponseManager::AcceptsHighTimeByte(std::chrono::steady_clock::time_point readTime) const
+{
+    return !m_deviceTimeline.IsKnown() ||
+        m_deviceTimeline.EstimateDeviceTime(readTime) > DeviceTimeline::HIGH_TIME_BYTE_BOUNDARY_MS - HIGH_TIME_BYTE_MARGIN_MS;
+}
+
+unsigned char Cedrus::ResponseManager::PeekInput(unsigned int index) const
+{
+    return m_inputRing[(m_inputStart + index) & (INPUT_RING_SIZE - 1)];
+}
+
+void Cedrus::ResponseManager::DropInput(unsigned int count)
+{
+    m_inputStart = (m_inputStart + count) & (INPUT_RING_SIZE - 1);
+    m_inputCount -= count;
+}
+
+void Cedrus::ResponseManager::FeedInput(const unsigned char * bytes, unsigned int count, std::chrono::steady_clock::time_point readTime)
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    m_acceptHighTimeByte = AcceptsHighTimeByte(readTime);
+    m_queuedThisPass = false;
+    m_trackLatencyThisPass = m_trackLatency.load(std::memory_order_relaxed);
+
+    while (count > 0)
+    {
+        while (count > 0 && m_inputCount < INPUT_RING_SIZE)
         {
-            if (m_InputBuffer[i] == 'o')
-            {
-                m_XIDPacketIndex = i;
-                break;
-            }
+            m_inputRing[(m_inputStart + m_inputCount) & (INPUT_RING_SIZE - 1)] = *bytes++;
+            ++m_inputCount;
+            --count;
         }
-    }
 
-    if (m_XIDPacketIndex != INVALID_PACKET_INDEX && m_XIDPacketIndex != 0)
-        AdjustBufferForPacketRecovery();
+        (this->*m_parseInput)(readTime);
+    }
 
-    if (m_BytesInBuffer == ST2_PACKET_SIZE)
+    // Once per pass rather than per response.
+    if (m_queuedThisPass)
     {
-        m_BytesInBuffer = 0;
-        memset(m_InputBuffer, 0x00, ST2_PACKET_SIZE);
+        SignalArrival();
+
+        if (ReadinessNotifier * notifier = m_readiness.load(std::memory_order_acquire))
+            notifier->Signal();
     }
+}
+
+void Cedrus::ResponseManager::RecordDequeueLatency(const Response * responses, size_t count)
+{
+    if (count == 0 || !m_trackLatency.load(std::memory_order_relaxed))
+        return;
 
-    return input_found;
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i)
+        m_latency[LATENCY_READ_TO_DEQUEUED].Record(now - responses[i].hostTime);
 }
 
-void Cedrus::ResponseManager::CheckForKeypress(std::shared_ptr<Connection> portConnection)
+void Cedrus::ResponseManager::UpdateReadiness()
 {
-    DWORD bytes_read = 0;
-    Response res;
-    bool response_found = false;
+    ReadinessNotifier * notifier = m_readiness.load(std::memory_order_acquire);
+    if (!notifier || !notifier->IsSignaled() || !m_responseQueue.IsEmpty())
+        return;
 
-    portConnection->SetReadTimeout(2);
+    notifier->Reset();
 
-    // The amount of bytes read is variable as a part of a process that attempts to recover
-    // malformed xid packets. The process will not work 100% reliably, but it's the best we
-    // can do given the protocol.
-    portConnection->Read(&m_InputBuffer[m_BytesInBuffer], (m_packetSize - m_BytesInBuffer), &bytes_read);
+    // Something may have been queued since the check.
+    if (!m_responseQueue.IsEmpty())
+        notifier->Signal();
+}
 
-    portConnection->SetReadTimeout(50);
+void Cedrus::ResponseManager::CheckForKeypress(std::shared_ptr<Connection> portConnection)
+{
+    WaitForKeypress(portConnection, std::chrono::milliseconds(0));
+}
+
+void Cedrus::ResponseManager::WaitForKeypress(std::shared_ptr<Connection> portConnection, std::chrono::milliseconds timeout)
+{
+    // Nobody else may read between the queue check and the reads.
+    std::unique_lock<std::recursive_mutex> io_lock = portConnection->LockIO();
 
-    if(bytes_read > 0)
+    DWORD bytes_available = portConnection->GetBytesAvailable();
+    if (bytes_available == 0)
     {
-        m_BytesInBuffer += bytes_read;
-        response_found = m_ResponseParsingFunction(res);
+        if (timeout.count() <= 0)
+            return;
+
+        // The driver sleeps until the first byte comes in or the time is up.
+        portConnection->SetReadTimeout(static_cast<DWORD>(timeout.count()));
+
+        unsigned char first_byte;
+        DWORD bytes_read = 0;
+        portConnection->Read(&first_byte, 1, &bytes_read);
+
+        if (bytes_read == 0)
+        {
+            portConnection->SetReadTimeout(50);
+            return;
+        }
+
+        FeedInput(&first_byte, 1, std::chrono::steady_clock::now());
+        bytes_available = portConnection->GetBytesAvailable();
     }
 
-    if(response_found)
+    // Everything asked for is already queued, so this doesn't wait; the short
+    // timeout is only a safeguard.
+    portConnection->SetReadTimeout(2);
+
+    unsigned char chunk[INPUT_RING_SIZE];
+    while (bytes_available > 0)
     {
-        res.key = m_respDevConfig->GetMappedKey(res.port, res.key);
+        DWORD bytes_read = 0;
+        portConnection->Read(chunk, bytes_available < sizeof(chunk) ? bytes_available : sizeof(chunk), &bytes_read);
 
-        m_responseQueue.push(res);
+        if (bytes_read == 0)
+            break;
 
-        if (res.wasPressed)
-            ++m_numKeysDown;
-        else
-            --m_numKeysDown;
+        FeedInput(chunk, bytes_read, std::chrono::steady_clock::now());
+        bytes_available -= bytes_read < bytes_available ? bytes_read : bytes_available;
     }
+
+    portConnection->SetReadTimeout(50);
 }
 
-void Cedrus::ResponseManager::AdjustBufferForPacketRecovery()
+bool Cedrus::ResponseManager::HasQueuedResponses() const
 {
-    CEDRUS_ASSERT( m_XIDPacketIndex != INVALID_PACKET_INDEX, "We're about to crash, because someone misused this function!" );
-
-    unsigned char *dest_char = m_InputBuffer;
-    unsigned char *src_char  = &m_InputBuffer[m_XIDPacketIndex];
+    return !m_responseQueue.IsEmpty();
+}
 
-    // Move the k and everything after it to the beginning of the buffer.
-    for(int i = m_XIDPacketIndex; i < ST2_PACKET_SIZE; ++i, ++dest_char, ++src_char)
+bool Cedrus::ResponseManager::WaitForResponse(std::chrono::steady_clock::time_point deadline) const
+{
+    for (;;)
     {
-        *dest_char = *src_char;
-    }
+        const unsigned long long seen = GetArrivalCount();
+        if (HasQueuedResponses())
+            return true;
 
-    // CheckForKeypress() uses m_BytesInBuffer to know how many bytes
-    // to read, so we're setting it appropriately here.
-    m_BytesInBuffer = m_BytesInBuffer - m_XIDPacketIndex;
+        if (!WaitForArrival(seen, deadline))
+            return HasQueuedResponses();
+    }
+}
 
-    // Clean out the rest of the buffer past the partial packet
-    memset( &m_InputBuffer[m_BytesInBuffer], 0x00, (ST2_PACKET_SIZE - m_BytesInBuffer) );
+unsigned long long Cedrus::ResponseManager::GetArrivalCount()
+{
+    return Arrivals().arrivals.load();
 }
 
-bool Cedrus::ResponseManager::HasQueuedResponses() const
+bool Cedrus::ResponseManager::WaitForArrival(unsigned long long seenArrivals, std::chrono::steady_clock::time_point deadline)
 {
-    return !m_responseQueue.empty();
+    ArrivalSignal & signal = Arrivals();
+
+    signal.waiters.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(signal.mutex);
+        signal.arrived.wait_until(lock, deadline, [&signal, seenArrivals]() { return signal.arrivals.load() != seenArrivals; });
+    }
+    signal.waiters.fetch_sub(1);
+
+    return signal.arrivals.load() != seenArrivals;
 }
 
 // If there are no processed responses, this will return a default response
@@ -219,25 +443,183 @@ bool Cedrus::ResponseManager::HasQueuedResponses() const
 Cedrus::Response Cedrus::ResponseManager::GetNextResponse()
 {
     Response res;
-    if ( HasQueuedResponses() )
-    {
-        res = m_responseQueue.front();
-        m_responseQueue.pop();
-    }
+    if (m_responseQueue.Pop(res))
+        RecordDequeueLatency(&res, 1);
+    UpdateReadiness();
 
     return res;
 }
 
+size_t Cedrus::ResponseManager::GetResponses(Response * out, size_t maxResponses)
+{
+    const size_t count = m_responseQueue.PopBatch(out, static_cast<unsigned int>(std::min<size_t>(maxResponses, m_responseQueue.Capacity())));
+    RecordDequeueLatency(out, count);
+    UpdateReadiness();
+
+    return count;
+}
+
 unsigned int Cedrus::ResponseManager::GetNumberOfKeysDown() const
 {
     return m_numKeysDown;
 }
 
+bool Cedrus::ResponseManager::IsKeyDown(int port, int key) const
+{
+    return static_cast<unsigned int>(key) < KEY_STATE_KEYS && (GetKeysDownMask(port) & (1ull << key)) != 0;
+}
+
+unsigned long long Cedrus::ResponseManager::GetKeysDownMask(int port) const
+{
+    if (static_cast<unsigned int>(port) >= KEY_STATE_PORTS)
+        return 0;
+
+    return m_keysDown[port].load(std::memory_order_relaxed);
+}
+
+unsigned long long Cedrus::ResponseManager::GetImpossibleTransitionCount() const
+{
+    return m_impossibleTransitions.load(std::memory_order_relaxed);
+}
+
+void Cedrus::ResponseManager::ResetDeviceTimeline(std::chrono::steady_clock::time_point hostTime)
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    m_deviceTimeline.Reset(hostTime);
+    m_filter.ResetDebounce();
+}
+
 void Cedrus::ResponseManager::ClearResponseQueue()
 {
-    // This is how you clear a queue, evidently.
-    m_responseQueue = std::queue<Response>();
+    m_responseQueue.Clear();
+    UpdateReadiness();
 
     // We probably want to zero out the keypress counter.
     m_numKeysDown = 0;
+    for (int port = 0; port < KEY_STATE_PORTS; ++port)
+        m_keysDown[port] = 0;
+}
+
+void Cedrus::ResponseManager::SetOverflowPolicy(RingOverflowPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(m_overflowPolicyMutex);
+
+    m_overflowPolicy = policy;
+    m_responseQueue.SetOverflowPolicy(policy == OVERFLOW_BLOCK && !m_blockingOverflowAllowed ? OVERFLOW_DROP_NEWEST : policy);
+}
+
+Cedrus::RingOverflowPolicy Cedrus::ResponseManager::GetOverflowPolicy() const
+{
+    std::lock_guard<std::mutex> lock(m_overflowPolicyMutex);
+
+    return m_overflowPolicy;
+}
+
+void Cedrus::ResponseManager::AllowBlockingOverflow(bool allow)
+{
+    std::lock_guard<std::mutex> lock(m_overflowPolicyMutex);
+
+    m_blockingOverflowAllowed = allow;
+    // SpscRing::Push() rereads the policy while it waits.
+    m_responseQueue.SetOverflowPolicy(m_overflowPolicy == OVERFLOW_BLOCK && !allow ? OVERFLOW_DROP_NEWEST : m_overflowPolicy);
+}
+
+unsigned long long Cedrus::ResponseManager::GetDroppedResponseCount() const
+{
+    return m_responseQueue.GetOverflowCount();
+}
+
+void Cedrus::ResponseManager::SetResponseFilter(const ResponseFilter & filter)
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    m_filter = filter;
+    m_filter.ResetDebounce();
+    m_filtering = !m_filter.PassesEverything();
+}
+
+Cedrus::ResponseFilter Cedrus::ResponseManager::GetResponseFilter() const
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    return m_filter;
+}
+
+unsigned long long Cedrus::ResponseManager::GetFilteredResponseCount() const
+{
+    return m_filteredCount.load(std::memory_order_relaxed);
+}
+
+int Cedrus::ResponseManager::GetReadyFd()
+{
+    {
+        std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+        if (!m_readinessOwner)
+        {
+            m_readinessOwner = std::make_shared<ReadinessNotifier>();
+            m_readiness.store(m_readinessOwner.get(), std::memory_order_release);
+        }
+    }
+
+    // Responses queued before there was anything to signal.
+    if (!m_responseQueue.IsEmpty())
+        m_readinessOwner->Signal();
+
+    return m_readinessOwner->GetFd();
+}
+
+void Cedrus::ResponseManager::SetReadinessNotifier(std::shared_ptr<ReadinessNotifier> notifier)
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    if (m_readinessOwner || !notifier)
+        return;
+
+    m_readinessOwner = notifier;
+    m_readiness.store(m_readinessOwner.get(), std::memory_order_release);
+
+    if (!m_responseQueue.IsEmpty())
+        m_readinessOwner->Signal();
+}
+
+std::shared_ptr<Cedrus::ReadinessNotifier> Cedrus::ResponseManager::GetReadinessNotifier() const
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    return m_readinessOwner;
+}
+
+void Cedrus::ResponseManager::EnableLatencyTracking(bool enable)
+{
+    m_trackLatency = enable;
+}
+
+bool Cedrus::ResponseManager::IsLatencyTrackingEnabled() const
+{
+    return m_trackLatency;
+}
+
+const Cedrus::LatencyHistogram & Cedrus::ResponseManager::GetLatencyHistogram(ResponseLatencyStage stage) const
+{
+    CEDRUS_ASSERT(stage >= 0 && stage < NUM_LATENCY_STAGES, "GetLatencyHistogram: no such stage");
+
+    return m_latency[stage];
+}
+
+void Cedrus::ResponseManager::ResetLatencyHistograms()
+{
+    for (int stage = 0; stage < NUM_LATENCY_STAGES; ++stage)
+        m_latency[stage].Reset();
+}
+
+void Cedrus::ResponseManager::SetDeviceClockModel(const DeviceClockModel & model)
+{
+    std::lock_guard<std::mutex> parse_lock(m_parseMutex);
+    m_clockModel = model;
+}
+
+void Cedrus::ResponseManager::WriteLatencyCsv(std::ostream & out) const
+{
+    static const char * const stage_names[NUM_LATENCY_STAGES] =
+        { "device_to_read", "read_to_parsed", "parsed_to_queued", "read_to_dequeued" };
+
+    out << "stage,low_ns,high_ns,count\n";
+    for (int stage = 0; stage < NUM_LATENCY_STAGES; ++stage)
+        m_latency[stage].WriteCsv(out, stage_names[stage]);
 }
@@ -33,10 +33,17 @@
 
 #include "constants.h"
 
+#include <chrono>
 #include <memory>
-#include <functional>
-#include <queue>
+#include <mutex>
+#include <ostream>
 
+#include "DeviceClockModel.h"
+#include "DeviceTimeline.h"
+#include "LatencyHistogram.h"
+#include "ReadinessNotifier.h"
+#include "ResponseFilter.h"
+#include "SpscRing.h"
 #include "XidDriverImpExpDefs.h"
 
 namespace Cedrus
@@ -44,20 +51,52 @@ namespace Cedrus
     class Connection;
     class DeviceConfig;
 
+    // Packed into 16 bytes so that responses can be moved around in bulk.
     struct Response
     {
         Response() :
+            hostTime(),
+            extendedReactionTime(-1),
             port(-1),
             key(-1),
-            wasPressed(false),
-            reactionTime(-1) {}
+            wasPressed(false) {}
 
+        // The device's RT timer as a signed 32-bit value, the way it used to
+        // be reported. Goes negative after 24.8 days and wraps after 49.7.
+        int GetReactionTime() const
+        {
+            return static_cast<int>(static_cast<unsigned int>(extendedReactionTime));
+        }
+
+        // When the bytes that completed this response were read from the
+        // driver. See XIDDevice::DeviceTimeToHostTime() for reaction times.
+        std::chrono::steady_clock::time_point hostTime;
+        // Milliseconds on the RT timer, carried on past its rollover.
+        long long extendedReactionTime : 40;
         // Port the response came from, usually 0.
-        int port;
+        long long port : 8;
         // Button pressed. This is a 0 based index.
-        int key;
-        bool wasPressed;
-        int reactionTime;
+        long long key : 15;
+        unsigned long long wasPressed : 1;
+    };
+
+    static_assert(sizeof(Response) <= 16, "Response should stay small enough to copy around in bulk");
+
+    // The stretches of a response's way through the driver that are timed
+    // while latency tracking is on. Read is when the bytes completing the
+    // response came back from the USB driver, that is its hostTime.
+    enum ResponseLatencyStage
+    {
+        // From the device's timestamp to the read. Needs a device clock
+        // model, and is only as good as its error bound; the USB adapter's
+        // latency timer and the time between polls are in here.
+        LATENCY_DEVICE_TO_READ,
+        LATENCY_READ_TO_PARSED,
+        LATENCY_PARSED_TO_QUEUED,
+        // Until the application, or ResponseAcquisition on its behalf, takes
+        // it off the queue; includes the two above.
+        LATENCY_READ_TO_DEQUEUED,
+        NUM_LATENCY_STAGES
     };
 
     class ResponseManager
@@ -76,41 +115,192 @@ namespace Cedrus
 
         ~ResponseManager();
 
+        // Reads everything the device has sent so far and queues every
+        // complete response in it. Never waits for more bytes to arrive.
         void CheckForKeypress(std::shared_ptr<Connection> portConnection);
 
+        // As CheckForKeypress(), except that when nothing has arrived yet it
+        // waits up to timeout for something to, blocked in the driver.
+        void WaitForKeypress(std::shared_ptr<Connection> portConnection, std::chrono::milliseconds timeout);
+
+        // Parses bytes received from the device. A partial packet at the end
+        // is kept until the rest of it is fed in. readTime becomes the
+        // hostTime of every response these bytes complete.
+        void FeedInput(const unsigned char * bytes, unsigned int count,
+            std::chrono::steady_clock::time_point readTime = std::chrono::steady_clock::now());
+
         bool HasQueuedResponses() const;
 
+        // Sleeps until a response is queued or the deadline passes, and
+        // returns HasQueuedResponses(). Doesn't read the device, so something
+        // else has to, like a ResponseAcquisition.
+        bool WaitForResponse(std::chrono::steady_clock::time_point deadline) const;
+
+        // How many times any ResponseManager has queued responses. Take this
+        // before checking the queues; WaitForArrival() then sleeps only if
+        // nothing has been queued anywhere since, and returns whether
+        // something has.
+        static unsigned long long GetArrivalCount();
+        static bool WaitForArrival(unsigned long long seenArrivals, std::chrono::steady_clock::time_point deadline);
+
         Response GetNextResponse();
 
-        // Even though the number of keys down should never be negative, this
-        // returns a signed int as a way to check for errors. The count going
-        // negative means that at some point we lost a key press, and that's
-        // serious.
+        // Moves up to maxResponses queued responses into out, oldest first,
+        // and returns how many. Consumer side, like GetNextResponse.
+        size_t GetResponses(Response * out, size_t maxResponses);
+
+        // A release with no press to match doesn't take this below zero; it
+        // shows up in GetImpossibleTransitionCount() instead.
         unsigned int GetNumberOfKeysDown() const;
 
+        // Which keys are down, after mapping, as of the last response parsed.
+        // Bit n of a port's mask is key n. Ports and keys past what the masks
+        // hold read as up.
+        bool IsKeyDown(int port, int key) const;
+        unsigned long long GetKeysDownMask(int port) const;
+
+        // Releases of keys that were up and presses of keys already down,
+        // since this was created. Each means a response went missing. They
+        // don't change the key state or the count of keys down.
+        unsigned long long GetImpossibleTransitionCount() const;
+
+        // Call when the device's RT timer is reset (e5). Until then, the first
+        // response sets the timeline.
+        void ResetDeviceTimeline(std::chrono::steady_clock::time_point hostTime);
+
+        // Consumer side, like GetNextResponse.
         void ClearResponseQueue();
 
+        // What happens when a response arrives and the queue is full.
+        // OVERFLOW_BLOCK needs the queue to be drained from another thread,
+        // so it only takes effect while AllowBlockingOverflow(true) is in
+        // force. Otherwise a full queue drops the newest response. Even then
+        // it waits at most BLOCKING_OVERFLOW_WAIT_MS, since the locks it holds
+        // meanwhile keep out commands to the device; after that, responses
+        // are dropped until there's room again.
+        // GetOverflowPolicy() returns the policy as set.
+        enum { BLOCKING_OVERFLOW_WAIT_MS = 50 };
+        void SetOverflowPolicy(RingOverflowPolicy policy);
+        RingOverflowPolicy GetOverflowPolicy() const;
+
+        // For whoever owns the thread that feeds input: allow only while
+        // another thread drains the queue. Disallowing releases a feed that
+        // is waiting on a full queue.
+        void AllowBlockingOverflow(bool allow);
+
+        // Responses lost to a full queue since this was created.
+        unsigned long long GetDroppedResponseCount() const;
+
+        // Applied to responses from here on, with no debounce history.
+        void SetResponseFilter(const ResponseFilter & filter);
+        ResponseFilter GetResponseFilter() const;
+
+        // Responses the filter kept out of the queue since this was created.
+        unsigned long long GetFilteredResponseCount() const;
+
+        // Off by default. While on, every queued response is timed into a
+        // histogram per ResponseLatencyStage, at the cost of a few clock
+        // reads per response.
+        void EnableLatencyTracking(bool enable);
+        bool IsLatencyTrackingEnabled() const;
+        const LatencyHistogram & GetLatencyHistogram(ResponseLatencyStage stage) const;
+        void ResetLatencyHistograms();
+
+        // Maps device timestamps to host time for LATENCY_DEVICE_TO_READ,
+        // which isn't recorded until the model has two samples.
+        void SetDeviceClockModel(const DeviceClockModel & model);
+
+        // Every stage's histogram, as "stage,low_ns,high_ns,count" lines
+        // under a header line.
+        void WriteLatencyCsv(std::ostream & out) const;
+
+        // A descriptor that is readable while responses are queued, for
+        // event loops; -1 on Windows. It needs something else to read the
+        // device, like a ResponseAcquisition with no subscribers. Made on
+        // first use, after which the same one is returned.
+        int GetReadyFd();
+        // To keep the same descriptor across managers. Does nothing once
+        // this manager has one.
+        void SetReadinessNotifier(std::shared_ptr<ReadinessNotifier> notifier);
+        // Empty until GetReadyFd() or SetReadinessNotifier().
+        std::shared_ptr<ReadinessNotifier> GetReadinessNotifier() const;
+
     private:
         enum { OS_FILE_ERROR = -1 };
 
-        void AdjustBufferForPacketRecovery();
-        bool XidInputFound(Response &res);
-        bool ST2InputFound(Response &res);
+        enum ParseResult { PACKET_FOUND, BYTES_DROPPED, NEED_MORE_BYTES };
+
+        // Defined with the parser; each knows one packet format.
+        struct XidPacketDecoder;
+        struct ST2PacketDecoder;
+
+        // Parses and queues every complete packet in the input.
+        template <class Decoder>
+        void ParseInput(std::chrono::steady_clock::time_point readTime);
+        const unsigned char * ContiguousInput();
+        void QueueResponse(Response &res);
+        void UpdateKeyState(const Response &res);
+        bool AcceptsHighTimeByte(std::chrono::steady_clock::time_point readTime) const;
+        // Consumer side, after taking responses.
+        void UpdateReadiness();
+        void RecordDequeueLatency(const Response * responses, size_t count);
+
+        unsigned char PeekInput(unsigned int index) const;
+        void DropInput(unsigned int count);
 
-        enum { XID_PACKET_SIZE = 6 };
-        enum { ST2_PACKET_SIZE = 9 };
-        enum { INVALID_PACKET_INDEX = -1 };
         enum { KEY_RELEASE_BITMASK = 0x10 };
+        // Must be a power of two. Only a partial packet stays in here between
+        // calls, so this just limits how many bytes are parsed per pass.
+        enum { INPUT_RING_SIZE = 512 };
+        enum { RESPONSE_QUEUE_CAPACITY = 1024 };
+        // How sure we have to be that the timer hasn't yet reached
+        // DeviceTimeline::HIGH_TIME_BYTE_BOUNDARY_MS.
+        enum { HIGH_TIME_BYTE_MARGIN_MS = 60000 };
+        enum { KEY_STATE_PORTS = 16, KEY_STATE_KEYS = 64 };
+
+        // Bytes received but not yet parsed, m_inputCount of them starting at
+        // m_inputStart.
+        unsigned char m_inputRing[INPUT_RING_SIZE];
+        unsigned int m_inputStart;
+        unsigned int m_inputCount;
 
-        // Used by the response parsing logic
-        int m_BytesInBuffer;
-        unsigned char m_InputBuffer[ST2_PACKET_SIZE];
-        int m_XIDPacketIndex;
-        unsigned int m_packetSize;
+        // Guarded by m_parseMutex, since the timer can be reset and the
+        // filter changed from another thread than the one feeding input.
+        DeviceTimeline m_deviceTimeline;
+        ResponseFilter m_filter;
+        bool m_filtering;
+        mutable std::mutex m_parseMutex;
+        // Whether an XID packet may end in a nonzero byte, for this pass.
+        bool m_acceptHighTimeByte;
+        // Whether this pass queued anything for a waiter to wake up for.
+        bool m_queuedThisPass;
+        // Whether the last response was dropped; if so the next doesn't wait.
+        bool m_overflowWaitExpired;
+        // Latency tracking, as of the start of this pass.
+        bool m_trackLatencyThisPass;
+        DeviceClockModel m_clockModel;
 
-        unsigned int m_numKeysDown;
-        std::queue<Response> m_responseQueue;
-        std::function< bool(Response&) > m_ResponseParsingFunction;
+        std::atomic<unsigned int> m_numKeysDown;
+        // Written while parsing, read from anywhere.
+        std::atomic<unsigned long long> m_keysDown[KEY_STATE_PORTS];
+        std::atomic<unsigned long long> m_impossibleTransitions;
+        std::atomic<unsigned long long> m_filteredCount;
+        std::atomic<bool> m_trackLatency;
+        // The dequeue stage is recorded by the consumer, the others while
+        // parsing.
+        LatencyHistogram m_latency[NUM_LATENCY_STAGES];
+        // Filled while parsing, drained by GetNextResponse, possibly from
+        // another thread.
+        SpscRing<Response> m_responseQueue;
+        // The queue's policy follows from these two.
+        mutable std::mutex m_overflowPolicyMutex;
+        RingOverflowPolicy m_overflowPolicy;
+        bool m_blockingOverflowAllowed;
+        // Set once, under m_parseMutex; m_readiness is for lock-free use.
+        std::shared_ptr<ReadinessNotifier> m_readinessOwner;
+        std::atomic<ReadinessNotifier *> m_readiness;
+        // ParseInput() for this device's packet format, picked once.
+        void (ResponseManager::*m_parseInput)(std::chrono::steady_clock::time_point);
         const std::shared_ptr<const DeviceConfig> m_respDevConfig;
     };
 } // namespace Cedrus
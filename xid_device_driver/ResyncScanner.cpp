@@ -0,0 +1,253 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "ResyncScanner.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define CEDRUS_RESYNC_SSE2
+#   include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#   define CEDRUS_RESYNC_AVX2
+#   include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace
+{
+    unsigned int LowestSetBit(unsigned int mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // Each shape checks a position one at a time with Matches(), which lets
+    // bytes past the end of the input pass, and a block of positions at a
+    // time with MatchesN(), which may read up to SIMD_REACH bytes past the
+    // block.
+    struct XidPacketShape
+    {
+        enum { SIZE = 6, SIMD_REACH = 5 };
+        enum { INVALID_PORT_BITS = 0x08 };
+
+        bool requireZeroLastByte;
+
+        bool Matches(const unsigned char * bytes, unsigned int count, unsigned int i) const
+        {
+            return bytes[i] == 'k' &&
+                (i + 1 >= count || (bytes[i + 1] & INVALID_PORT_BITS) == 0) &&
+                (!requireZeroLastByte || i + 5 >= count || bytes[i + 5] == 0);
+        }
+
+#ifdef CEDRUS_RESYNC_SSE2
+        unsigned int Matches16(const unsigned char * p) const
+        {
+            const __m128i zero = _mm_setzero_si128();
+
+            __m128i hits = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_set1_epi8('k'));
+            hits = _mm_and_si128(hits, _mm_cmpeq_epi8(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), _mm_set1_epi8(INVALID_PORT_BITS)), zero));
+            if (requireZeroLastByte)
+                hits = _mm_and_si128(hits, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 5)), zero));
+
+            return static_cast<unsigned int>(_mm_movemask_epi8(hits));
+        }
+#endif
+
+#ifdef CEDRUS_RESYNC_AVX2
+        unsigned int Matches32(const unsigned char * p) const
+        {
+            const __m256i zero = _mm256_setzero_si256();
+
+            __m256i hits = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), _mm256_set1_epi8('k'));
+            hits = _mm256_and_si256(hits, _mm256_cmpeq_epi8(_mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), _mm256_set1_epi8(INVALID_PORT_BITS)), zero));
+            if (requireZeroLastByte)
+                hits = _mm256_and_si256(hits, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 5)), zero));
+
+            return static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+        }
+#endif
+    };
+
+    // 'o', port, key, '0' or '1', four bytes of time and a 0.
+    struct ST2PacketShape
+    {
+        enum { SIZE = 9, SIMD_REACH = 8 };
+
+        bool Matches(const unsigned char * bytes, unsigned int count, unsigned int i) const
+        {
+            return bytes[i] == 'o' &&
+                (i + 3 >= count || (bytes[i + 3] | 1) == '1') &&
+                (i + 8 >= count || bytes[i + 8] == 0);
+        }
+
+#ifdef CEDRUS_RESYNC_SSE2
+        unsigned int Matches16(const unsigned char * p) const
+        {
+            __m128i hits = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_set1_epi8('o'));
+            hits = _mm_and_si128(hits, _mm_cmpeq_epi8(_mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3)), _mm_set1_epi8(1)), _mm_set1_epi8('1')));
+            hits = _mm_and_si128(hits, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 8)), _mm_setzero_si128()));
+
+            return static_cast<unsigned int>(_mm_movemask_epi8(hits));
+        }
+#endif
+
+#ifdef CEDRUS_RESYNC_AVX2
+        unsigned int Matches32(const unsigned char * p) const
+        {
+            __m256i hits = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), _mm256_set1_epi8('o'));
+            hits = _mm256_and_si256(hits, _mm256_cmpeq_epi8(_mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 3)), _mm256_set1_epi8(1)), _mm256_set1_epi8('1')));
+            hits = _mm256_and_si256(hits, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 8)), _mm256_setzero_si256()));
+
+            return static_cast<unsigned int>(_mm256_movemask_epi8(hits));
+        }
+#endif
+    };
+
+    // The earliest candidate wins unless a later one that overlaps it is
+    // followed by another packet, or by the end of the input, and it isn't.
+    // Dropping a real packet that just happens to have junk after it would be
+    // worse than the odd false start.
+    template <class Shape>
+    class ResyncSearch
+    {
+    public:
+        ResyncSearch(const Shape & shape, const unsigned char * bytes, unsigned int count)
+            : m_shape(shape),
+              m_bytes(bytes),
+              m_count(count),
+              m_firstCandidate(count)
+        {
+        }
+
+        unsigned int Find(bool useSimd)
+        {
+            unsigned int i = 1;
+            unsigned int offset = 0;
+
+            if (useSimd)
+            {
+#ifdef CEDRUS_RESYNC_AVX2
+                for (; i + 32 + Shape::SIMD_REACH <= m_count; i += 32)
+                {
+                    for (unsigned int hits = m_shape.Matches32(m_bytes + i); hits != 0; hits &= hits - 1)
+                    {
+                        if (IsDecidedBy(i + LowestSetBit(hits), offset))
+                            return offset;
+                    }
+                }
+#endif
+#ifdef CEDRUS_RESYNC_SSE2
+                for (; i + 16 + Shape::SIMD_REACH <= m_count; i += 16)
+                {
+                    for (unsigned int hits = m_shape.Matches16(m_bytes + i); hits != 0; hits &= hits - 1)
+                    {
+                        if (IsDecidedBy(i + LowestSetBit(hits), offset))
+                            return offset;
+                    }
+                }
+#endif
+            }
+
+            for (; i < m_count; ++i)
+            {
+                if (m_shape.Matches(m_bytes, m_count, i) && IsDecidedBy(i, offset))
+                    return offset;
+            }
+
+            return m_firstCandidate;
+        }
+
+    private:
+        // Candidates must come in order.
+        bool IsDecidedBy(unsigned int candidate, unsigned int & offset)
+        {
+            if (m_firstCandidate != m_count && candidate >= m_firstCandidate + Shape::SIZE)
+            {
+                offset = m_firstCandidate;
+                return true;
+            }
+
+            const unsigned int next = candidate + Shape::SIZE;
+            if (next >= m_count || m_shape.Matches(m_bytes, m_count, next))
+            {
+                offset = candidate;
+                return true;
+            }
+
+            if (m_firstCandidate == m_count)
+                m_firstCandidate = candidate;
+
+            return false;
+        }
+
+        const Shape & m_shape;
+        const unsigned char * m_bytes;
+        const unsigned int m_count;
+        unsigned int m_firstCandidate;
+    };
+
+    template <class Shape>
+    unsigned int FindResyncOffset(const Shape & shape, const unsigned char * bytes, unsigned int count, bool useSimd)
+    {
+        return ResyncSearch<Shape>(shape, bytes, count).Find(useSimd);
+    }
+}
+
+unsigned int Cedrus::FindXidResyncOffset(const unsigned char * bytes, unsigned int count, bool requireZeroLastByte)
+{
+    const XidPacketShape shape = { requireZeroLastByte };
+    return FindResyncOffset(shape, bytes, count, true);
+}
+
+unsigned int Cedrus::FindXidResyncOffset_Scalar(const unsigned char * bytes, unsigned int count, bool requireZeroLastByte)
+{
+    const XidPacketShape shape = { requireZeroLastByte };
+    return FindResyncOffset(shape, bytes, count, false);
+}
+
+unsigned int Cedrus::FindST2ResyncOffset(const unsigned char * bytes, unsigned int count)
+{
+    return FindResyncOffset(ST2PacketShape(), bytes, count, true);
+}
+
+unsigned int Cedrus::FindST2ResyncOffset_Scalar(const unsigned char * bytes, unsigned int count)
+{
+    return FindResyncOffset(ST2PacketShape(), bytes, count, false);
+}
@@ -0,0 +1,55 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include "XidDriverImpExpDefs.h"
+
+namespace Cedrus
+{
+    // For getting back in step with the device after junk in the input.
+    // Each returns the offset, from 1 up, of the first place a packet could
+    // start. Where two such places overlap, the one followed by another
+    // plausible packet, or by the end of the input, is preferred. A packet cut
+    // off by the end of the input is judged by the bytes there are. Returns
+    // count if there is no such place.
+    //
+    // Sixteen or thirty-two positions are checked at a time with SSE2 or
+    // AVX2 where the compiler targets them. The _Scalar versions check one
+    // at a time and give the same answers.
+
+    // requireZeroLastByte: see ResponseManager::AcceptsHighTimeByte().
+    CEDRUS_XIDDRIVER_IMPORTEXPORT unsigned int FindXidResyncOffset(const unsigned char * bytes, unsigned int count, bool requireZeroLastByte);
+    CEDRUS_XIDDRIVER_IMPORTEXPORT unsigned int FindXidResyncOffset_Scalar(const unsigned char * bytes, unsigned int count, bool requireZeroLastByte);
+
+    CEDRUS_XIDDRIVER_IMPORTEXPORT unsigned int FindST2ResyncOffset(const unsigned char * bytes, unsigned int count);
+    CEDRUS_XIDDRIVER_IMPORTEXPORT unsigned int FindST2ResyncOffset_Scalar(const unsigned char * bytes, unsigned int count);
+} // namespace Cedrus
@@ -0,0 +1,233 @@
+/* Copyright (c) 2010, Cedrus Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * Neither the name of Cedrus Corporation nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+namespace Cedrus
+{
+    enum RingOverflowPolicy
+    {
+        // Push waits for the consumer to make room, or for as long as it's
+        // told to. Only safe when the consumer runs on another thread.
+        // Switching to another policy releases a Push that is waiting.
+        OVERFLOW_BLOCK,
+        // The oldest queued item is discarded to make room. Pop may then have
+        // to retry when it races with the producer, so it's lock-free rather
+        // than wait-free in this mode.
+        OVERFLOW_DROP_OLDEST,
+        // The item being pushed is discarded.
+        OVERFLOW_DROP_NEWEST
+    };
+
+    // A bounded queue for exactly one producer thread and one consumer
+    // thread. All memory is allocated up front. Push and Pop never lock, and
+    // only wait in the cases described above. T must be trivially copyable.
+    template <typename T>
+    class SpscRing
+    {
+    public:
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        // capacity is rounded up to a power of two.
+        explicit SpscRing(unsigned int capacity, RingOverflowPolicy policy = OVERFLOW_DROP_NEWEST)
+            : m_writeIndex(0),
+              m_readIndex(0),
+              m_capacity(RoundUpToPowerOfTwo(capacity)),
+              m_slots(new T[m_capacity]),
+              m_policy(policy),
+              m_overflowCount(0)
+        {
+        }
+
+        // Producer only. Returns false if item was dropped.
+        bool Push(const T & item)
+        {
+            return Push(item, std::chrono::steady_clock::duration::max());
+        }
+
+        // Under OVERFLOW_BLOCK, gives up after maxBlock and drops item.
+        bool Push(const T & item, std::chrono::steady_clock::duration maxBlock)
+        {
+            const unsigned int write_index = m_writeIndex.load(std::memory_order_relaxed);
+            std::chrono::steady_clock::time_point give_up = std::chrono::steady_clock::time_point::max();
+
+            while (write_index - m_readIndex.load(std::memory_order_acquire) >= m_capacity)
+            {
+                const RingOverflowPolicy policy = m_policy.load(std::memory_order_relaxed);
+
+                if (policy == OVERFLOW_DROP_NEWEST)
+                {
+                    m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                if (policy == OVERFLOW_DROP_OLDEST)
+                {
+                    unsigned int read_index = write_index - m_capacity;
+
+                    // Fails if the consumer took it first, which also makes room.
+                    if (m_readIndex.compare_exchange_strong(read_index, read_index + 1, std::memory_order_acq_rel))
+                        m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+                    if (give_up == std::chrono::steady_clock::time_point::max() && maxBlock != std::chrono::steady_clock::duration::max())
+                        give_up = now + maxBlock;
+
+                    if (now >= give_up)
+                    {
+                        m_overflowCount.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+
+                    std::this_thread::yield();
+                }
+            }
+
+            m_slots[write_index & (m_capacity - 1)] = item;
+            m_writeIndex.store(write_index + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Consumer only. Returns false if there was nothing to pop.
+        bool Pop(T & item)
+        {
+            unsigned int read_index = m_readIndex.load(std::memory_order_acquire);
+
+            for (;;)
+            {
+                if (read_index == m_writeIndex.load(std::memory_order_acquire))
+                    return false;
+
+                item = m_slots[read_index & (m_capacity - 1)];
+
+                // The producer only moves the read index when dropping the
+                // oldest item, in which case the copy may be torn; try again.
+                if (m_readIndex.compare_exchange_strong(read_index, read_index + 1, std::memory_order_acq_rel))
+                    return true;
+            }
+        }
+
+        // Consumer only. Pops up to maxItems at once, returning how many.
+        unsigned int PopBatch(T * items, unsigned int maxItems)
+        {
+            unsigned int read_index = m_readIndex.load(std::memory_order_acquire);
+
+            for (;;)
+            {
+                const unsigned int available = m_writeIndex.load(std::memory_order_acquire) - read_index;
+                const unsigned int count = available < maxItems ? available : maxItems;
+                if (count == 0)
+                    return 0;
+
+                for (unsigned int i = 0; i < count; ++i)
+                    items[i] = m_slots[(read_index + i) & (m_capacity - 1)];
+
+                // See Pop().
+                if (m_readIndex.compare_exchange_strong(read_index, read_index + count, std::memory_order_acq_rel))
+                    return count;
+            }
+        }
+
+        // Consumer only.
+        void Clear()
+        {
+            T item;
+            while (Pop(item))
+            {
+            }
+        }
+
+        bool IsEmpty() const
+        {
+            return m_readIndex.load(std::memory_order_acquire) == m_writeIndex.load(std::memory_order_acquire);
+        }
+
+        unsigned int Size() const
+        {
+            const unsigned int read_index = m_readIndex.load(std::memory_order_acquire);
+            return m_writeIndex.load(std::memory_order_acquire) - read_index;
+        }
+
+        unsigned int Capacity() const
+        {
+            return m_capacity;
+        }
+
+        void SetOverflowPolicy(RingOverflowPolicy policy)
+        {
+            m_policy.store(policy, std::memory_order_relaxed);
+        }
+
+        RingOverflowPolicy GetOverflowPolicy() const
+        {
+            return m_policy.load(std::memory_order_relaxed);
+        }
+
+        // Items dropped because the ring was full, under either drop policy
+        // or after a bounded wait.
+        unsigned long long GetOverflowCount() const
+        {
+            return m_overflowCount.load(std::memory_order_relaxed);
+        }
+
+    private:
+        enum { CACHE_LINE_SIZE = 64 };
+
+        static unsigned int RoundUpToPowerOfTwo(unsigned int n)
+        {
+            unsigned int power = 1;
+            while (power < n)
+                power <<= 1;
+
+            return power;
+        }
+
+        // Each index is written by one side and read by the other, so they
+        // get a cache line each.
+        alignas(CACHE_LINE_SIZE) std::atomic<unsigned int> m_writeIndex;
+        alignas(CACHE_LINE_SIZE) std::atomic<unsigned int> m_readIndex;
+
+        alignas(CACHE_LINE_SIZE) const unsigned int m_capacity;
+        const std::unique_ptr<T[]> m_slots;
+        std::atomic<RingOverflowPolicy> m_policy;
+        std::atomic<unsigned long long> m_overflowCount;
+    };
+} // namespace Cedrus
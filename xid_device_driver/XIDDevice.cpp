@@ -52,22 +52,35 @@ Cedrus::XIDDevice::XIDDevice(std::shared_ptr<Connection> xidCon, std::shared_ptr
     m_podHostConfig(),
     m_ResponseMgr(devConfig->IsInputDevice() ? new ResponseManager(m_config) : nullptr),
     m_baudRatePriorToMpod(115200),
-    m_curMinorFwVer(GetMinorFirmwareVersion())
-{
+    m_curMinorFwVer(0),
+    m_minorFwVerKnown(false),
+    m_propertyCacheHits(0),
+    m_propertyCacheMisses(0),
+    m_bypassPropertyCache(false),
+    m_deferFlashSettling(false),
+    m_flashSettlePending(false),
+    m_verifyFlashCommits(false),
+    m_committedLineMappingCRC(0),
+    m_committedLineMappingCRCKnown(false),
+    m_firmwareCapabilitiesKnown(false),
+    m_acquisition(new ResponseAcquisition())
+{
+    UpdateCapabilities();
 }
 
 Cedrus::XIDDevice::~XIDDevice()
 {
+    m_acquisition->Stop();
 }
 
 int Cedrus::XIDDevice::GetOutputLogic() const
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_OUTPUT_LOGIC))
         return INVALID_RETURN_VALUE;
 
     unsigned char output_logic[4];
 
-    m_xidCon->SendXIDCommand("_a0", 3, output_logic, sizeof(output_logic));
+    QueryProperty("_a0", 3, output_logic, sizeof(output_logic));
 
     bool return_valid_a0 = strncmp((char*)output_logic, "_a0", 3) == 0;
 
@@ -76,23 +89,22 @@ int Cedrus::XIDDevice::GetOutputLogic() const
 
 void Cedrus::XIDDevice::SetOutputLogic(unsigned char mode)
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_OUTPUT_LOGIC))
         return;
 
     static unsigned char sol_cmd[3] = { 'a', '0' };
     sol_cmd[2] = mode + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(sol_cmd, 3, &bytes_written);
+    WriteSetting(sol_cmd, 3, 3);
 }
 
 int Cedrus::XIDDevice::GetAccessoryConnectorMode() const
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_ACCESSORY_CONNECTOR_MODE))
         return INVALID_RETURN_VALUE;
 
     unsigned char return_info[4]; // we rely on SendXIDCommand to zero-initialize this buffer
-    m_xidCon->SendXIDCommand("_a1", 3, return_info, sizeof(return_info));
+    QueryProperty("_a1", 3, return_info, sizeof(return_info));
 
     bool return_valid_a1 = strncmp((char*)return_info, "_a1", 3) == 0;
     bool return_valid_val = return_info[3] >= 48 && return_info[3] <= 51;
@@ -105,24 +117,23 @@ int Cedrus::XIDDevice::GetAccessoryConnectorMode() const
 
 void Cedrus::XIDDevice::SetAccessoryConnectorMode(unsigned char mode)
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_ACCESSORY_CONNECTOR_MODE))
         return;
 
     static unsigned char sacm_cmd[3] = { 'a','1' };
     sacm_cmd[2] = mode + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(sacm_cmd, 3, &bytes_written);
+    WriteSetting(sacm_cmd, 3, 3);
 }
 
 int Cedrus::XIDDevice::GetACDebouncingTime() const
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_AC_DEBOUNCING_TIME))
         return INVALID_RETURN_VALUE;
 
     unsigned char threshold_return[4];
 
-    m_xidCon->SendXIDCommand("_a6", 3, threshold_return, sizeof(threshold_return));
+    QueryProperty("_a6", 3, threshold_return, sizeof(threshold_return));
 
     bool return_valid = strncmp((char*)threshold_return, "_a6", 3) == 0;
 
@@ -134,19 +145,18 @@ int Cedrus::XIDDevice::GetACDebouncingTime() const
 
 void Cedrus::XIDDevice::SetACDebouncingTime(unsigned char time)
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_AC_DEBOUNCING_TIME))
         return;
 
     static unsigned char sacdt_command[3] = {'a','6'};
     sacdt_command[2] = time;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(sacdt_command, 3, &bytes_written);
+    WriteSetting(sacdt_command, 3, 3);
 }
 
 unsigned int Cedrus::XIDDevice::GetFlashBackupCRC() const
 {
-    if (!(m_config->IsMPod() || m_config->IsCPod()) || m_curMinorFwVer < 22)
+    if (!Supports(CMD_FLASH_BACKUP))
         return 0;
 
     unsigned char crc_return[7];
@@ -161,15 +171,25 @@ unsigned int Cedrus::XIDDevice::GetFlashBackupCRC() const
     return crc;
 }
 
-void Cedrus::XIDDevice::BackupFlashData()
+bool Cedrus::XIDDevice::BackupFlashData()
 {
-    if (!(m_config->IsMPod() || m_config->IsCPod()) || m_curMinorFwVer < 22)
-        return;
+    if (!Supports(CMD_FLASH_BACKUP))
+        return false;
 
     // Get the CRC to unlock the m-pod
     unsigned char crc_return[7];
     m_xidCon->SendXIDCommand("_ab", 3, crc_return, sizeof(crc_return));
 
+    const unsigned int backup_crc = AdjustEndiannessCharsToUint(
+        crc_return[3],
+        crc_return[4],
+        crc_return[5],
+        crc_return[6]);
+
+    // A backup that matches the translation tables would be rewritten as is.
+    if (backup_crc != 0 && backup_crc == GetTranslationTableCRC())
+        return true;
+
     static unsigned char spdtfb_cmd[6] = { 'a','b' };
     spdtfb_cmd[2] = crc_return[3];
     spdtfb_cmd[3] = crc_return[4];
@@ -178,11 +198,17 @@ void Cedrus::XIDDevice::BackupFlashData()
 
     DWORD bytes_written = 0;
     m_xidCon->Write ( spdtfb_cmd, 6, &bytes_written, SAVES_TO_FLASH );
+
+    if (!m_verifyFlashCommits)
+        return true;
+
+    const unsigned int new_backup_crc = GetFlashBackupCRC();
+    return new_backup_crc != 0 && new_backup_crc == GetTranslationTableCRC();
 }
 
 unsigned int Cedrus::XIDDevice::GetTranslationTableCRC() const
 {
-    if (!(m_config->IsMPod() || m_config->IsCPod()) || m_curMinorFwVer < 22)
+    if (!Supports(CMD_TRANSLATION_TABLE_CRC))
         return 0;
 
     unsigned char crc_return[7];
@@ -199,57 +225,55 @@ unsigned int Cedrus::XIDDevice::GetTranslationTableCRC() const
 
 bool Cedrus::XIDDevice::IsMpodOutputEnabled() const
 {
-    if (!m_config->IsXID2InputDevice())
+    if (!Supports(CMD_MPOD_OUTPUT_ENABLE))
         return false;
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_ae", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_ae", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::EnableMpodOutput(bool enable)
 {
-    if (!m_config->IsXID2InputDevice())
+    if (!Supports(CMD_MPOD_OUTPUT_ENABLE))
         return;
 
     static unsigned char emo_command[3] = { 'a','e' };
     emo_command[2] = enable ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(emo_command, 3, &bytes_written);
+    WriteSetting(emo_command, 3, 3);
 }
 
 unsigned char Cedrus::XIDDevice::GetMpodOutputMode() const
 {
-    if (!m_config->IsMPod())
+    if (!Supports(CMD_MPOD_OUTPUT_MODE))
         return '0';
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_am", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_am", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3] - '0';
 }
 
 void Cedrus::XIDDevice::SetMpodOutputMode(unsigned char mode)
 {
-    if (!m_config->IsMPod())
+    if (!Supports(CMD_MPOD_OUTPUT_MODE))
         return;
 
     static unsigned char smom_command[3] = { 'a','m' };
     smom_command[2] = mode + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( smom_command, 3, &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(smom_command, 3, 3, SAVES_TO_FLASH);
 
-    SLEEP_FUNC(50 * SLEEP_INC);
+    SettleAfterSetting();
 }
 
 bool Cedrus::XIDDevice::IsPodLocked() const
 {
-    if (!(m_config->IsMPod() || m_config->IsCPod()) || m_curMinorFwVer < 22)
+    if (!Supports(CMD_POD_LOCK))
         return false;
 
     unsigned char locked_return[8];
@@ -260,7 +284,7 @@ bool Cedrus::XIDDevice::IsPodLocked() const
 
 unsigned int Cedrus::XIDDevice::GetPodUnlockCRC() const
 {
-    if (!(m_config->IsMPod() || m_config->IsCPod()) || m_curMinorFwVer < 22)
+    if (!Supports(CMD_POD_LOCK))
         return 0;
 
     unsigned char crc_return[7];
@@ -275,17 +299,19 @@ unsigned int Cedrus::XIDDevice::GetPodUnlockCRC() const
     return crc;
 }
 
-void Cedrus::XIDDevice::LockPod(bool lock)
+bool Cedrus::XIDDevice::LockPod(bool lock)
 {
-    if (!(m_config->IsMPod() || m_config->IsCPod()) || m_curMinorFwVer < 22)
-        return;
+    if (!Supports(CMD_POD_LOCK))
+        return false;
 
-    // Get the CRC to unlock the m-pod
+    // Get the CRC to unlock the m-pod, and see whether there's anything to do.
     unsigned char crc_return[8];
+    m_xidCon->SendXIDCommand("_au", 3, crc_return, sizeof(crc_return));
 
-    if (!lock)
-        m_xidCon->SendXIDCommand("_au", 3, crc_return, sizeof(crc_return));
-    else
+    if (strncmp((char*)crc_return, "_au", 3) == 0 && (crc_return[3] != '1') == lock)
+        return true;
+
+    if (lock)
         memset(crc_return, 0x00, 8);
 
     static unsigned char lock_pod_cmd[7] = { 'a','u' };
@@ -297,61 +323,61 @@ void Cedrus::XIDDevice::LockPod(bool lock)
 
     DWORD bytes_written = 0;
     m_xidCon->Write(lock_pod_cmd, 7, &bytes_written);
+
+    return !m_verifyFlashCommits || IsPodLocked() == lock;
 }
 
 unsigned char Cedrus::XIDDevice::GetMpodPulseDuration() const
 {
-    if (!m_config->IsMPod())
+    if (!Supports(CMD_MPOD_PULSE_DURATION))
         return '0';
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_aw", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_aw", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3];
 }
 
 void Cedrus::XIDDevice::SetMpodPulseDuration(unsigned char duration)
 {
-    if (!m_config->IsMPod())
+    if (!Supports(CMD_MPOD_PULSE_DURATION))
         return;
 
     static unsigned char smpd_command[3] = { 'a','w' };
     smpd_command[2] = duration;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(smpd_command, 3, &bytes_written);
+    WriteSetting(smpd_command, 3, 3);
 
-    SLEEP_FUNC(50 * SLEEP_INC);
+    SettleAfterSetting();
 }
 
 char Cedrus::XIDDevice::GetPodOutputLogic() const
 {
-    if (!m_config->IsPod())
+    if (!Supports(CMD_POD_OUTPUT_LOGIC))
         return '0';
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_al", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_al", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3];
 }
 
 void Cedrus::XIDDevice::SetPodOutputLogic(char logic)
 {
-    if (!m_config->IsPod())
+    if (!Supports(CMD_POD_OUTPUT_LOGIC))
         return;
 
     static unsigned char spol_command[3] = { 'a','l' };
     spol_command[2] = logic;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( spol_command, 3, &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(spol_command, 3, 3, SAVES_TO_FLASH);
 }
 
 int Cedrus::XIDDevice::GetMpodModel(unsigned char mpod) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MPOD_CONNECTION))
         return INVALID_RETURN_VALUE;
 
     static char gmm_cmd[4] = { '_','a','q' };
@@ -368,7 +394,7 @@ int Cedrus::XIDDevice::GetMpodModel(unsigned char mpod) const
 
 void Cedrus::XIDDevice::ConnectToMpod(unsigned char mpod, unsigned char action)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MPOD_CONNECTION))
         return;
 
     int rate = 4;
@@ -412,45 +438,49 @@ void Cedrus::XIDDevice::ConnectToMpod(unsigned char mpod, unsigned char action)
 
     SLEEP_FUNC(150 * SLEEP_INC);
 
+    // From here on, queries are answered by a different device.
+    ClearPropertyCache();
+
     m_podHostConfig = (action == 0 ? nullptr : m_config);
     MatchConfigToModel_MPod(-1);
 
-    m_curMinorFwVer = GetMinorFirmwareVersion();
-
     if (action == 0)
         SetBaudRate ( static_cast<unsigned char> (rate) );
 }
 
 unsigned char Cedrus::XIDDevice::GetTranslationTable() const
 {
-    if (!m_config->IsMPod())
+    if (!Supports(CMD_TRANSLATION_TABLE))
         return 0;
 
     static char gtt_command[3] = { '_','a','s' };
 
     unsigned char return_info[4];
-    m_xidCon->SendXIDCommand(gtt_command, 3, return_info, sizeof(return_info));
+    QueryProperty(gtt_command, 3, return_info, sizeof(return_info));
 
     return return_info[3] - '0';
 }
 
 void Cedrus::XIDDevice::SetTranslationTable(unsigned char table)
 {
-    if (!m_config->IsMPod())
+    if (!Supports(CMD_TRANSLATION_TABLE))
         return;
 
     static unsigned char stt_cmd[3] = { 'a','s' };
     stt_cmd[2] = table + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(stt_cmd, 3, &bytes_written);
+    WriteSetting(stt_cmd, 3, 3);
 
-    SLEEP_FUNC(50 * SLEEP_INC);
+    // Line mappings are read from whichever table is current.
+    ForgetProperty("_at");
+    m_committedLineMappingCRCKnown = false;
+
+    SettleAfterSetting();
 }
 
 unsigned int Cedrus::XIDDevice::GetMappedSignals(unsigned int line)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MAPPED_SIGNALS))
         return 0;
 
     static char gms_cmd[4] = { '_','a','t' };
@@ -458,7 +488,7 @@ unsigned int Cedrus::XIDDevice::GetMappedSignals(unsigned int line)
     gms_cmd[3] = line_as_char > 9 ? '7' + line_as_char : '0' + line_as_char;
 
     unsigned char mapped_signals_return[12];
-    m_xidCon->SendXIDCommand(gms_cmd, 4, mapped_signals_return, sizeof(mapped_signals_return));
+    QueryProperty(gms_cmd, 4, mapped_signals_return, sizeof(mapped_signals_return));
 
     //bool return_valid = strncmp((char*)mapped_signals_return, "_at", 3) == 0;
 
@@ -477,7 +507,7 @@ unsigned int Cedrus::XIDDevice::GetMappedSignals(unsigned int line)
 
 void Cedrus::XIDDevice::MapSignals(unsigned int line, unsigned int map)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MAPPED_SIGNALS))
         return;
 
     std::stringstream stream;
@@ -499,13 +529,12 @@ void Cedrus::XIDDevice::MapSignals(unsigned int line, unsigned int map)
     map_signals_cmd[9] = string_mask[6];
     map_signals_cmd[10] = string_mask[7];
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(map_signals_cmd, 11, &bytes_written);
+    WriteSetting(map_signals_cmd, 11, 4);
 }
 
 void Cedrus::XIDDevice::ResetMappedLinesToDefault()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MAPPED_SIGNALS))
         return;
 
     static unsigned char rmltd_cmd[3] = { 'a','t','X' };
@@ -513,6 +542,8 @@ void Cedrus::XIDDevice::ResetMappedLinesToDefault()
     DWORD bytes_written = 0;
     m_xidCon->Write(rmltd_cmd, 3, &bytes_written);
 
+    ForgetProperty("_at");
+
     if (m_config->IsMPod())
     {
         if (m_config->GetModelID() == 72) // Neuroscan 16-bit
@@ -530,10 +561,18 @@ void Cedrus::XIDDevice::ResetMappedLinesToDefault()
     }
 }
 
-void Cedrus::XIDDevice::CommitLineMappingToFlash()
+bool Cedrus::XIDDevice::CommitLineMappingToFlash()
 {
-    if (!m_config->IsXID2())
-        return;
+    if (!Supports(CMD_LINE_MAPPING_COMMIT))
+        return false;
+
+    // 0 when the device can't report it, in which case we always commit.
+    // The CRC it's compared with is the one this object last committed, not
+    // anything read from flash.
+    const unsigned int table_crc = GetTranslationTableCRC();
+
+    if (table_crc != 0 && m_committedLineMappingCRCKnown && table_crc == m_committedLineMappingCRC)
+        return true;
 
     static unsigned char commit_map_cmd[2] = { 'a','f' };
 
@@ -541,35 +580,51 @@ void Cedrus::XIDDevice::CommitLineMappingToFlash()
     m_xidCon->Write ( commit_map_cmd, 2, &bytes_written, SAVES_TO_FLASH );
 
     SLEEP_FUNC(50 * SLEEP_INC);
+
+    m_committedLineMappingCRC = table_crc;
+    m_committedLineMappingCRCKnown = bytes_written == 2 && table_crc != 0;
+
+    // _ac reports the table in RAM, which af doesn't change, and nothing
+    // reads back what's in flash, so all that can be checked is the write.
+    return bytes_written == 2;
 }
 
 int Cedrus::XIDDevice::GetVKDropDelay() const
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_VK_DROP_DELAY))
         return INVALID_RETURN_VALUE;
 
     unsigned char vk_drop_delay[4];
 
-    m_xidCon->SendXIDCommand("_b3", 4, vk_drop_delay, sizeof(vk_drop_delay));
+    QueryProperty("_b3", 4, vk_drop_delay, sizeof(vk_drop_delay));
 
     return vk_drop_delay[3];
 }
 
 void Cedrus::XIDDevice::SetVKDropDelay(unsigned char delay)
 {
-    if (!m_config->IsXID1InputDevice())
+    if (!Supports(CMD_VK_DROP_DELAY))
         return;
 
     static unsigned char svkdd_cmd[3] = { 'b','3' };
     svkdd_cmd[2] = delay;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(svkdd_cmd, 3, &bytes_written);
+    WriteSetting(svkdd_cmd, 3, 3);
 }
 
 std::string Cedrus::XIDDevice::GetProtocol() const
 {
-    return GetProtocol_Scan(m_xidCon);
+    unsigned char return_info[5];
+
+    if (FindCachedProperty("_c1", return_info, sizeof(return_info)) == sizeof(return_info))
+        return std::string((char*)return_info, sizeof(return_info));
+
+    std::string protocol = GetProtocol_Scan(m_xidCon);
+
+    if (protocol.compare(0, 4, "_xid") == 0)
+        m_propertyCache["_c1"] = protocol;
+
+    return protocol;
 }
 
 /*static*/ std::string Cedrus::XIDDevice::GetProtocol_Scan(std::shared_ptr<Connection> xidCon)
@@ -597,6 +652,8 @@ it will at least zero our buffer");
 
 void Cedrus::XIDDevice::SetProtocol(unsigned char protocol)
 {
+    ForgetProperty("_c1");
+
     return SetProtocol_Scan(m_xidCon, protocol);
 }
 
@@ -611,11 +668,11 @@ void Cedrus::XIDDevice::SetProtocol_Scan(std::shared_ptr<Connection> xidCon, uns
 
 unsigned int Cedrus::XIDDevice::GetKBModeProtocol() const
 {
-    if (!(m_config->IsRBx40() || m_config->IsLumina3G()))
+    if (!Supports(CMD_KB_MODE_PROTOCOL))
         return static_cast<unsigned int> (INVALID_RETURN_VALUE);
 
     unsigned char return_info[4];
-    m_xidCon->SendXIDCommand("_c2", 3, return_info, sizeof(return_info));
+    QueryProperty("_c2", 3, return_info, sizeof(return_info));
 
 
     return return_info[3] - '0';
@@ -623,34 +680,35 @@ unsigned int Cedrus::XIDDevice::GetKBModeProtocol() const
 
 void Cedrus::XIDDevice::SetKBModeProtocol(unsigned char mode)
 {
-    if (!(m_config->IsRBx40() || m_config->IsLumina3G()))
+    if (!Supports(CMD_KB_MODE_PROTOCOL))
         return;
 
     static unsigned char sacm_cmd[3] = { 'c','2' };
     sacm_cmd[2] = mode + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(sacm_cmd, 3, &bytes_written);
+    WriteSetting(sacm_cmd, 3, 3);
 }
 
 void Cedrus::XIDDevice::SwitchToKeyboardMode()
 {
-    if (!(m_config->IsLumina3G() || m_config->IsRBx40()))
+    if (!Supports(CMD_KEYBOARD_MODE))
         return;
 
     static unsigned char stkm_cmd[2] = { 'c', '3' };
 
     DWORD bytes_written = 0;
     m_xidCon->Write(stkm_cmd, 2, &bytes_written);
+
+    ForgetProperty("_c1");
 }
 
 unsigned char Cedrus::XIDDevice::GetCPodInputMode() const
 {
-    if (!m_config->IsCPodWithInput())
+    if (!Supports(CMD_CPOD_INPUT_MODE))
         return '0';
 
     unsigned char return_info[4];
-    m_xidCon->SendXIDCommand("_c4", 3, return_info, sizeof(return_info));
+    QueryProperty("_c4", 3, return_info, sizeof(return_info));
 
 
     return return_info[3];
@@ -658,14 +716,13 @@ unsigned char Cedrus::XIDDevice::GetCPodInputMode() const
 
 void Cedrus::XIDDevice::SetCPodInputMode(unsigned char mode)
 {
-    if (!m_config->IsCPodWithInput())
+    if (!Supports(CMD_CPOD_INPUT_MODE))
         return;
 
     static unsigned char scpim_cmd[3] = { 'c','4' };
     scpim_cmd[2] = mode; // 'p' for polled, 't' for timestamped
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(scpim_cmd, 3, &bytes_written);
+    WriteSetting(scpim_cmd, 3, 3);
 }
 
 std::string Cedrus::XIDDevice::GetCombinedInfo() const
@@ -673,7 +730,8 @@ std::string Cedrus::XIDDevice::GetCombinedInfo() const
     m_xidCon->SetReadTimeout(100);
 
     unsigned char return_info[1000];
-    m_xidCon->SendXIDCommand("_d0", 3, return_info, sizeof(return_info));
+    // Names vary in length, so any reply at all is worth remembering.
+    QueryProperty("_d0", 3, return_info, sizeof(return_info), 1);
 
     m_xidCon->SetReadTimeout(50);
 
@@ -689,7 +747,8 @@ std::string Cedrus::XIDDevice::GetInternalProductName() const
     m_xidCon->SetReadTimeout(100);
 
     unsigned char return_info[100];
-    m_xidCon->SendXIDCommand("_d1", 3, return_info, sizeof(return_info));
+    // Names vary in length, so any reply at all is worth remembering.
+    QueryProperty("_d1", 3, return_info, sizeof(return_info), 1);
 
     m_xidCon->SetReadTimeout(50);
 
@@ -702,12 +761,20 @@ std::string Cedrus::XIDDevice::GetInternalProductName() const
 
 int Cedrus::XIDDevice::GetProductID() const
 {
-    return XIDDevice::GetProductID_Scan(m_xidCon);
+    unsigned char product_id_return[1];
+
+    QueryProperty("_d2", 3, product_id_return, sizeof(product_id_return));
+
+    return (int)(product_id_return[0]);
 }
 
 int Cedrus::XIDDevice::GetModelID() const
 {
-    return XIDDevice::GetModelID_Scan(m_xidCon);
+    unsigned char model_id_return[1];
+
+    QueryProperty("_d3", 3, model_id_return, sizeof(model_id_return));
+
+    return (int)(model_id_return[0]);
 }
 
 /*static*/ int Cedrus::XIDDevice::GetProductID_Scan(std::shared_ptr<Connection> xidCon)
@@ -740,6 +807,8 @@ void Cedrus::XIDDevice::SetModelID(unsigned char model)
     DWORD bytes_written = 0;
     m_xidCon->Write ( (unsigned char*)set_model_cmd, 3, &bytes_written, SAVES_TO_FLASH );
 
+    ClearPropertyCache();
+
     SLEEP_FUNC(250 * SLEEP_INC);
 
     if (!m_config->IsMPod())
@@ -783,7 +852,13 @@ void Cedrus::XIDDevice::SetModelID(unsigned char model)
 
 int Cedrus::XIDDevice::GetMajorFirmwareVersion() const
 {
-    return GetMajorFirmwareVersion_Scan(m_xidCon);
+    unsigned char major_return[1];
+
+    QueryProperty("_d4", 3, major_return, sizeof(major_return));
+
+    bool return_valid = (major_return[0] >= 48 && major_return[0] <= 50);
+
+    return return_valid ? major_return[0] - '0' : INVALID_RETURN_VALUE;
 }
 
 /*static*/ int Cedrus::XIDDevice::GetMajorFirmwareVersion_Scan(std::shared_ptr<Connection> xidCon)
@@ -801,7 +876,7 @@ int Cedrus::XIDDevice::GetMinorFirmwareVersion() const
 {
     unsigned char minor_return[1];
 
-    m_xidCon->SendXIDCommand("_d5", 3, minor_return, sizeof(minor_return));
+    QueryProperty("_d5", 3, minor_return, sizeof(minor_return));
 
     bool return_valid = minor_return[0] >= 48;
 
@@ -810,12 +885,12 @@ int Cedrus::XIDDevice::GetMinorFirmwareVersion() const
 
 int Cedrus::XIDDevice::GetOutpostModel() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_OUTPOST_MODEL))
         return INVALID_RETURN_VALUE;
 
     unsigned char outpost_return[1];
 
-    m_xidCon->SendXIDCommand("_d6", 3, outpost_return, sizeof(outpost_return));
+    QueryProperty("_d6", 3, outpost_return, sizeof(outpost_return));
 
     bool return_valid = (outpost_return[0] >= 48 && outpost_return[0] <= 52) || outpost_return[0] == 'x';
 
@@ -824,25 +899,28 @@ int Cedrus::XIDDevice::GetOutpostModel() const
 
 int Cedrus::XIDDevice::GetHardwareGeneration() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_HARDWARE_GENERATION))
         return INVALID_RETURN_VALUE;
 
     unsigned char gen_return[1];
 
-    m_xidCon->SendXIDCommand("_d7", 3, gen_return, sizeof(gen_return));
+    QueryProperty("_d7", 3, gen_return, sizeof(gen_return));
 
     return gen_return[0] - '0';
 }
 
 void Cedrus::XIDDevice::ResetBaseTimer()
 {
+    if (!Supports(CMD_BASE_TIMER))
+        return;
+
     DWORD bytes_written = 0;
     m_xidCon->Write((unsigned char*)"e1", 2, &bytes_written);
 }
 
 unsigned int Cedrus::XIDDevice::QueryBaseTimer()
 {
-    if (!m_config->IsXID1())
+    if (!Supports(CMD_BASE_TIMER))
         return 0;
 
     unsigned int base_timer = 0;
@@ -866,7 +944,7 @@ unsigned int Cedrus::XIDDevice::QueryBaseTimer()
 
 unsigned int Cedrus::XIDDevice::QueryRtTimer()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_RT_TIMER))
         return 0;
 
     static char qrt_command[3] = { '_', 'e','5' };
@@ -885,11 +963,109 @@ unsigned int Cedrus::XIDDevice::QueryRtTimer()
 
 void Cedrus::XIDDevice::ResetRtTimer()
 {
-    if (m_config->IsStimTracker1())
+    if (!Supports(CMD_RESET_RT_TIMER))
         return;
 
     DWORD bytes_written = 0;
     m_xidCon->Write((unsigned char*)"e5", 2, &bytes_written);
+
+    const std::chrono::steady_clock::time_point reset_time = m_xidCon->GetLastWriteTime();
+    if (m_ResponseMgr)
+        m_ResponseMgr->ResetDeviceTimeline(reset_time);
+    m_clockTimeline.Reset(reset_time);
+    m_deviceClock.Reset();
+    if (m_ResponseMgr)
+        m_ResponseMgr->SetDeviceClockModel(m_deviceClock);
+}
+
+bool Cedrus::XIDDevice::SampleDeviceClock()
+{
+    if (!Supports(CMD_RT_TIMER))
+        return false;
+
+    static char qrt_command[3] = { '_', 'e','5' };
+    unsigned char return_info[7];
+
+    // SendXIDCommand() reads until its timeout, which would swamp the timing,
+    // so this reads exactly the size of the reply instead.
+    std::unique_lock<std::recursive_mutex> io_lock = m_xidCon->LockIO();
+
+    // Responses nobody has read yet go to the queue rather than being
+    // flushed along with anything else that's waiting.
+    if (m_ResponseMgr)
+        m_ResponseMgr->CheckForKeypress(m_xidCon);
+
+    m_xidCon->FlushReadFromDeviceBuffer();
+
+    DWORD bytes_written = 0;
+    m_xidCon->Write((unsigned char*)qrt_command, 3, &bytes_written);
+
+    DWORD bytes_read = 0;
+    m_xidCon->Read(return_info, sizeof(return_info), &bytes_read);
+
+    const std::chrono::steady_clock::time_point received = std::chrono::steady_clock::now();
+    const std::chrono::steady_clock::time_point sent = m_xidCon->GetLastWriteTime();
+
+    if (bytes_read != sizeof(return_info) || memcmp(return_info, qrt_command, 3) != 0)
+    {
+        // Most likely responses came in ahead of the reply. They go to the
+        // parser, but the reply mustn't: its timer bytes can pass for a
+        // response. Whatever of it has come in is moved to the front, and
+        // the rest read and thrown away with it.
+        DWORD held = bytes_read;
+        for (;;)
+        {
+            DWORD reply_start = 0;
+            while (reply_start < held &&
+                memcmp(return_info + reply_start, qrt_command, std::min<DWORD>(3, held - reply_start)) != 0)
+                ++reply_start;
+
+            if (m_ResponseMgr && reply_start > 0)
+                m_ResponseMgr->FeedInput(return_info, reply_start, std::chrono::steady_clock::now());
+
+            held -= reply_start;
+            memmove(return_info, return_info + reply_start, held);
+            if (held == sizeof(return_info))
+                break;
+
+            bytes_read = 0;
+            m_xidCon->Read(return_info + held, sizeof(return_info) - held, &bytes_read);
+            if (bytes_read == 0)
+                break;
+
+            held += bytes_read;
+        }
+
+        if (m_ResponseMgr)
+            m_ResponseMgr->CheckForKeypress(m_xidCon);
+
+        return false;
+    }
+
+    const unsigned int timer = AdjustEndiannessCharsToUint(
+        return_info[3],
+        return_info[4],
+        return_info[5],
+        return_info[6]);
+
+    // The timer was read somewhere between the query going out and the
+    // reply coming back.
+    const std::chrono::microseconds half_round_trip = std::chrono::duration_cast<std::chrono::microseconds>(received - sent) / 2;
+    m_deviceClock.AddSample(m_clockTimeline.Extend(timer, sent + half_round_trip), sent + half_round_trip, half_round_trip);
+    if (m_ResponseMgr)
+        m_ResponseMgr->SetDeviceClockModel(m_deviceClock);
+
+    return true;
+}
+
+bool Cedrus::XIDDevice::DeviceTimeToHostTime(long long deviceTimeMs, std::chrono::steady_clock::time_point & hostTime, std::chrono::microseconds & errorBound) const
+{
+    return m_deviceClock.DeviceToHost(deviceTimeMs, hostTime, errorBound);
+}
+
+const Cedrus::DeviceClockModel & Cedrus::XIDDevice::GetDeviceClockModel() const
+{
+    return m_deviceClock;
 }
 
 void Cedrus::XIDDevice::SetBaudRate(unsigned char rate)
@@ -908,62 +1084,68 @@ void Cedrus::XIDDevice::SetBaudRate(unsigned char rate)
     OpenConnection();
 }
 
-void Cedrus::XIDDevice::GetLockingLevel()
+int Cedrus::XIDDevice::GetLockingLevel() const
 {
-    DWORD bytes_written = 0;
-    m_xidCon->Write((unsigned char*)"_f2", 3, &bytes_written);
+    if (!Supports(CMD_LOCKING_LEVEL))
+        return INVALID_RETURN_VALUE;
+
+    unsigned char return_info[4];
+
+    QueryProperty("_f2", 3, return_info, sizeof(return_info));
+
+    return return_info[3] - '0';
 }
 
 void Cedrus::XIDDevice::SetLockingLevel(unsigned char level)
 {
-    if (!m_config->IsXID1())
+    if (!Supports(CMD_LOCKING_LEVEL))
         return;
 
     static unsigned char set_level_cmd[3] = { 'f', '2' };
     set_level_cmd[2] = level + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(set_level_cmd, 3, &bytes_written);
+    WriteSetting(set_level_cmd, 3, 3);
 }
 
 void Cedrus::XIDDevice::ReprogramFlash()
 {
     DWORD bytes_written = 0;
     m_xidCon->Write((unsigned char*)"f3", 2, &bytes_written);
+
+    ClearPropertyCache();
 }
 
 bool Cedrus::XIDDevice::GetTriggerDefault() const
 {
-    if (!m_config->IsLumina())
+    if (!Supports(CMD_TRIGGER_DEFAULT))
         return false;
 
     unsigned char default_return[4];
 
-    m_xidCon->SendXIDCommand("_f4", 3, default_return, sizeof(default_return));
+    QueryProperty("_f4", 3, default_return, sizeof(default_return));
 
     return default_return[3] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::SetTriggerDefault(bool defaultOn)
 {
-    if (!m_config->IsLumina())
+    if (!Supports(CMD_TRIGGER_DEFAULT))
         return;
 
     static unsigned char set_trigger_default_cmd[3] = { 'f', '4' };
     set_trigger_default_cmd[2] = (unsigned char)defaultOn + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(set_trigger_default_cmd, 3, &bytes_written);
+    WriteSetting(set_trigger_default_cmd, 3, 3);
 }
 
 int Cedrus::XIDDevice::GetTriggerDebounceTime() const
 {
-    if (!m_config->IsLumina())
+    if (!Supports(CMD_TRIGGER_DEBOUNCE_TIME))
         return 0;
 
     unsigned char threshold_return[4]; // we rely on SendXIDCommand to zero-initialize this buffer
 
-    m_xidCon->SendXIDCommand("_f5", 3, threshold_return, sizeof(threshold_return));
+    QueryProperty("_f5", 3, threshold_return, sizeof(threshold_return));
 
     bool return_valid = strncmp((char*)threshold_return, "_f5", 3) == 0;
 
@@ -975,24 +1157,23 @@ int Cedrus::XIDDevice::GetTriggerDebounceTime() const
 
 void Cedrus::XIDDevice::SetTriggerDebounceTime(unsigned char time)
 {
-    if (!m_config->IsLumina())
+    if (!Supports(CMD_TRIGGER_DEBOUNCE_TIME))
         return;
 
     static unsigned char set_debouncing_time_cmd[3] = { 'f', '5' };
     set_debouncing_time_cmd[2] = time;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(set_debouncing_time_cmd, 3, &bytes_written);
+    WriteSetting(set_debouncing_time_cmd, 3, 3);
 }
 
 int Cedrus::XIDDevice::GetButtonDebounceTime() const
 {
-    if (!m_config->IsLumina() && !m_config->IsRB())
+    if (!Supports(CMD_BUTTON_DEBOUNCE_TIME))
         return INVALID_RETURN_VALUE;
 
     unsigned char threshold_return[4]; // we rely on SendXIDCommand to zero-initialize this buffer
 
-    m_xidCon->SendXIDCommand("_f6", 3, threshold_return, sizeof(threshold_return));
+    QueryProperty("_f6", 3, threshold_return, sizeof(threshold_return));
 
     bool return_valid = strncmp((char*)threshold_return, "_f6", 3) == 0;
 
@@ -1004,14 +1185,13 @@ int Cedrus::XIDDevice::GetButtonDebounceTime() const
 
 void Cedrus::XIDDevice::SetButtonDebounceTime(unsigned char time)
 {
-    if (!m_config->IsLumina() && !m_config->IsRB())
+    if (!Supports(CMD_BUTTON_DEBOUNCE_TIME))
         return;
 
     static unsigned char set_debouncing_time_cmd[3] = { 'f', '6' };
     set_debouncing_time_cmd[2] = time;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(set_debouncing_time_cmd, 3, &bytes_written);
+    WriteSetting(set_debouncing_time_cmd, 3, 3);
 }
 
 void Cedrus::XIDDevice::RestoreFactoryDefaults()
@@ -1019,6 +1199,8 @@ void Cedrus::XIDDevice::RestoreFactoryDefaults()
     DWORD bytes_written = 0;
     m_xidCon->Write((unsigned char*)"f7", 2, &bytes_written);
 
+    ClearPropertyCache();
+
     SLEEP_FUNC(100 * SLEEP_INC);
 
     if (m_config->IsMPod())
@@ -1040,16 +1222,18 @@ void Cedrus::XIDDevice::RestoreFactoryDefaults()
     }
 }
 
-void Cedrus::XIDDevice::SaveSettingsToFlash()
+bool Cedrus::XIDDevice::SaveSettingsToFlash()
 {
     DWORD bytes_written = 0;
     m_xidCon->Write((unsigned char*)"f9", 2, &bytes_written);
     SLEEP_FUNC(50 * SLEEP_INC);
+
+    return bytes_written == 2;
 }
 
 unsigned int Cedrus::XIDDevice::GetTimeSinceLastOscillatorTest ()
 {
-    if ( !m_config->IsCPod () )
+    if (!Supports(CMD_OSCILLATOR_TEST))
         return 0;
 
     static char time_since_osc_cmd[3] = { '_', 'f','a' };
@@ -1068,7 +1252,7 @@ unsigned int Cedrus::XIDDevice::GetTimeSinceLastOscillatorTest ()
 
 void Cedrus::XIDDevice::StartOscillatorTest (bool start)
 {
-    if ( !m_config->IsCPod () )
+    if (!Supports(CMD_OSCILLATOR_TEST))
         return;
 
     static unsigned char start_osc_test_cmd[3] = { 'f','a' };
@@ -1080,7 +1264,7 @@ void Cedrus::XIDDevice::StartOscillatorTest (bool start)
 
 void Cedrus::XIDDevice::SetAdjustmentValue ( char adj )
 {
-    if ( !m_config->IsCPod () )
+    if (!Supports(CMD_OSCILLATOR_TEST))
         return;
 
     static unsigned char set_adj_val_cmd[3] = { 'f','b' };
@@ -1092,7 +1276,7 @@ void Cedrus::XIDDevice::SetAdjustmentValue ( char adj )
 
 void Cedrus::XIDDevice::SetAdjustmentFlag (bool testConducted)
 {
-    if (!m_config->IsCPod ())
+    if (!Supports(CMD_OSCILLATOR_TEST))
         return;
 
     static unsigned char set_adj_flag_cmd[3] = { 'f','c' };
@@ -1104,7 +1288,7 @@ void Cedrus::XIDDevice::SetAdjustmentFlag (bool testConducted)
 
 bool Cedrus::XIDDevice::IsOpticalIsolationSwitchOn() const
 {
-    if (!m_config->IsLumina3G())
+    if (!Supports(CMD_OPTICAL_ISOLATION_SWITCH))
         return false;
 
     unsigned char cmd_return[4];
@@ -1116,7 +1300,7 @@ bool Cedrus::XIDDevice::IsOpticalIsolationSwitchOn() const
 
 Cedrus::SingleShotMode Cedrus::XIDDevice::GetSingleShotMode(unsigned char selector) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_SINGLE_SHOT_MODE))
         return SingleShotMode();
 
     static char gssm_command[4] = { '_','i','a' };
@@ -1124,7 +1308,7 @@ Cedrus::SingleShotMode Cedrus::XIDDevice::GetSingleShotMode(unsigned char select
     gssm_command[3] = selector;
 
     unsigned char return_info[9];
-    m_xidCon->SendXIDCommand(gssm_command, 4, return_info, sizeof(return_info));
+    QueryProperty(gssm_command, 4, return_info, sizeof(return_info));
 
     SingleShotMode ss_mode;
     ss_mode.enabled = return_info[4] == '1';
@@ -1140,7 +1324,7 @@ Cedrus::SingleShotMode Cedrus::XIDDevice::GetSingleShotMode(unsigned char select
 
 void Cedrus::XIDDevice::SetSingleShotMode(unsigned char selector, bool enable, unsigned int delay)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_SINGLE_SHOT_MODE))
         return;
 
     static unsigned char sssm_cmd[8] = { 'i','a' };
@@ -1154,13 +1338,12 @@ void Cedrus::XIDDevice::SetSingleShotMode(unsigned char selector, bool enable, u
         &(sssm_cmd[6]),
         &(sssm_cmd[7]));
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(sssm_cmd, 8, &bytes_written);
+    WriteSetting(sssm_cmd, 8, 4);
 }
 
 unsigned char Cedrus::XIDDevice::GetCPodInputLines() const
 {
-    if (!m_config->IsCPodWithInput())
+    if (!Supports(CMD_CPOD_INPUT_LINES))
         return '0';
 
     unsigned char return_info[4];
@@ -1171,7 +1354,7 @@ unsigned char Cedrus::XIDDevice::GetCPodInputLines() const
 
 Cedrus::SignalFilter Cedrus::XIDDevice::GetSignalFilter(unsigned char selector) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_SIGNAL_FILTER))
         return SignalFilter();
 
     static char gsf_command[4] = { '_','i','f' };
@@ -1179,7 +1362,7 @@ Cedrus::SignalFilter Cedrus::XIDDevice::GetSignalFilter(unsigned char selector)
     gsf_command[3] = selector;
 
     unsigned char return_info[12];
-    m_xidCon->SendXIDCommand(gsf_command, 4, return_info, sizeof(return_info));
+    QueryProperty(gsf_command, 4, return_info, sizeof(return_info));
 
     SignalFilter filter;
     filter.holdOn = AdjustEndiannessCharsToUint(
@@ -1199,7 +1382,7 @@ Cedrus::SignalFilter Cedrus::XIDDevice::GetSignalFilter(unsigned char selector)
 
 void Cedrus::XIDDevice::SetSignalFilter(unsigned char selector, unsigned int holdOn, unsigned int holdOff)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_SIGNAL_FILTER))
         return;
 
     static unsigned char ssf_cmd[11] = { 'i','f' };
@@ -1219,56 +1402,53 @@ void Cedrus::XIDDevice::SetSignalFilter(unsigned char selector, unsigned int hol
         &(ssf_cmd[9]),
         &(ssf_cmd[10]));
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(ssf_cmd, 11, &bytes_written);
+    WriteSetting(ssf_cmd, 11, 4);
 }
 
 bool Cedrus::XIDDevice::IsKbAutorepeatOn() const
 {
-    if (!(m_config->IsRBx40() || m_config->IsLumina3G()) || m_curMinorFwVer < 21)
+    if (!Supports(CMD_KB_AUTOREPEAT))
         return false;
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_ig", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_ig", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::EnableKbAutorepeat(bool pause)
 {
-    if (!(m_config->IsRBx40() || m_config->IsLumina3G()) || m_curMinorFwVer < 21)
+    if (!Supports(CMD_KB_AUTOREPEAT))
         return;
 
     static unsigned char enable_kb_autorepeat_cmd[3] = { 'i','g' };
     enable_kb_autorepeat_cmd[2] = pause ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( enable_kb_autorepeat_cmd, 3, &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(enable_kb_autorepeat_cmd, 3, 3, SAVES_TO_FLASH);
 }
 
 bool Cedrus::XIDDevice::IsRBx40LEDEnabled() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_LED_FUNCTION))
         return false;
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_il", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_il", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::EnableRBx40LED(bool enable)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_LED_FUNCTION))
         return;
 
     static unsigned char enable_rb_led_cmd[3] = { 'i','l' };
     enable_rb_led_cmd[2] = enable ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( enable_rb_led_cmd, 3, &bytes_written );
+    WriteSetting(enable_rb_led_cmd, 3, 3);
 
     SLEEP_FUNC(50 * SLEEP_INC);
 }
@@ -1276,12 +1456,12 @@ void Cedrus::XIDDevice::EnableRBx40LED(bool enable)
 
 unsigned int Cedrus::XIDDevice::GetRipondaLEDFunction() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_LED_FUNCTION))
         return false;
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_il", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_il", 3, cmd_return, sizeof(cmd_return));
 
     return static_cast<unsigned int> ( cmd_return[3] );
 }
@@ -1291,22 +1471,21 @@ void Cedrus::XIDDevice::SetRipondaLEDFunction ( unsigned int nFunction )
 {
     CEDRUS_ASSERT ( nFunction >= LED_OFF && nFunction <= LED_FOR_VOICE_KEY, "Invalid Riponda LED parameter!" );
 
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_LED_FUNCTION))
         return;
     
     static unsigned char enable_rb_led_cmd[3] = { 'i','l' };
     enable_rb_led_cmd[2] = static_cast<unsigned char> ( nFunction );
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( enable_rb_led_cmd, 3, &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(enable_rb_led_cmd, 3, 3, SAVES_TO_FLASH);
 
-    SLEEP_FUNC(50 * SLEEP_INC);
+    SettleAfterSetting();
 }
 
 
 bool Cedrus::XIDDevice::GetEnableDigitalOutput(unsigned char selector) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_DIGITAL_OUTPUT))
         return false;
 
     unsigned char return_info[5];
@@ -1314,78 +1493,75 @@ bool Cedrus::XIDDevice::GetEnableDigitalOutput(unsigned char selector) const
     static char gtso_command[4] = { '_','i','o' };
     gtso_command[3] = selector;
 
-    m_xidCon->SendXIDCommand(gtso_command, 4, return_info, sizeof(return_info));
+    QueryProperty(gtso_command, 4, return_info, sizeof(return_info));
 
     return return_info[4] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::SetEnableDigitalOutput(unsigned char selector, bool mode)
 {
-    if (!m_config->IsStimTracker2())
+    if (!Supports(CMD_SET_DIGITAL_OUTPUT))
         return;
 
     static unsigned char stso_command[4] = { 'i','o' };
     stso_command[2] = selector;
     stso_command[3] = mode ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(stso_command, 4, &bytes_written);
+    WriteSetting(stso_command, 4, 4);
 }
 
 bool Cedrus::XIDDevice::IsOutputPaused() const
 {
-    if (!m_config->IsXID2InputDevice() || m_curMinorFwVer < 21)
+    if (!Supports(CMD_OUTPUT_PAUSE))
         return false;
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_ip", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_ip", 3, cmd_return, sizeof(cmd_return));
 
     return cmd_return[3] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::PauseAllOutput(bool pause)
 {
-    if (!m_config->IsXID2InputDevice() || m_curMinorFwVer < 21)
+    if (!Supports(CMD_OUTPUT_PAUSE))
         return;
 
     static unsigned char pause_output_cmd[3] = { 'i','p' };
     pause_output_cmd[2] = !pause ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(pause_output_cmd, 3, &bytes_written);
+    WriteSetting(pause_output_cmd, 3, 3);
 }
 
 int Cedrus::XIDDevice::GetTimerResetOnOnsetMode(unsigned char selector) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_TIMER_RESET_ON_ONSET))
         return INVALID_RETURN_VALUE;
 
     static char gtrom_command[4] = {'_','i','r'};
     gtrom_command[3] = selector;
 
     unsigned char return_info[5];
-    m_xidCon->SendXIDCommand(gtrom_command, 4, return_info, sizeof(return_info));
+    QueryProperty(gtrom_command, 4, return_info, sizeof(return_info));
 
     return strncmp((char*)return_info, "_ir", 3) == 0 ? return_info[4] - '0' : INVALID_RETURN_VALUE;
 }
 
 void Cedrus::XIDDevice::SetTimerResetOnOnsetMode(unsigned char selector, unsigned char mode)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_TIMER_RESET_ON_ONSET))
         return;
 
     static unsigned char change_mode_cmd[4] = { 'i','r' };
     change_mode_cmd[2] = selector;
     change_mode_cmd[3] = mode + '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(change_mode_cmd, 4, &bytes_written);
+    WriteSetting(change_mode_cmd, 4, 4);
 }
 
 bool Cedrus::XIDDevice::GetEnableUSBOutput(unsigned char selector) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_USB_OUTPUT))
         return false;
 
     // c-pod don't respond to this command, which is generally fine, as they
@@ -1402,73 +1578,70 @@ bool Cedrus::XIDDevice::GetEnableUSBOutput(unsigned char selector) const
     static char geuo_command[4] = { '_','i','u' };
     geuo_command[3] = selector;
 
-    m_xidCon->SendXIDCommand(geuo_command, 4, return_info, sizeof(return_info));
+    QueryProperty(geuo_command, 4, return_info, sizeof(return_info));
 
     return return_info[4] == '1' ? true : false;
 }
 
 void Cedrus::XIDDevice::SetEnableUSBOutput(unsigned char selector, bool mode)
 {
-    if (!m_config->IsStimTracker2())
+    if (!Supports(CMD_SET_USB_OUTPUT))
         return;
 
     static unsigned char seuo_command[4] = { 'i','u' };
     seuo_command[2] = selector;
     seuo_command[3] = mode ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(seuo_command, 4, &bytes_written);
+    WriteSetting(seuo_command, 4, 4);
 }
 
 int Cedrus::XIDDevice::GetAnalogInputThreshold(unsigned char selector) const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_ANALOG_INPUT_THRESHOLD))
         return INVALID_RETURN_VALUE;
 
     unsigned char cmd_return[5];
     static char gait_command[4] = { '_','i','t' };
     gait_command[3] = selector;
 
-    m_xidCon->SendXIDCommand(gait_command, 4, cmd_return, sizeof(cmd_return));
+    QueryProperty(gait_command, 4, cmd_return, sizeof(cmd_return));
 
     return strncmp((char*)cmd_return, "_it", 3) == 0 ? (int)(cmd_return[4]) : INVALID_RETURN_VALUE;
 }
 
 void Cedrus::XIDDevice::SetAnalogInputThreshold(unsigned char selector, unsigned char threshold)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_ANALOG_INPUT_THRESHOLD))
         return;
 
     static unsigned char change_threshold_cmd[4] = { 'i','t' };
     change_threshold_cmd[2] = selector;
     change_threshold_cmd[3] = threshold;
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(change_threshold_cmd, 4, &bytes_written);
+    WriteSetting(change_threshold_cmd, 4, 4);
 }
 
 int Cedrus::XIDDevice::GetMixedInputMode() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MIXED_INPUT_MODE))
         return INVALID_RETURN_VALUE;
 
     unsigned char cmd_return[4];
 
-    m_xidCon->SendXIDCommand("_iv", 3, cmd_return, sizeof(cmd_return));
+    QueryProperty("_iv", 3, cmd_return, sizeof(cmd_return));
 
     return strncmp((char*)cmd_return, "_iv", 3) == 0 ? (int)(cmd_return[3]) - '0' : INVALID_RETURN_VALUE;
 }
 
 void Cedrus::XIDDevice::SetMixedInputMode(unsigned char mode)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_MIXED_INPUT_MODE))
         return;
 
     static unsigned char change_threshold_cmd[3] = { 'i','v' };
     change_threshold_cmd[2] = mode ? '1' : '0';
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write(change_threshold_cmd, 3, &bytes_written);
+    WriteSetting(change_threshold_cmd, 3, 3);
 }
 
 unsigned int Cedrus::XIDDevice::GetRaisedLines() const
@@ -1489,32 +1662,34 @@ unsigned int Cedrus::XIDDevice::GetRaisedLines() const
 
 unsigned int Cedrus::XIDDevice::GetNumberOfLines() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_NUMBER_OF_LINES))
         return 0;
 
     unsigned char gen_return[4];
 
-    m_xidCon->SendXIDCommand("_ml", 3, gen_return, sizeof(gen_return));
+    QueryProperty("_ml", 3, gen_return, sizeof(gen_return));
 
     return gen_return[3];
 }
 
 void Cedrus::XIDDevice::SetNumberOfLines(unsigned int lines)
 {
+    if (!Supports(CMD_NUMBER_OF_LINES))
+        return;
+
     static unsigned char set_number_of_lines_cmd[3] = { 'm','l' };
     set_number_of_lines_cmd[2] = static_cast<unsigned char> (lines);
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( (unsigned char*)set_number_of_lines_cmd, 3, &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(set_number_of_lines_cmd, 3, 3, SAVES_TO_FLASH);
 }
 
 unsigned int Cedrus::XIDDevice::GetPulseDuration() const
 {
-    if (m_config->IsXID1InputDevice() || m_config->IsMPod())
+    if (!Supports(CMD_PULSE_DURATION))
         return 0;
 
     unsigned char return_info[7];
-    m_xidCon->SendXIDCommand("_mp", 3, return_info, sizeof(return_info));
+    QueryProperty("_mp", 3, return_info, sizeof(return_info));
 
     CEDRUS_ASSERT(strncmp((char*)return_info, "_mp", 3) == 0, "GetPulseDuration's return value must start with _mp");
 
@@ -1529,7 +1704,7 @@ unsigned int Cedrus::XIDDevice::GetPulseDuration() const
 
 void Cedrus::XIDDevice::SetPulseDuration(unsigned int duration)
 {
-    if ((m_config->IsXID1InputDevice() || m_config->IsMPod()))
+    if (!Supports(CMD_PULSE_DURATION))
         return;
 
     static unsigned char spd_command[6] = { 'm','p' };
@@ -1541,13 +1716,12 @@ void Cedrus::XIDDevice::SetPulseDuration(unsigned int duration)
         &(spd_command[4]),
         &(spd_command[5]));
 
-    DWORD written = 0;
-    m_xidCon->Write ( spd_command, 6, &written, SAVES_TO_FLASH );
+    WriteSetting(spd_command, 6, 3, SAVES_TO_FLASH);
 }
 
 unsigned int Cedrus::XIDDevice::GetPulseTableBitMask()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return 0;
 
     unsigned char return_info[5];
@@ -1562,7 +1736,7 @@ unsigned int Cedrus::XIDDevice::GetPulseTableBitMask()
 
 void Cedrus::XIDDevice::SetPulseTableBitMask(unsigned int lines)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return;
 
     unsigned int mask = lines;
@@ -1578,7 +1752,7 @@ void Cedrus::XIDDevice::SetPulseTableBitMask(unsigned int lines)
 
 void Cedrus::XIDDevice::ClearPulseTable()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return;
 
     DWORD bytes_written = 0;
@@ -1587,7 +1761,7 @@ void Cedrus::XIDDevice::ClearPulseTable()
 
 bool Cedrus::XIDDevice::IsPulseTableRunning() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return false;
 
     unsigned char cmd_return[4];
@@ -1599,7 +1773,7 @@ bool Cedrus::XIDDevice::IsPulseTableRunning() const
 
 void Cedrus::XIDDevice::RunPulseTable()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return;
 
     DWORD bytes_written = 0;
@@ -1608,7 +1782,7 @@ void Cedrus::XIDDevice::RunPulseTable()
 
 void Cedrus::XIDDevice::StopPulseTable()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return;
 
     DWORD bytes_written = 0;
@@ -1617,7 +1791,7 @@ void Cedrus::XIDDevice::StopPulseTable()
 
 void Cedrus::XIDDevice::AddPulseTableEntry(unsigned int time, unsigned int lines)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TABLE))
         return;
 
     static unsigned char apte_cmd[8] = { 'm','t' };
@@ -1640,7 +1814,7 @@ void Cedrus::XIDDevice::AddPulseTableEntry(unsigned int time, unsigned int lines
 
 void Cedrus::XIDDevice::ResetOutputLines()
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_OUTPUT_LINES_RESET))
         return;
 
     DWORD bytes_written = 0;
@@ -1650,26 +1824,25 @@ void Cedrus::XIDDevice::ResetOutputLines()
 
 void Cedrus::XIDDevice::SetVoltageRange ( unsigned int /* nMinimum */, unsigned int nMaximum )
 {
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_VOLTAGE_RANGE))
         return;
 
     static unsigned char set_voltage_range_cmd[4] = { 'v','r' };
     set_voltage_range_cmd[2] = 0;   // Minimum voltage, always 0V for now
     set_voltage_range_cmd[3] = static_cast<unsigned char> (nMaximum);
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( (unsigned char*)set_voltage_range_cmd, sizeof(set_voltage_range_cmd), &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(set_voltage_range_cmd, sizeof(set_voltage_range_cmd), 3, SAVES_TO_FLASH);
 }
 
 
 unsigned int Cedrus::XIDDevice::GetMaxVoltageRange() const
 {
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_VOLTAGE_RANGE))
         return 0;
 
     unsigned char gen_return[5];
 
-    m_xidCon->SendXIDCommand("_vr", 3, gen_return, sizeof(gen_return));
+    QueryProperty("_vr", 3, gen_return, sizeof(gen_return));
 
     return gen_return[4];
 }
@@ -1677,26 +1850,25 @@ unsigned int Cedrus::XIDDevice::GetMaxVoltageRange() const
 
 void Cedrus::XIDDevice::SetVoltageRangeForTesting ( unsigned int /* nMinimum */, unsigned int nMaximum )
 {
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_VOLTAGE_RANGE))
         return;
 
     static unsigned char set_voltage_range_cmd[4] = { 'v','t' };
     set_voltage_range_cmd[2] = 0;   // Minimum voltage, always 0V for now
     set_voltage_range_cmd[3] = static_cast<unsigned char> (nMaximum);
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write((unsigned char*)set_voltage_range_cmd, 4, &bytes_written);
+    WriteSetting(set_voltage_range_cmd, 4, 3);
 }
 
 
 unsigned int Cedrus::XIDDevice::GetMaxVoltageRangeForTesting() const
 {
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_VOLTAGE_RANGE))
         return 0;
 
     unsigned char gen_return[5];
 
-    m_xidCon->SendXIDCommand("_vt", 3, gen_return, sizeof(gen_return));
+    QueryProperty("_vt", 3, gen_return, sizeof(gen_return));
 
     return gen_return[4];
 }
@@ -1706,25 +1878,24 @@ void Cedrus::XIDDevice::SetAnalogOutputMode ( unsigned int mode )
 {
     CEDRUS_ASSERT ( mode == AM_FIXED_DELTA  ||  mode == AM_BINARY, "Invalid parameter sent to SetAnalogOutputMode() !" );
 
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_ANALOG_OUTPUT_MODE))
         return;
 
     static unsigned char set_voltage_range_cmd[3] = { 'v','m' };
     set_voltage_range_cmd[2] = static_cast<unsigned char> (mode);
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( (unsigned char*)set_voltage_range_cmd, sizeof(set_voltage_range_cmd), &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(set_voltage_range_cmd, sizeof(set_voltage_range_cmd), 3, SAVES_TO_FLASH);
 }
 
 
 unsigned int Cedrus::XIDDevice::GetAnalogOutputMode() const
 {
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_ANALOG_OUTPUT_MODE))
         return 0;
 
     unsigned char gen_return[4];
 
-    m_xidCon->SendXIDCommand("_vm", 3, gen_return, sizeof(gen_return));
+    QueryProperty("_vm", 3, gen_return, sizeof(gen_return));
 
     return gen_return[3];
 }
@@ -1734,25 +1905,24 @@ void Cedrus::XIDDevice::SetNumberOfAnalogOutputLevels ( unsigned int numLevels )
 {
     CEDRUS_ASSERT ( numLevels == 8  ||  numLevels == 16, "Number of analog output levels can be ONLY 8 or 16." );
 
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_ANALOG_OUTPUT_LEVELS))
         return;
 
     static unsigned char set_voltage_range_cmd[3] = { 'v','l' };
     set_voltage_range_cmd[2] = static_cast<unsigned char> (numLevels);
 
-    DWORD bytes_written = 0;
-    m_xidCon->Write ( (unsigned char*)set_voltage_range_cmd, sizeof(set_voltage_range_cmd), &bytes_written, SAVES_TO_FLASH );
+    WriteSetting(set_voltage_range_cmd, sizeof(set_voltage_range_cmd), 3, SAVES_TO_FLASH);
 }
 
 
 unsigned int Cedrus::XIDDevice::GetNumberOfAnalogOutputLevels() const
 {
-    if ( !m_config->IsXID2()  ||  GetModelID() != 'V' )
+    if (!Supports(CMD_ANALOG_OUTPUT_LEVELS))
         return 0;
 
     unsigned char gen_return[4];
 
-    m_xidCon->SendXIDCommand("_vl", 3, gen_return, sizeof(gen_return));
+    QueryProperty("_vl", 3, gen_return, sizeof(gen_return));
 
     return gen_return[3];
 }
@@ -1812,7 +1982,7 @@ void Cedrus::XIDDevice::ClearLines()
 
 void Cedrus::XIDDevice::SendPulse(unsigned int duration, unsigned int lines, unsigned int pulses, unsigned int ipi)
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TRAIN))
         return;
 
     static unsigned char send_pulse_cmd[9] = { 'm','x' };
@@ -1840,7 +2010,7 @@ void Cedrus::XIDDevice::SendPulse(unsigned int duration, unsigned int lines, uns
 
 bool Cedrus::XIDDevice::ArePulsesBeingSent() const
 {
-    if (!m_config->IsXID2())
+    if (!Supports(CMD_PULSE_TRAIN))
         return 0;
 
     unsigned char get_pulse_return[4];
@@ -1862,6 +2032,12 @@ std::shared_ptr<const Cedrus::DeviceConfig> Cedrus::XIDDevice::GetDeviceConfig()
 
 int Cedrus::XIDDevice::OpenConnection() const
 {
+    // Nothing remembered from before can be trusted after a reconnect.
+    m_propertyCache.clear();
+    m_committedLineMappingCRCKnown = false;
+    m_firmwareCapabilitiesKnown = false;
+    m_minorFwVerKnown = false;
+
     return m_xidCon->Open();
 }
 
@@ -1875,9 +2051,121 @@ bool Cedrus::XIDDevice::HasLostConnection() const
     return m_xidCon->HasLostConnection();
 }
 
+std::map<std::string, Cedrus::CommandTiming> Cedrus::XIDDevice::GetCommandTimings() const
+{
+    return m_xidCon->GetCommandTimings();
+}
+
+void Cedrus::XIDDevice::ResetCommandTimings()
+{
+    m_xidCon->ResetCommandTimings();
+}
+
+void Cedrus::XIDDevice::SetPropertyCacheBypass(bool bypass)
+{
+    m_bypassPropertyCache = bypass;
+}
+
+bool Cedrus::XIDDevice::IsPropertyCacheBypassed() const
+{
+    return m_bypassPropertyCache;
+}
+
+void Cedrus::XIDDevice::ClearPropertyCache()
+{
+    m_propertyCache.clear();
+    m_committedLineMappingCRCKnown = false;
+    m_firmwareCapabilitiesKnown = false;
+    // The device may have been re-flashed since.
+    m_minorFwVerKnown = false;
+}
+
+bool Cedrus::XIDDevice::Supports(XidCommand command) const
+{
+    if (!DeviceCapabilities::DependsOnFirmwareVersion(command))
+        return m_capabilities.Supports(command);
+
+    // Devices whose config rules these out aren't worth asking.
+    if (!DeviceCapabilities::DependsOnFirmwareVersion(*m_config))
+        return false;
+
+    if (!m_firmwareCapabilitiesKnown)
+    {
+        m_firmwareCapabilities = DeviceCapabilities(*m_config, m_config->GetModelID(), CurrentMinorFirmwareVersion());
+        m_firmwareCapabilitiesKnown = true;
+    }
+
+    return m_firmwareCapabilities.Supports(command);
+}
+
+void Cedrus::XIDDevice::UpdateCapabilities()
+{
+    // Detection only accepts exact matches, so the config's model is the
+    // device's wherever the model matters.
+    m_capabilities = DeviceCapabilities(*m_config, m_config->GetModelID(), 0);
+    m_firmwareCapabilitiesKnown = false;
+}
+
+void Cedrus::XIDDevice::SetFlashCommitVerification(bool verify)
+{
+    m_verifyFlashCommits = verify;
+}
+
+unsigned int Cedrus::XIDDevice::GetPropertyCacheHits() const
+{
+    return m_propertyCacheHits;
+}
+
+unsigned int Cedrus::XIDDevice::GetPropertyCacheMisses() const
+{
+    return m_propertyCacheMisses;
+}
+
+bool Cedrus::XIDDevice::StartAcquisition(std::chrono::microseconds maxLatency)
+{
+    if (!m_ResponseMgr)
+        return false;
+
+    const std::shared_ptr<Connection> xid_con = m_xidCon;
+    const std::shared_ptr<ResponseManager> response_mgr = m_ResponseMgr;
+
+    return m_acquisition->Start([xid_con, response_mgr]() { response_mgr->CheckForKeypress(xid_con); },
+        response_mgr, maxLatency);
+}
+
+void Cedrus::XIDDevice::StopAcquisition()
+{
+    m_acquisition->Stop();
+}
+
+void Cedrus::XIDDevice::PauseAcquisition(bool pause)
+{
+    m_acquisition->Pause(pause);
+}
+
+bool Cedrus::XIDDevice::IsAcquiring() const
+{
+    return m_acquisition->IsRunning();
+}
+
+int Cedrus::XIDDevice::AddResponseCallback(ResponseCallback callback)
+{
+    return m_acquisition->AddSubscriber(callback);
+}
+
+bool Cedrus::XIDDevice::RemoveResponseCallback(int callbackID)
+{
+    return m_acquisition->RemoveSubscriber(callbackID);
+}
+
+unsigned long long Cedrus::XIDDevice::GetAcquisitionOverrunCount() const
+{
+    return m_acquisition->GetOverrunCount();
+}
+
 void Cedrus::XIDDevice::PollForResponse() const
 {
-    if (m_ResponseMgr)
+    if (m_ResponseMgr && !m_acquisition->IsRunning())
         m_ResponseMgr->CheckForKeypress(m_xidCon);
 }
 
@@ -1889,6 +2177,96 @@ bool Cedrus::XIDDevice::HasQueuedResponses() const
         return false;
 }
 
+bool Cedrus::XIDDevice::WaitForResponse(std::chrono::milliseconds timeout) const
+{
+    if (!m_ResponseMgr)
+        return false;
+
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+
+    if (m_acquisition->IsRunning())
+        return m_ResponseMgr->WaitForResponse(deadline);
+
+    while (!m_ResponseMgr->HasQueuedResponses())
+    {
+        const long long remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (remaining_ms <= 0)
+            break;
+
+        m_ResponseMgr->WaitForKeypress(m_xidCon, std::chrono::milliseconds(std::min<long long>(remaining_ms, WAIT_READ_SLICE_MS)));
+    }
+
+    return m_ResponseMgr->HasQueuedResponses();
+}
+
+int Cedrus::XIDDevice::WaitForAnyResponse(const std::vector< std::shared_ptr<XIDDevice> > & devices, std::chrono::milliseconds timeout)
+{
+    if (devices.size() == 1)
+        return devices[0]->WaitForResponse(timeout) ? 0 : -1;
+
+    const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+
+    for (;;)
+    {
+        const unsigned long long seen = ResponseManager::GetArrivalCount();
+
+        bool all_acquiring = true;
+        for (size_t i = 0; i < devices.size(); ++i)
+        {
+            devices[i]->PollForResponse();
+            all_acquiring = all_acquiring && (!devices[i]->m_ResponseMgr || devices[i]->IsAcquiring());
+
+            if (devices[i]->HasQueuedResponses())
+                return static_cast<int>(i);
+        }
+
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (now >= deadline)
+            return -1;
+
+        // Acquiring devices wake this as soon as they queue something. The
+        // others are only read by the poll above, so come back for them
+        // shortly.
+        ResponseManager::WaitForArrival(seen, all_acquiring ? deadline :
+            std::min(deadline, now + std::chrono::milliseconds(WAIT_POLL_INTERVAL_MS)));
+    }
+}
+
+int Cedrus::XIDDevice::GetResponseReadyFd()
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetReadyFd();
+    else
+        return -1;
+}
+
+void Cedrus::XIDDevice::EnableResponseLatencyTracking(bool enable)
+{
+    if (m_ResponseMgr)
+        m_ResponseMgr->EnableLatencyTracking(enable);
+}
+
+Cedrus::LatencyHistogram Cedrus::XIDDevice::GetResponseLatency(ResponseLatencyStage stage) const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetLatencyHistogram(stage);
+    else
+        return LatencyHistogram();
+}
+
+void Cedrus::XIDDevice::ResetResponseLatency()
+{
+    if (m_ResponseMgr)
+        m_ResponseMgr->ResetLatencyHistograms();
+}
+
+void Cedrus::XIDDevice::WriteResponseLatencyCsv(std::ostream & out) const
+{
+    if (m_ResponseMgr)
+        m_ResponseMgr->WriteLatencyCsv(out);
+}
+
 unsigned int Cedrus::XIDDevice::GetNumberOfKeysDown() const
 {
     if (m_ResponseMgr)
@@ -1897,6 +2275,30 @@ unsigned int Cedrus::XIDDevice::GetNumberOfKeysDown() const
         return 0;
 }
 
+bool Cedrus::XIDDevice::IsKeyDown(int port, int key) const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->IsKeyDown(port, key);
+    else
+        return false;
+}
+
+unsigned long long Cedrus::XIDDevice::GetKeysDownMask(int port) const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetKeysDownMask(port);
+    else
+        return 0;
+}
+
+unsigned long long Cedrus::XIDDevice::GetImpossibleKeyTransitionCount() const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetImpossibleTransitionCount();
+    else
+        return 0;
+}
+
 Cedrus::Response Cedrus::XIDDevice::GetNextResponse() const
 {
     if (m_ResponseMgr)
@@ -1905,6 +2307,14 @@ Cedrus::Response Cedrus::XIDDevice::GetNextResponse() const
         return Response();
 }
 
+size_t Cedrus::XIDDevice::GetResponses(Cedrus::Response * out, size_t maxResponses) const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetResponses(out, maxResponses);
+    else
+        return 0;
+}
+
 void Cedrus::XIDDevice::ClearResponseQueue()
 {
     if (m_ResponseMgr)
@@ -1916,6 +2326,42 @@ void Cedrus::XIDDevice::ClearResponsesFromBuffer()
     m_xidCon->FlushReadFromDeviceBuffer();
 }
 
+void Cedrus::XIDDevice::SetResponseOverflowPolicy(RingOverflowPolicy policy)
+{
+    if (m_ResponseMgr)
+        m_ResponseMgr->SetOverflowPolicy(policy);
+}
+
+unsigned long long Cedrus::XIDDevice::GetDroppedResponseCount() const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetDroppedResponseCount();
+    else
+        return 0;
+}
+
+void Cedrus::XIDDevice::SetResponseFilter(const ResponseFilter & filter)
+{
+    if (m_ResponseMgr)
+        m_ResponseMgr->SetResponseFilter(filter);
+}
+
+Cedrus::ResponseFilter Cedrus::XIDDevice::GetResponseFilter() const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetResponseFilter();
+    else
+        return ResponseFilter();
+}
+
+unsigned long long Cedrus::XIDDevice::GetFilteredResponseCount() const
+{
+    if (m_ResponseMgr)
+        return m_ResponseMgr->GetFilteredResponseCount();
+    else
+        return 0;
+}
+
 void Cedrus::XIDDevice::SetDigitalOutputLines_RB(std::shared_ptr<Connection> xidCon, unsigned int lines)
 {
     static char set_lines_cmd[3] = { 'a','h' };
@@ -1940,14 +2386,53 @@ void Cedrus::XIDDevice::SetDigitalOutputLines_ST(std::shared_ptr<Connection> xid
 
 void Cedrus::XIDDevice::MatchConfigToModel(char model)
 {
-    m_config = XIDDeviceScanner::GetDeviceScanner().GetConfigForGivenDevice(GetProductID(), model != -1 ? model : GetModelID(), m_config->GetMajorVersion());
+    // Changing the model doesn't change the product, so there's no need to ask.
+    m_config = XIDDeviceScanner::GetDeviceScanner().GetConfigForGivenDevice(m_config->GetProductID(), model != -1 ? model : GetModelID(), m_config->GetMajorVersion());
+    UpdateCapabilities();
     if (model != -1)
+    {
+        const RingOverflowPolicy policy = m_ResponseMgr ? m_ResponseMgr->GetOverflowPolicy() : OVERFLOW_DROP_NEWEST;
+        const ResponseFilter filter = m_ResponseMgr ? m_ResponseMgr->GetResponseFilter() : ResponseFilter();
+        const std::shared_ptr<ReadinessNotifier> readiness = m_ResponseMgr ? m_ResponseMgr->GetReadinessNotifier() : nullptr;
+        const bool track_latency = m_ResponseMgr && m_ResponseMgr->IsLatencyTrackingEnabled();
+
+        // The acquisition thread holds on to the old manager, so move it over.
+        const bool was_acquiring = m_acquisition->IsRunning();
+        m_acquisition->Stop();
+
         m_ResponseMgr.reset(m_config->IsInputDevice() ? new ResponseManager(m_config) : nullptr);
+        if (m_ResponseMgr)
+        {
+            m_ResponseMgr->SetOverflowPolicy(policy);
+            m_ResponseMgr->SetResponseFilter(filter);
+            m_ResponseMgr->SetReadinessNotifier(readiness);
+            m_ResponseMgr->EnableLatencyTracking(track_latency);
+            m_ResponseMgr->SetDeviceClockModel(m_deviceClock);
+        }
+
+        if (was_acquiring)
+            StartAcquisition(m_acquisition->GetMaxLatency());
+    }
 }
 
 void Cedrus::XIDDevice::MatchConfigToModel_MPod(char model)
 {
-    m_config = XIDDeviceScanner::GetDeviceScanner().GetConfigForGivenDevice(GetProductID(), model != -1 ? model : GetModelID(), m_config->GetMajorVersion());
+    // Without a model, this follows a pod switch and the product has to be queried.
+    const int product_id = model != -1 ? m_config->GetProductID() : GetProductID();
+
+    m_config = XIDDeviceScanner::GetDeviceScanner().GetConfigForGivenDevice(product_id, model != -1 ? model : GetModelID(), m_config->GetMajorVersion());
+    UpdateCapabilities();
+}
+
+unsigned int Cedrus::XIDDevice::CurrentMinorFirmwareVersion() const
+{
+    if (!m_minorFwVerKnown)
+    {
+        m_curMinorFwVer = GetMinorFirmwareVersion();
+        m_minorFwVerKnown = true;
+    }
+
+    return m_curMinorFwVer;
 }
 
 void Cedrus::XIDDevice::SetMPodLineMapping_Neuroscan16bit()
@@ -2063,3 +2548,374 @@ void Cedrus::XIDDevice::SetCPodLineMapping_NeuroscanGrael()
     MapSignals(15, 128);
     CommitLineMappingToFlash();
 }
+
+unsigned int Cedrus::XIDDevice::QueryProperty(const char query[], unsigned int querySize, unsigned char reply[], unsigned int replySize, unsigned int minReplySize) const
+{
+    // Some queries are sent with a trailing null, which isn't part of the command.
+    std::string key(query, querySize);
+    key.erase(key.find_last_not_of('\0') + 1);
+
+    const unsigned int cached_size = FindCachedProperty(key, reply, replySize);
+    if (cached_size > 0)
+        return cached_size;
+
+    const DWORD bytes_read = m_xidCon->SendXIDCommand(query, querySize, reply, replySize);
+
+    // A short reply means the device didn't answer in time.
+    if (bytes_read > 0 && bytes_read >= (minReplySize > 0 ? minReplySize : replySize))
+        m_propertyCache[key] = std::string((char*)reply, bytes_read);
+
+    return bytes_read;
+}
+
+unsigned int Cedrus::XIDDevice::FindCachedProperty(const std::string & key, unsigned char reply[], unsigned int replySize) const
+{
+    const std::map<std::string, std::string>::const_iterator cached =
+        m_bypassPropertyCache ? m_propertyCache.end() : m_propertyCache.find(key);
+
+    if (cached == m_propertyCache.end() || cached->second.size() > replySize)
+    {
+        ++m_propertyCacheMisses;
+        return 0;
+    }
+
+    ++m_propertyCacheHits;
+
+    memset(reply, 0x00, replySize);
+    memcpy(reply, cached->second.data(), cached->second.size());
+
+    return static_cast<unsigned int>(cached->second.size());
+}
+
+void Cedrus::XIDDevice::SettleAfterSetting()
+{
+    if (m_deferFlashSettling)
+        m_flashSettlePending = true;
+    else
+        SLEEP_FUNC(50 * SLEEP_INC);
+}
+
+void Cedrus::XIDDevice::WriteSetting(unsigned char command[], unsigned int commandSize, unsigned int querySize, bool savesToFlash)
+{
+    if (savesToFlash && m_deferFlashSettling)
+    {
+        m_flashSettlePending = true;
+        savesToFlash = false;
+    }
+
+    DWORD bytes_written = 0;
+    m_xidCon->Write(command, commandSize, &bytes_written, savesToFlash);
+
+    // The device answers a query with '_' followed by the command that sets
+    // the same value, so a successful write tells us what the answer is now.
+    const std::string key = "_" + std::string((char*)command, querySize - 1);
+
+    if (bytes_written == commandSize)
+        m_propertyCache[key] = "_" + std::string((char*)command, commandSize);
+    else
+        m_propertyCache.erase(key);
+}
+
+void Cedrus::XIDDevice::ForgetProperty(const std::string & queryPrefix) const
+{
+    std::map<std::string, std::string>::iterator it = m_propertyCache.lower_bound(queryPrefix);
+
+    while (it != m_propertyCache.end() && it->first.compare(0, queryPrefix.size(), queryPrefix) == 0)
+        it = m_propertyCache.erase(it);
+}
+
+void Cedrus::XIDDevice::PrefetchProperties(const std::vector<std::string> & queries, const std::vector<unsigned int> & replySizes) const
+{
+    if (m_bypassPropertyCache)
+        return;
+
+    std::vector<std::string> uncached_queries;
+    std::vector<unsigned int> uncached_reply_sizes;
+
+    for (unsigned int i = 0; i < queries.size(); ++i)
+    {
+        if (m_propertyCache.find(queries[i]) == m_propertyCache.end())
+        {
+            uncached_queries.push_back(queries[i]);
+            uncached_reply_sizes.push_back(replySizes[i]);
+        }
+    }
+
+    if (uncached_queries.empty())
+        return;
+
+    // On failure the getters ask for each setting themselves.
+    std::vector<std::string> replies;
+    if (!m_xidCon->SendXIDCommandBatch(uncached_queries, uncached_reply_sizes, replies))
+        return;
+
+    for (unsigned int i = 0; i < uncached_queries.size(); ++i)
+        m_propertyCache[uncached_queries[i]] = replies[i];
+}
+
+std::string Cedrus::XIDDevice::DefaultInputSelectors() const
+{
+    if (!m_config->IsXID2())
+        return std::string();
+
+    if (m_config->IsStimTracker2Quad())
+        return "ABCD";
+
+    if (m_config->IsStimTracker2Duo())
+        return "AB";
+
+    return "A";
+}
+
+Cedrus::DeviceSettingsSnapshot Cedrus::XIDDevice::GetSettingsSnapshot(const std::string & inputSelectors) const
+{
+    DeviceSettingsSnapshot snapshot;
+    snapshot.inputSelectors = (inputSelectors.empty() ? DefaultInputSelectors() : inputSelectors)
+        .substr(0, DeviceSettingsSnapshot::MAX_INPUT_SELECTORS);
+
+    // _fo reports a switch position, so it's always read live instead.
+    std::vector<std::string> queries;
+    std::vector<unsigned int> reply_sizes;
+    const auto add_query = [&](XidCommand command, const std::string & query, unsigned int replySize)
+    {
+        if (Supports(command))
+        {
+            queries.push_back(query);
+            reply_sizes.push_back(replySize);
+        }
+    };
+
+    add_query(CMD_OUTPUT_LOGIC, "_a0", 4);
+    add_query(CMD_ACCESSORY_CONNECTOR_MODE, "_a1", 4);
+    add_query(CMD_AC_DEBOUNCING_TIME, "_a6", 4);
+    add_query(CMD_MPOD_OUTPUT_ENABLE, "_ae", 4);
+    add_query(CMD_MPOD_OUTPUT_MODE, "_am", 4);
+    add_query(CMD_TRANSLATION_TABLE, "_as", 4);
+    add_query(CMD_MPOD_PULSE_DURATION, "_aw", 4);
+    add_query(CMD_POD_OUTPUT_LOGIC, "_al", 4);
+    add_query(CMD_TRIGGER_DEFAULT, "_f4", 4);
+    add_query(CMD_TRIGGER_DEBOUNCE_TIME, "_f5", 4);
+    add_query(CMD_BUTTON_DEBOUNCE_TIME, "_f6", 4);
+    add_query(CMD_KB_AUTOREPEAT, "_ig", 4);
+    add_query(CMD_LED_FUNCTION, "_il", 4);
+    add_query(CMD_OUTPUT_PAUSE, "_ip", 4);
+    add_query(CMD_MIXED_INPUT_MODE, "_iv", 4);
+    add_query(CMD_NUMBER_OF_LINES, "_ml", 4);
+    add_query(CMD_PULSE_DURATION, "_mp", 7);
+    add_query(CMD_VOLTAGE_RANGE, "_vr", 5);
+    add_query(CMD_VOLTAGE_RANGE, "_vt", 5);
+    add_query(CMD_ANALOG_OUTPUT_MODE, "_vm", 4);
+    add_query(CMD_ANALOG_OUTPUT_LEVELS, "_vl", 4);
+
+    for (char selector : snapshot.inputSelectors)
+    {
+        add_query(CMD_SINGLE_SHOT_MODE, std::string("_ia") + selector, 9);
+        add_query(CMD_SIGNAL_FILTER, std::string("_if") + selector, 12);
+        add_query(CMD_DIGITAL_OUTPUT, std::string("_io") + selector, 5);
+        add_query(CMD_TIMER_RESET_ON_ONSET, std::string("_ir") + selector, 5);
+        add_query(CMD_ANALOG_INPUT_THRESHOLD, std::string("_it") + selector, 5);
+
+        // GetEnableUSBOutput answers for these without asking.
+        if (!m_config->IsCPodWithInput())
+            add_query(CMD_USB_OUTPUT, std::string("_iu") + selector, 5);
+    }
+
+    PrefetchProperties(queries, reply_sizes);
+
+    if (Supports(CMD_OUTPUT_LOGIC))
+        snapshot.outputLogic = GetOutputLogic();
+    if (Supports(CMD_ACCESSORY_CONNECTOR_MODE))
+        snapshot.accessoryConnectorMode = GetAccessoryConnectorMode();
+    if (Supports(CMD_AC_DEBOUNCING_TIME))
+        snapshot.acDebouncingTime = GetACDebouncingTime();
+    if (Supports(CMD_MPOD_OUTPUT_ENABLE))
+        snapshot.mpodOutputEnabled = IsMpodOutputEnabled();
+    if (Supports(CMD_MPOD_OUTPUT_MODE))
+        snapshot.mpodOutputMode = GetMpodOutputMode();
+    if (Supports(CMD_TRANSLATION_TABLE))
+        snapshot.translationTable = GetTranslationTable();
+    if (Supports(CMD_MPOD_PULSE_DURATION))
+        snapshot.mpodPulseDuration = GetMpodPulseDuration();
+    if (Supports(CMD_POD_OUTPUT_LOGIC))
+        snapshot.podOutputLogic = (unsigned char)GetPodOutputLogic();
+
+    if (Supports(CMD_TRIGGER_DEFAULT))
+        snapshot.triggerDefault = GetTriggerDefault();
+    if (Supports(CMD_TRIGGER_DEBOUNCE_TIME))
+        snapshot.triggerDebounceTime = GetTriggerDebounceTime();
+    if (Supports(CMD_BUTTON_DEBOUNCE_TIME))
+        snapshot.buttonDebounceTime = GetButtonDebounceTime();
+    if (Supports(CMD_OPTICAL_ISOLATION_SWITCH))
+        snapshot.opticalIsolationSwitch = IsOpticalIsolationSwitchOn();
+
+    if (Supports(CMD_KB_AUTOREPEAT))
+        snapshot.kbAutorepeat = IsKbAutorepeatOn();
+    if (Supports(CMD_LED_FUNCTION))
+        snapshot.ledFunction = GetRipondaLEDFunction();
+    if (Supports(CMD_OUTPUT_PAUSE))
+        snapshot.outputPaused = IsOutputPaused();
+    if (Supports(CMD_MIXED_INPUT_MODE))
+        snapshot.mixedInputMode = GetMixedInputMode();
+
+    if (Supports(CMD_NUMBER_OF_LINES))
+        snapshot.numberOfLines = GetNumberOfLines();
+    if (Supports(CMD_PULSE_DURATION))
+        snapshot.pulseDuration = GetPulseDuration();
+
+    if (Supports(CMD_VOLTAGE_RANGE))
+    {
+        snapshot.maxVoltageRange = GetMaxVoltageRange();
+        snapshot.maxVoltageRangeForTesting = GetMaxVoltageRangeForTesting();
+    }
+    if (Supports(CMD_ANALOG_OUTPUT_MODE))
+        snapshot.analogOutputMode = GetAnalogOutputMode();
+    if (Supports(CMD_ANALOG_OUTPUT_LEVELS))
+        snapshot.analogOutputLevels = GetNumberOfAnalogOutputLevels();
+
+    for (unsigned int i = 0; i < snapshot.inputSelectors.size(); ++i)
+    {
+        const unsigned char selector = snapshot.inputSelectors[i];
+
+        if (Supports(CMD_SINGLE_SHOT_MODE))
+        {
+            const SingleShotMode single_shot = GetSingleShotMode(selector);
+            snapshot.singleShotEnabled[i] = single_shot.enabled;
+            snapshot.singleShotDelay[i] = single_shot.delay;
+        }
+
+        if (Supports(CMD_SIGNAL_FILTER))
+        {
+            const SignalFilter filter = GetSignalFilter(selector);
+            snapshot.signalFilterHoldOn[i] = filter.holdOn;
+            snapshot.signalFilterHoldOff[i] = filter.holdOff;
+        }
+
+        if (Supports(CMD_DIGITAL_OUTPUT))
+            snapshot.digitalOutputEnabled[i] = GetEnableDigitalOutput(selector);
+        if (Supports(CMD_TIMER_RESET_ON_ONSET))
+            snapshot.timerResetOnOnset[i] = GetTimerResetOnOnsetMode(selector);
+        if (Supports(CMD_USB_OUTPUT))
+            snapshot.usbOutputEnabled[i] = GetEnableUSBOutput(selector);
+        if (Supports(CMD_ANALOG_INPUT_THRESHOLD))
+            snapshot.analogInputThreshold[i] = GetAnalogInputThreshold(selector);
+    }
+
+    return snapshot;
+}
+
+Cedrus::SettingsProfileResult Cedrus::XIDDevice::ApplySettingsProfile(const DeviceSettingsSnapshot & profile)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    const DeviceSettingsSnapshot current = GetSettingsSnapshot(profile.inputSelectors);
+    DeviceSettingsSnapshot target = MergeSettingsSnapshots(current, profile);
+    // This is a physical switch, it can only be read.
+    target.opticalIsolationSwitch = current.opticalIsolationSwitch;
+
+    SettingsProfileResult result;
+
+    if (DiffSettingsSnapshots(current, target).empty())
+    {
+        result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        return result;
+    }
+
+    m_deferFlashSettling = true;
+    m_flashSettlePending = false;
+
+    if (target.outputLogic != current.outputLogic)
+        SetOutputLogic((unsigned char)target.outputLogic);
+    if (target.accessoryConnectorMode != current.accessoryConnectorMode)
+        SetAccessoryConnectorMode((unsigned char)target.accessoryConnectorMode);
+    if (target.acDebouncingTime != current.acDebouncingTime)
+        SetACDebouncingTime((unsigned char)target.acDebouncingTime);
+    if (target.mpodOutputEnabled != current.mpodOutputEnabled)
+        EnableMpodOutput(target.mpodOutputEnabled != 0);
+    if (target.mpodOutputMode != current.mpodOutputMode)
+        SetMpodOutputMode((unsigned char)target.mpodOutputMode);
+    if (target.translationTable != current.translationTable)
+        SetTranslationTable((unsigned char)target.translationTable);
+    if (target.mpodPulseDuration != current.mpodPulseDuration)
+        SetMpodPulseDuration((unsigned char)target.mpodPulseDuration);
+    if (target.podOutputLogic != current.podOutputLogic)
+        SetPodOutputLogic((char)target.podOutputLogic);
+
+    if (target.triggerDefault != current.triggerDefault)
+        SetTriggerDefault(target.triggerDefault != 0);
+    if (target.triggerDebounceTime != current.triggerDebounceTime)
+        SetTriggerDebounceTime((unsigned char)target.triggerDebounceTime);
+    if (target.buttonDebounceTime != current.buttonDebounceTime)
+        SetButtonDebounceTime((unsigned char)target.buttonDebounceTime);
+
+    if (target.kbAutorepeat != current.kbAutorepeat)
+        EnableKbAutorepeat(target.kbAutorepeat != 0);
+    if (target.ledFunction != current.ledFunction)
+        SetRipondaLEDFunction((unsigned int)target.ledFunction);
+    // PauseAllOutput() sends the opposite of what IsOutputPaused() reads
+    // back, so this asks for whatever makes IsOutputPaused() match.
+    if (target.outputPaused != current.outputPaused)
+        PauseAllOutput(target.outputPaused == 0);
+    if (target.mixedInputMode != current.mixedInputMode)
+        SetMixedInputMode((unsigned char)target.mixedInputMode);
+
+    if (target.numberOfLines != current.numberOfLines)
+        SetNumberOfLines((unsigned int)target.numberOfLines);
+    if (target.pulseDuration != current.pulseDuration)
+        SetPulseDuration((unsigned int)target.pulseDuration);
+
+    if (target.maxVoltageRange != current.maxVoltageRange)
+        SetVoltageRange(0, (unsigned int)target.maxVoltageRange);
+    if (target.maxVoltageRangeForTesting != current.maxVoltageRangeForTesting)
+        SetVoltageRangeForTesting(0, (unsigned int)target.maxVoltageRangeForTesting);
+    if (target.analogOutputMode != current.analogOutputMode)
+        SetAnalogOutputMode((unsigned int)target.analogOutputMode);
+    if (target.analogOutputLevels != current.analogOutputLevels)
+        SetNumberOfAnalogOutputLevels((unsigned int)target.analogOutputLevels);
+
+    for (unsigned int i = 0; i < current.inputSelectors.size(); ++i)
+    {
+        const unsigned char selector = current.inputSelectors[i];
+
+        if (target.singleShotEnabled[i] != current.singleShotEnabled[i] ||
+            target.singleShotDelay[i] != current.singleShotDelay[i])
+        {
+            SetSingleShotMode(selector, target.singleShotEnabled[i] != 0, (unsigned int)target.singleShotDelay[i]);
+        }
+
+        if (target.signalFilterHoldOn[i] != current.signalFilterHoldOn[i] ||
+            target.signalFilterHoldOff[i] != current.signalFilterHoldOff[i])
+        {
+            SetSignalFilter(selector, (unsigned int)target.signalFilterHoldOn[i], (unsigned int)target.signalFilterHoldOff[i]);
+        }
+
+        if (target.digitalOutputEnabled[i] != current.digitalOutputEnabled[i])
+            SetEnableDigitalOutput(selector, target.digitalOutputEnabled[i] != 0);
+        if (target.timerResetOnOnset[i] != current.timerResetOnOnset[i])
+            SetTimerResetOnOnsetMode(selector, (unsigned char)target.timerResetOnOnset[i]);
+        if (target.usbOutputEnabled[i] != current.usbOutputEnabled[i])
+            SetEnableUSBOutput(selector, target.usbOutputEnabled[i] != 0);
+        if (target.analogInputThreshold[i] != current.analogInputThreshold[i])
+            SetAnalogInputThreshold(selector, (unsigned char)target.analogInputThreshold[i]);
+    }
+
+    m_deferFlashSettling = false;
+
+    // One settle period covers every write that needed one.
+    if (m_flashSettlePending)
+        SLEEP_FUNC(100 * SLEEP_INC);
+
+    // CommitLineMappingToFlash() skips the commit when the line mapping
+    // hasn't changed since the last one.
+    const bool settings_saved = SaveSettingsToFlash();
+    const bool line_mapping_saved = !Supports(CMD_LINE_MAPPING_COMMIT) || CommitLineMappingToFlash();
+    result.committedToFlash = settings_saved && line_mapping_saved && !HasLostConnection();
+
+    // Some setters don't apply to every device their getter does, so what
+    // changed is read back from the device rather than from the cache the
+    // writes just filled. It still goes out as one batch.
+    m_propertyCache.clear();
+    result.changes = DiffSettingsSnapshots(current, GetSettingsSnapshot(current.inputSelectors));
+    result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+    return result;
+}
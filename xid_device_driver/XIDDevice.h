@@ -33,8 +33,16 @@
 
 #include "XidDriverImpExpDefs.h"
 #include "ResponseManager.h"
+#include "ResponseAcquisition.h"
+#include "CommandTiming.h"
+#include "DeviceCapabilities.h"
+#include "DeviceClockModel.h"
+#include "DeviceSettingsSnapshot.h"
 
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace Cedrus
 {
@@ -72,7 +80,7 @@ namespace Cedrus
         int GetACDebouncingTime() const; // _a6
         void SetACDebouncingTime(unsigned char time); // a6
         unsigned int GetFlashBackupCRC() const; // _ab (v2.2.2)
-        void BackupFlashData(); // ab (v2.2.2)
+        bool BackupFlashData(); // ab (v2.2.2)
         unsigned int GetTranslationTableCRC() const; // _ac (v2.2.2)
         bool IsMpodOutputEnabled() const; // _ae
         void EnableMpodOutput(bool enable); // ae
@@ -85,10 +93,10 @@ namespace Cedrus
         unsigned int GetMappedSignals(unsigned int line); // _at
         void MapSignals(unsigned int line, unsigned int map); // at
         void ResetMappedLinesToDefault(); // atX
-        void CommitLineMappingToFlash(); // af
+        bool CommitLineMappingToFlash(); // af
         bool IsPodLocked() const; // _au (v2.2.2)
         unsigned int GetPodUnlockCRC() const; // _au (v2.2.2)
-        void LockPod(bool lock); // au (v2.2.2)
+        bool LockPod(bool lock); // au (v2.2.2)
         unsigned char GetMpodPulseDuration() const; // _aw
         void SetMpodPulseDuration(unsigned char duration); // aw
         char GetPodOutputLogic() const; // _al
@@ -123,9 +131,17 @@ namespace Cedrus
         unsigned int QueryBaseTimer(); // e3 (XID 1 Only)
         unsigned int QueryRtTimer(); // _e5
         void ResetRtTimer(); // e5
+        // Reads the RT timer (_e5) into the device clock model. Unread
+        // responses are queued first rather than thrown away, so this can be
+        // called at any time during a session.
+        bool SampleDeviceClock();
+        // Maps RT timer time, such as an extendedReactionTime, onto the host
+        // steady clock. Needs two SampleDeviceClock() calls since the last reset.
+        bool DeviceTimeToHostTime(long long deviceTimeMs, std::chrono::steady_clock::time_point & hostTime, std::chrono::microseconds & errorBound) const;
+        const DeviceClockModel & GetDeviceClockModel() const;
 
         void SetBaudRate(unsigned char rate); // f1
-        void GetLockingLevel(); // _f2
+        int GetLockingLevel() const; // _f2
         void SetLockingLevel(unsigned char level); // f2
         void ReprogramFlash(); // f3
         bool GetTriggerDefault() const; // _f4
@@ -135,7 +151,7 @@ namespace Cedrus
         int GetButtonDebounceTime() const; // _f6
         void SetButtonDebounceTime(unsigned char time); // f6
         void RestoreFactoryDefaults(); // f7
-        void SaveSettingsToFlash(); //f9
+        bool SaveSettingsToFlash(); //f9
         unsigned int GetTimeSinceLastOscillatorTest(); // _fa
         void StartOscillatorTest(bool start); // fa
         void SetAdjustmentValue(char adj); // fb
@@ -196,13 +212,117 @@ namespace Cedrus
         int CloseConnection() const;
         bool HasLostConnection() const;
 
+        // How long each query command has taken on this device's connection,
+        // keyed by command (e.g. "_d5").
+        std::map<std::string, CommandTiming> GetCommandTimings() const;
+        void ResetCommandTimings();
+
+        // Whether this device understands a command. Most are worked out from
+        // the config without talking to the device; the few that depend on
+        // the minor firmware version ask for it the first time one of them
+        // is checked. Functions for unsupported commands return at once
+        // without talking to the device.
+        bool Supports(XidCommand command) const;
+
+        // Settings read from the device are remembered until they are changed
+        // through this object, or the device is reset, reconnected or switched
+        // to another pod. While the cache is bypassed every getter asks the
+        // device, and the answers still refresh the cache. Live state such as
+        // timers, raised lines and CRCs is never cached.
+        void SetPropertyCacheBypass(bool bypass);
+        bool IsPropertyCacheBypassed() const;
+        void ClearPropertyCache();
+        unsigned int GetPropertyCacheHits() const;
+        unsigned int GetPropertyCacheMisses() const;
+
+        // BackupFlashData and LockPod compare CRCs (or the lock state) first
+        // and skip the flash write when it would change nothing. With
+        // verification on they also check the result afterwards, and return
+        // false if it isn't what was asked for.
+        // CommitLineMappingToFlash skips the commit when the mapping's CRC
+        // is the one this object last committed. That CRC is only remembered
+        // here, so a commit made by other software since isn't noticed. The
+        // device can't read the committed mapping back, so verification
+        // doesn't cover it; it returns whether the command went out.
+        void SetFlashCommitVerification(bool verify);
+
+        // Reads every setting that applies to this device. The queries that
+        // can't be answered from the property cache go out as one pipelined
+        // batch, falling back to one at a time if the batch fails or the cache
+        // is bypassed. Per-input settings are read for inputSelectors, or for
+        // the device's light sensor inputs when that is empty.
+        DeviceSettingsSnapshot GetSettingsSnapshot(const std::string & inputSelectors = std::string()) const;
+
+        // Brings the device in line with every applicable setting in profile;
+        // NOT_APPLICABLE fields are left alone. Only settings that differ are
+        // written, back to back, and the flash is settled and committed once
+        // at the end instead of after each write, line mapping included.
+        SettingsProfileResult ApplySettingsProfile(const DeviceSettingsSnapshot & profile);
+
+        // Opt-in alternative to polling: a thread of the library's own reads
+        // the device at least once every maxLatency. Responses go to the
+        // callbacks added below if there are any, and to GetNextResponse()
+        // otherwise; don't mix the two. PollForResponse() does nothing while
+        // this runs. Returns false for devices without input.
+        bool StartAcquisition(std::chrono::microseconds maxLatency = std::chrono::milliseconds(2));
+        void StopAcquisition();
+        void PauseAcquisition(bool pause);
+        bool IsAcquiring() const;
+        // Callbacks run on the acquisition thread.
+        int AddResponseCallback(ResponseCallback callback);
+        bool RemoveResponseCallback(int callbackID);
+        unsigned long long GetAcquisitionOverrunCount() const;
+
         // These are for getting button input from an RB
         void PollForResponse() const;
         bool HasQueuedResponses() const;
+        // Sleeps until a response is queued or timeout passes, then returns
+        // HasQueuedResponses(). Instead of spinning on PollForResponse(), it
+        // waits in the driver for bytes, or for the acquisition thread if
+        // that is running. Responses taken by callbacks never get queued.
+        bool WaitForResponse(std::chrono::milliseconds timeout) const;
+        // The index in devices of one with a response queued, or -1 after
+        // timeout. Devices that are acquiring wake this as soon as they
+        // queue something. With more than one device, those that aren't are
+        // polled every millisecond until then.
+        static int WaitForAnyResponse(const std::vector< std::shared_ptr<XIDDevice> > & devices, std::chrono::milliseconds timeout);
+        // A descriptor for epoll and the like that is readable while
+        // responses are queued, or -1 on Windows and for devices without
+        // input. Only StartAcquisition() with no callbacks fills the queue
+        // unprompted. The same descriptor lasts for the life of the device.
+        int GetResponseReadyFd();
+        // Times each response through the driver; see ResponseLatencyStage.
+        // LATENCY_DEVICE_TO_READ needs two or more SampleDeviceClock() calls
+        // since the last ResetRtTimer(); keep calling it now and then.
+        // Tracking stays on across a change of model, but the histograms
+        // start over.
+        void EnableResponseLatencyTracking(bool enable);
+        LatencyHistogram GetResponseLatency(ResponseLatencyStage stage) const;
+        void ResetResponseLatency();
+        void WriteResponseLatencyCsv(std::ostream & out) const;
         unsigned int GetNumberOfKeysDown() const;
+        // See ResponseManager. Ports and keys are as in Response.
+        bool IsKeyDown(int port, int key) const;
+        unsigned long long GetKeysDownMask(int port) const;
+        unsigned long long GetImpossibleKeyTransitionCount() const;
         Cedrus::Response GetNextResponse() const;
+        // Takes up to maxResponses at once; see ResponseManager.
+        size_t GetResponses(Cedrus::Response * out, size_t maxResponses) const;
         void ClearResponseQueue(); // Clear processed responses
         void ClearResponsesFromBuffer(); // Clear characters from the physical buffer
+        // See ResponseManager. The policy survives a change of model.
+        // OVERFLOW_BLOCK only applies while StartAcquisition() runs with no
+        // callbacks; the rest of the time a full queue drops the newest
+        // response, since the same thread would have to drain it. Even then
+        // the acquisition thread waits only briefly, since it keeps commands
+        // from reaching the device while it does.
+        void SetResponseOverflowPolicy(RingOverflowPolicy policy);
+        unsigned long long GetDroppedResponseCount() const;
+        // Keeps unwanted responses out of the queue. Also survives a change
+        // of model; note that the key mask applies to mapped keys.
+        void SetResponseFilter(const ResponseFilter & filter);
+        ResponseFilter GetResponseFilter() const;
+        unsigned long long GetFilteredResponseCount() const;
 
          // mh or ah
         void RaiseLines(unsigned int linesBitmask, bool leaveRemainingLines = false);
@@ -212,10 +332,37 @@ namespace Cedrus
         bool ArePulsesBeingSent() const; // _mx
 
     private:
+        // The longest WaitForResponse() keeps other threads off the port.
+        enum { WAIT_READ_SLICE_MS = 20 };
+        // How often WaitForAnyResponse() reads devices that aren't acquiring.
+        enum { WAIT_POLL_INTERVAL_MS = 1 };
+
         void SetDigitalOutputLines_RB(std::shared_ptr<Connection> xidCon, unsigned int lines);
         void SetDigitalOutputLines_ST(std::shared_ptr<Connection> xidCon, unsigned int lines);
         void MatchConfigToModel(char model);
         void MatchConfigToModel_MPod(char model);
+        void UpdateCapabilities();
+
+        // Queried on first use rather than at construction, so creating a
+        // device doesn't cost a round trip.
+        unsigned int CurrentMinorFirmwareVersion() const;
+
+        // Sends a query, or answers it from the property cache. Replies shorter
+        // than minReplySize (replySize when 0) aren't cached.
+        unsigned int QueryProperty(const char query[], unsigned int querySize, unsigned char reply[], unsigned int replySize, unsigned int minReplySize = 0) const;
+        // Returns the number of bytes copied into reply, 0 on a miss.
+        unsigned int FindCachedProperty(const std::string & key, unsigned char reply[], unsigned int replySize) const;
+        // Writes a setting and caches it as the reply to its query, which is
+        // the first querySize bytes of the reply (e.g. 3 for "_mp", 4 for "_ifA").
+        void WriteSetting(unsigned char command[], unsigned int commandSize, unsigned int querySize, bool savesToFlash = false);
+        // The pause some setters need before the device takes another
+        // command, left to the end while a profile is being applied.
+        void SettleAfterSetting();
+        // Forgets every cached reply whose query starts with queryPrefix.
+        void ForgetProperty(const std::string & queryPrefix) const;
+        // Sends the uncached queries as one batch and caches the replies.
+        void PrefetchProperties(const std::vector<std::string> & queries, const std::vector<unsigned int> & replySizes) const;
+        std::string DefaultInputSelectors() const;
 
         void SetMPodLineMapping_Neuroscan16bit();
         void SetMPodLineMapping_NeuroscanGrael();
@@ -227,7 +374,36 @@ namespace Cedrus
         std::shared_ptr<const DeviceConfig> m_podHostConfig;
         std::shared_ptr<ResponseManager> m_ResponseMgr;
         int m_baudRatePriorToMpod;
-        unsigned int m_curMinorFwVer;
+        mutable unsigned int m_curMinorFwVer;
+        mutable bool m_minorFwVerKnown;
+
+        // Raw replies keyed by query, e.g. "_mp" or "_ifA".
+        mutable std::map<std::string, std::string> m_propertyCache;
+        mutable unsigned int m_propertyCacheHits;
+        mutable unsigned int m_propertyCacheMisses;
+        bool m_bypassPropertyCache;
+
+        // Set while ApplySettingsProfile() is writing; WriteSetting() and
+        // SettleAfterSetting() then leave their delays to the end of the profile.
+        bool m_deferFlashSettling;
+        bool m_flashSettlePending;
+
+        bool m_verifyFlashCommits;
+        // The translation table CRC as of our last line mapping commit.
+        mutable unsigned int m_committedLineMappingCRC;
+        mutable bool m_committedLineMappingCRCKnown;
+
+        // Worked out from the config alone, with no I/O, whenever it changes.
+        DeviceCapabilities m_capabilities;
+        // The few commands that depend on the minor firmware version ask for
+        // it the first time one of them is checked.
+        mutable DeviceCapabilities m_firmwareCapabilities;
+        mutable bool m_firmwareCapabilitiesKnown;
+
+        std::unique_ptr<ResponseAcquisition> m_acquisition;
+        DeviceClockModel m_deviceClock;
+        // Only for SampleDeviceClock(); responses have their own.
+        DeviceTimeline m_clockTimeline;
     };
 
 } // namespace Cedrus
@@ -32,30 +32,39 @@
 #include "XIDDeviceScanner.h"
 
 #include "DeviceConfig.h"
+#include "DeviceConfigImage.h"
 #include "Connection.h"
 
 #include "XIDDevice.h"
 
+#include <algorithm>
+#include <chrono>
+
+// Device configs live in static storage for the lifetime of the program, so
+// they are handed out through shared_ptrs that don't own anything. The
+// aliasing constructor makes that possible without allocating a control block.
+std::shared_ptr<const Cedrus::DeviceConfig> ShareStaticConfig(const Cedrus::DeviceConfig & config)
+{
+    return std::shared_ptr<const Cedrus::DeviceConfig>(std::shared_ptr<const Cedrus::DeviceConfig>(), &config);
+}
+
 std::shared_ptr<Cedrus::XIDDevice> CreateDevice
 (
+    std::shared_ptr<const Cedrus::DeviceConfig> config,
     const int productID, // d2 value
     const int modelID,   // d3 value
     const int majorFirmwareVersion, // d4 value
-    const std::vector<std::shared_ptr<Cedrus::DeviceConfig> > &configCandidates,
     std::shared_ptr<Cedrus::Connection> xidCon
 )
 {
     std::shared_ptr<Cedrus::XIDDevice> result;
 
-    // match the product/model id and firmware version to a devconfig
-    for (unsigned int i = 0; i < configCandidates.size(); ++i)
+    // The lookup falls back to "no model set" for pods, but detection only
+    // accepts devices that match a config exactly.
+    if (config->DoesConfigMatchDevice(productID, modelID, majorFirmwareVersion))
     {
-        if (configCandidates[i]->DoesConfigMatchDevice(productID, modelID, majorFirmwareVersion))
-        {
-            xidCon->SetCmdThroughputLimit(configCandidates[i]->IsXID2());
-            result.reset(new Cedrus::XIDDevice(xidCon, configCandidates[i]));
-            break;
-        }
+        xidCon->SetCmdThroughputLimit(config->IsXID2());
+        result.reset(new Cedrus::XIDDevice(xidCon, config));
     }
 
     return result;
@@ -91,9 +100,10 @@ void LoadCOMPorts(std::vector<DWORD> * availableCOMPorts)
 }
 
 Cedrus::XIDDeviceScanner::XIDDeviceScanner()
+    : m_perPortBudgetMs(0),
+    m_scanDeadlineMs(0),
+    m_detectionCanceled(false)
 {
-    DeviceConfig::PopulateConfigList(m_MasterConfigList);
-    DeviceConfig::CreateInvalidConfig(m_emptyConfig);
 }
 
 Cedrus::XIDDeviceScanner& Cedrus::XIDDeviceScanner::GetDeviceScanner()
@@ -182,6 +192,16 @@ int Cedrus::XIDDeviceScanner::DetectXIDDevices
     std::function< bool(unsigned int) > progressFunction
 )
 {
+    // Only a CancelDetection() made during this scan counts; one that comes
+    // in late for the last scan mustn't stop this one.
+    m_detectionCanceled = false;
+
+    typedef std::chrono::steady_clock scan_clock;
+    const scan_clock::time_point scan_start = scan_clock::now();
+    const scan_clock::time_point no_deadline = scan_clock::time_point::max();
+    const scan_clock::time_point scan_deadline = m_scanDeadlineMs > 0 ?
+        scan_start + std::chrono::milliseconds(m_scanDeadlineMs) : no_deadline;
+
     CheckConnectionsDropDeadOnes();
     OpenAllConnections();
 
@@ -204,6 +224,18 @@ int Cedrus::XIDDeviceScanner::DetectXIDDevices
         const int baud_rate[] = { 115200, 19200, 9600, 57600, 38400 };
         const int num_bauds = sizeof(baud_rate) / sizeof(int);
 
+        // Whichever comes first: this port's budget running out or the whole scan's.
+        scan_clock::time_point port_deadline = scan_deadline;
+        if (m_perPortBudgetMs > 0)
+            port_deadline = std::min(port_deadline, scan_clock::now() + std::chrono::milliseconds(m_perPortBudgetMs));
+
+        // Once either fires, reads come back short, so nothing read after
+        // that point can be trusted to identify a device.
+        auto probe_interrupted = [&]() -> bool
+        {
+            return m_detectionCanceled || scan_clock::now() >= port_deadline;
+        };
+
         // Here we're going to actually connect to a port and send it some signals. Our aim here is to
         // get an XID device's product/device and model IDs.
         for (int i = 0; i < num_bauds && !device_found; ++i)
@@ -213,15 +245,30 @@ int Cedrus::XIDDeviceScanner::DetectXIDDevices
             if (progressFunction)
             {
                 if (progressFunction(current_prog))
-                {
-                    DropEveryConnection();
-                    scanning_canceled = true;
-                    break;
-                }
+                    m_detectionCanceled = true;
+            }
+
+            if (m_detectionCanceled)
+            {
+                DropEveryConnection();
+                scanning_canceled = true;
+                break;
+            }
+
+            // Out of time for this port. Move on to the next one, if the scan
+            // as a whole has any time left.
+            if (scan_clock::now() >= port_deadline)
+            {
+                current_prog += prog_increment * (num_bauds - i - 1);
+                break;
             }
 
             std::shared_ptr<Cedrus::Connection> xid_con(new Connection(*iter, baud_rate[i]));
 
+            xid_con->SetCancelFlag(&m_detectionCanceled);
+            if (port_deadline != no_deadline)
+                xid_con->SetReadDeadline(port_deadline);
+
             if (xid_con->Open() == XID_NO_ERR)
             {
                 // This may seem like a good place to flush, but Open() has taken care of that by now.
@@ -229,6 +276,9 @@ int Cedrus::XIDDeviceScanner::DetectXIDDevices
                 // NOTE THE USAGE OF XIDGlossaryPSTProof IN THIS CODE. IT'S IMPORTANT!
                 std::string info = XIDDevice::GetProtocol_Scan(xid_con);
 
+                if (probe_interrupted())
+                    continue;
+
                 if (info.rfind("_xid", 0) == 0)
                 {
                     device_found = true;
@@ -246,15 +296,26 @@ int Cedrus::XIDDeviceScanner::DetectXIDDevices
                     int model_id = XIDDevice::GetModelID_Scan(xid_con);
                     int major_firmware_version = XIDDevice::GetMajorFirmwareVersion_Scan(xid_con);
 
+                    if (probe_interrupted())
+                    {
+                        device_found = false;
+                        continue;
+                    }
+
                     std::shared_ptr<Cedrus::XIDDevice> matched_dev =
-                        CreateDevice(product_id,
+                        CreateDevice(GetConfigForGivenDevice(product_id, model_id, major_firmware_version),
+                            product_id,
                             model_id,
                             major_firmware_version,
-                            m_MasterConfigList,
                             xid_con);
 
                     if (matched_dev)
                     {
+                        // The connection outlives the scan, so it must stop
+                        // watching the scan's deadline and cancel flag.
+                        xid_con->ClearReadDeadline();
+                        xid_con->SetCancelFlag(nullptr);
+
                         m_Devices.push_back(matched_dev);
 
                         if (mode_changed && reportFunction)
@@ -273,6 +334,17 @@ int Cedrus::XIDDeviceScanner::DetectXIDDevices
     return m_Devices.size();
 }
 
+void Cedrus::XIDDeviceScanner::SetDetectionTimeLimits(unsigned int perPortBudgetMs, unsigned int scanDeadlineMs)
+{
+    m_perPortBudgetMs = perPortBudgetMs;
+    m_scanDeadlineMs = scanDeadlineMs;
+}
+
+void Cedrus::XIDDeviceScanner::CancelDetection()
+{
+    m_detectionCanceled = true;
+}
+
 std::shared_ptr<Cedrus::XIDDevice> Cedrus::XIDDeviceScanner::DeviceConnectionAtIndex(unsigned int i) const
 {
     if (i >= m_Devices.size())
@@ -300,40 +372,58 @@ unsigned int Cedrus::XIDDeviceScanner::DeviceCount() const
     return m_Devices.size();
 }
 
+bool Cedrus::XIDDeviceScanner::LoadDeviceConfigImage(const std::string & imagePath)
+{
+    std::shared_ptr<DeviceConfigImage> image(new DeviceConfigImage());
+
+    if (!image->Load(imagePath))
+        return false;
+
+    m_configImage = image;
+    return true;
+}
+
+void Cedrus::XIDDeviceScanner::UnloadDeviceConfigImage()
+{
+    m_configImage.reset();
+}
+
 std::shared_ptr<const Cedrus::DeviceConfig> Cedrus::XIDDeviceScanner::DevconfigAtIndex(unsigned int i) const
 {
-    if (i >= m_MasterConfigList.size())
+    const unsigned int image_count = m_configImage ? m_configImage->ConfigCount() : 0;
+
+    if (i < image_count)
+        return std::shared_ptr<const DeviceConfig>(m_configImage, m_configImage->ConfigAtIndex(i));
+
+    i -= image_count;
+
+    if (i >= DeviceConfig::BuiltInConfigCount())
         return std::shared_ptr<const DeviceConfig>();
 
-    return m_MasterConfigList[i];
+    return ShareStaticConfig(DeviceConfig::BuiltInConfigAtIndex(i));
 }
 
 unsigned int Cedrus::XIDDeviceScanner::DevconfigCount() const
 {
-    return m_MasterConfigList.size();
+    return (m_configImage ? m_configImage->ConfigCount() : 0) + DeviceConfig::BuiltInConfigCount();
 }
 
 std::shared_ptr<const Cedrus::DeviceConfig> Cedrus::XIDDeviceScanner::GetConfigForGivenDevice(int deviceID, int modelID, int majorFirmwareVer) const
 {
-    std::shared_ptr<const Cedrus::DeviceConfig> config;
+    const DeviceConfig * image_config = m_configImage ?
+        m_configImage->FindConfig(deviceID, modelID, majorFirmwareVer) : nullptr;
 
-    for (unsigned int i = 0; i < m_MasterConfigList.size(); ++i)
-    {
-        if (m_MasterConfigList[i]->DoesConfigMatchDevice(deviceID, modelID, majorFirmwareVer))
-        {
-            config = m_MasterConfigList[i];
-            break;
-        }
-    }
+    // Exact matches first, from the image and then the built-in table, then
+    // the "no model set" fallbacks in the same order.
+    if (image_config != nullptr && image_config->DoesConfigMatchDevice(deviceID, modelID, majorFirmwareVer))
+        return std::shared_ptr<const DeviceConfig>(m_configImage, image_config);
 
-    // The model value didn't match any known pod configs. Give the "no model set" config instead.
-    if (!config)
-    {
-        if (deviceID == XidProductID::MPOD || deviceID == XidProductID::CPOD)
-            config = XIDDeviceScanner::GetDeviceScanner().GetConfigForGivenDevice(deviceID, '0', majorFirmwareVer);
-        else
-            config = m_emptyConfig;
-    }
+    // Pods with an unknown model get the "no model set" config, and anything
+    // else that isn't in either table gets the invalid config.
+    const DeviceConfig & built_in_config = DeviceConfig::FindBuiltInConfig(deviceID, modelID, majorFirmwareVer);
+
+    if (image_config == nullptr || &built_in_config != &DeviceConfig::InvalidConfig())
+        return ShareStaticConfig(built_in_config);
 
-    return config;
+    return std::shared_ptr<const DeviceConfig>(m_configImage, image_config);
 }
@@ -34,6 +34,7 @@
 #include "XidDriverImpExpDefs.h"
 #include "constants.h"
 
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
@@ -45,6 +46,7 @@ namespace Cedrus
     class XIDDevice;
     class StimTracker;
     class DeviceConfig;
+    class DeviceConfigImage;
 
     class CEDRUS_XIDDRIVER_IMPORTEXPORT XIDDeviceScanner
     {
@@ -72,12 +74,31 @@ namespace Cedrus
             std::function< void(std::string) > reportFunction = NULL,
             std::function< bool(unsigned int) > progressFunction = NULL);
 
+        // Bounds how long DetectXIDDevices() may spend on a single port and on
+        // the scan as a whole, in milliseconds. 0 means no limit, which is the
+        // default for both. A port that runs out of time is skipped.
+        void SetDetectionTimeLimits(unsigned int perPortBudgetMs, unsigned int scanDeadlineMs);
+
+        // Can be called from any thread. A scan in progress gives up within a
+        // few milliseconds, including in the middle of a read.
+        void CancelDetection();
+
         std::shared_ptr<XIDDevice> DeviceConnectionAtIndex(unsigned int i) const;
 
         std::shared_ptr<Cedrus::XIDDevice> GetDeviceOfGivenProductID(Cedrus::XidProductID devID) const;
 
         unsigned int DeviceCount() const;
 
+        // Maps a device config image made by DeviceConfigImage::Compile().
+        // Its configs are tried before the built-in ones, which remain the
+        // fallback. Devices and configs already handed out keep the image
+        // they came from alive. Returns false, and keeps whatever image was
+        // loaded before, if the image can't be used.
+        bool LoadDeviceConfigImage(const std::string & imagePath);
+
+        void UnloadDeviceConfigImage();
+
+        // Configs from the loaded image come first, then the built-in ones.
         std::shared_ptr<const DeviceConfig> DevconfigAtIndex(unsigned int i) const;
 
         unsigned int DevconfigCount() const;
@@ -86,7 +107,11 @@ namespace Cedrus
 
     private:
         std::vector<std::shared_ptr<XIDDevice> > m_Devices;
-        std::vector<std::shared_ptr<DeviceConfig> > m_MasterConfigList;
-        std::shared_ptr<DeviceConfig> m_emptyConfig;
+
+        unsigned int m_perPortBudgetMs;
+        unsigned int m_scanDeadlineMs;
+        std::atomic<bool> m_detectionCanceled;
+
+        std::shared_ptr<const DeviceConfigImage> m_configImage;
     };
 } // namespace Cedrus